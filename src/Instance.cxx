@@ -20,10 +20,12 @@
 #include "config.h"
 #include "Instance.hxx"
 #include "Partition.hxx"
+#include "StatusCache.hxx"
 #include "IdleFlags.hxx"
 #include "StateFile.hxx"
 #include "Stats.hxx"
 #include "client/List.hxx"
+#include "client/Thread.hxx"
 #include "input/cache/Manager.hxx"
 
 #ifdef ENABLE_CURL
@@ -191,6 +193,15 @@ Instance::OnRemoteTag(const char *uri, const Tag &tag) noexcept
 
 #endif
 
+void
+Instance::EmitIdle(unsigned mask) noexcept
+{
+	if (mask & StatusCache::IDLE_MASK)
+		++status_version;
+
+	idle_monitor.OrMask(mask);
+}
+
 void
 Instance::OnIdle(unsigned flags) noexcept
 {
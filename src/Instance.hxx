@@ -46,10 +46,12 @@ class Storage;
 class UpdateService;
 #endif
 
+#include <atomic>
 #include <memory>
 #include <list>
 
 class ClientList;
+class ClientThreadList;
 struct Partition;
 class StateFile;
 class RemoteTagCache;
@@ -127,6 +129,23 @@ struct Instance final
 	std::unique_ptr<RemoteTagCache> remote_tag_cache;
 #endif
 
+	/**
+	 * Incremented by EmitIdle() for all events which may
+	 * invalidate a #StatusCache.  Events are delivered to the
+	 * partitions asynchronously, but the caches must be
+	 * invalidated right away.
+	 *
+	 * This is declared before #client_threads, because the
+	 * client threads read it.
+	 */
+	std::atomic_uint status_version{0};
+
+	/**
+	 * The threads which perform the socket I/O of clients.  This
+	 * must be destroyed after #client_list.
+	 */
+	std::unique_ptr<ClientThreadList> client_threads;
+
 	std::unique_ptr<ClientList> client_list;
 
 	std::list<Partition> partitions;
@@ -152,9 +171,7 @@ struct Instance final
 	 *
 	 * This method can be called from any thread.
 	 */
-	void EmitIdle(unsigned mask) noexcept {
-		idle_monitor.OrMask(mask);
-	}
+	void EmitIdle(unsigned mask) noexcept;
 
 	/**
 	 * Notify the #Instance that the state has been modified, and
@@ -29,6 +29,7 @@
 #include "Listen.hxx"
 #include "client/Config.hxx"
 #include "client/List.hxx"
+#include "client/Thread.hxx"
 #include "command/AllCommands.hxx"
 #include "Partition.hxx"
 #include "tag/Config.hxx"
@@ -45,6 +46,7 @@
 #include "playlist/PlaylistRegistry.hxx"
 #include "zeroconf/ZeroconfGlue.hxx"
 #include "decoder/DecoderList.hxx"
+#include "decoder/SeekIndexCache.hxx"
 #include "pcm/AudioParser.hxx"
 #include "pcm/Convert.hxx"
 #include "unix/SignalHandlers.hxx"
@@ -59,8 +61,10 @@
 #include "config/Option.hxx"
 #include "config/Domain.hxx"
 #include "config/Parser.hxx"
+#include "io/uring/Features.h"
 #include "util/RuntimeError.hxx"
 #include "util/ScopeExit.hxx"
+#include "util/StringAPI.hxx"
 
 #ifdef ENABLE_DAEMON
 #include "unix/Daemon.hxx"
@@ -76,6 +80,9 @@
 #ifdef ENABLE_INOTIFY
 #include "db/update/InotifyUpdate.hxx"
 #endif
+#ifdef ENABLE_FANOTIFY
+#include "db/update/FanotifyUpdate.hxx"
+#endif
 #endif
 
 #ifdef ENABLE_NEIGHBOR_PLUGINS
@@ -242,13 +249,14 @@ InitDatabaseAndStorage(Instance &instance, const ConfigData &config)
  * Configure and initialize the sticker subsystem.
  */
 static std::unique_ptr<StickerDatabase>
-LoadStickerDatabase(const ConfigData &config)
+LoadStickerDatabase(EventLoop &event_loop, const ConfigData &config)
 {
 	auto sticker_file = config.GetPath(ConfigOption::STICKER_FILE);
 	if (sticker_file.IsNull())
 		return nullptr;
 
-	return std::make_unique<StickerDatabase>(std::move(sticker_file));
+	return std::make_unique<StickerDatabase>(event_loop,
+						 std::move(sticker_file));
 }
 
 #endif
@@ -329,10 +337,47 @@ initialize_decoder_and_player(Instance &instance,
 	});
 }
 
+#ifdef ENABLE_INOTIFY
+
+static void
+InitAutoUpdate(Instance &instance, const ConfigData &config)
+{
+	const unsigned max_depth =
+		config.GetUnsigned(ConfigOption::AUTO_UPDATE_DEPTH, INT_MAX);
+
+	const char *method =
+		config.GetString(ConfigOption::AUTO_UPDATE_METHOD, "inotify");
+	if (StringIsEqual(method, "fanotify")) {
+#ifdef ENABLE_FANOTIFY
+		if (mpd_fanotify_init(instance.event_loop,
+				      *instance.storage, *instance.update,
+				      max_depth))
+			return;
+
+		LogWarning(config_domain,
+			   "fanotify is not available, falling back to inotify");
+#else
+		LogWarning(config_domain,
+			   "fanotify support was disabled at compile time, falling back to inotify");
+#endif
+	} else if (!StringIsEqual(method, "inotify"))
+		throw FormatRuntimeError("Unsupported auto_update_method: %s",
+					 method);
+
+	mpd_inotify_init(instance.event_loop,
+			 *instance.storage, *instance.update,
+			 max_depth);
+}
+
+#endif
+
 inline void
 Instance::BeginShutdownUpdate() noexcept
 {
 #ifdef ENABLE_DATABASE
+#ifdef ENABLE_FANOTIFY
+	mpd_fanotify_finish();
+#endif
 #ifdef ENABLE_INOTIFY
 	mpd_inotify_finish();
 #endif
@@ -398,6 +443,20 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 		raw_config.GetPositive(ConfigOption::MAX_CONN, 100);
 	instance.client_list = std::make_unique<ClientList>(max_clients);
 
+	const bool client_io_uring =
+		raw_config.GetBool(ConfigOption::CLIENT_IO_URING, false);
+#ifndef HAVE_URING
+	if (client_io_uring)
+		LogWarning(config_domain,
+			   "io_uring support is disabled, ignoring \"client_io_uring\"");
+#endif
+
+	instance.client_threads =
+		std::make_unique<ClientThreadList>(instance.event_loop,
+						   raw_config.GetUnsigned(ConfigOption::CLIENT_THREADS,
+									  0),
+						   client_io_uring);
+
 	const auto *input_cache_config = raw_config.GetBlock(ConfigBlockOption::INPUT_CACHE);
 	if (input_cache_config != nullptr) {
 		const InputCacheConfig c(*input_cache_config);
@@ -421,7 +480,8 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 	glue_mapper_init(raw_config);
 
 	initPermissions(raw_config);
-	spl_global_init(raw_config);
+	spl_global_init(instance.event_loop, raw_config);
+	AtScopeExit() { spl_global_finish(); };
 #ifdef ENABLE_ARCHIVE
 	const ScopeArchivePluginsInit archive_plugins_init;
 #endif
@@ -429,13 +489,15 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 	pcm_convert_global_init(raw_config);
 
 	const ScopeDecoderPluginsInit decoder_plugins_init(raw_config);
+	const ScopeSeekIndexCacheInit seek_index_cache_init(raw_config);
 
 #ifdef ENABLE_DATABASE
 	const bool create_db = InitDatabaseAndStorage(instance, raw_config);
 #endif
 
 #ifdef ENABLE_SQLITE
-	instance.sticker_database = LoadStickerDatabase(raw_config);
+	instance.sticker_database = LoadStickerDatabase(instance.event_loop,
+							raw_config);
 #endif
 
 	command_init();
@@ -465,6 +527,7 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 
 	instance.io_thread.Start();
 	instance.rtio_thread.Start();
+	instance.client_threads->Start();
 
 #ifdef ENABLE_NEIGHBOR_PLUGINS
 	if (instance.neighbors != nullptr)
@@ -493,11 +556,7 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 #ifdef ENABLE_INOTIFY
 		if (instance.storage != nullptr &&
 		    instance.update != nullptr)
-			mpd_inotify_init(instance.event_loop,
-					 *instance.storage,
-					 *instance.update,
-					 raw_config.GetUnsigned(ConfigOption::AUTO_UPDATE_DEPTH,
-								INT_MAX));
+			InitAutoUpdate(instance, raw_config);
 #else
 		FormatWarning(config_domain,
 			      "inotify: auto_update was disabled. enable during compilation phase");
@@ -508,7 +567,7 @@ MainConfigured(const struct options &options, const ConfigData &raw_config)
 	Check(raw_config);
 
 	/* enable all audio outputs (if not already done by
-	   playlist_state_restore() */
+	   PlaylistStateLoader::Finish() */
 	for (auto &partition : instance.partitions)
 		partition.pc.LockUpdateAudio();
 
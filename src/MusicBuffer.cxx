@@ -33,6 +33,26 @@ MusicBuffer::Allocate() noexcept
 	return MusicChunkPtr(buffer.Allocate(), MusicChunkDeleter(*this));
 }
 
+MusicChunkPtr
+MusicBuffer::AllocateList(unsigned n) noexcept
+{
+	MusicChunkPtr head;
+	MusicChunkPtr *tail_r = &head;
+
+	const std::lock_guard<Mutex> protect(mutex);
+
+	for (; n > 0; --n) {
+		auto *chunk = buffer.Allocate();
+		if (chunk == nullptr)
+			break;
+
+		*tail_r = MusicChunkPtr(chunk, MusicChunkDeleter(*this));
+		tail_r = &chunk->next;
+	}
+
+	return head;
+}
+
 void
 MusicBuffer::Return(MusicChunk *chunk) noexcept
 {
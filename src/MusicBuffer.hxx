@@ -77,6 +77,16 @@ public:
 	 */
 	MusicChunkPtr Allocate() noexcept;
 
+	/**
+	 * Allocates up to the specified number of chunks with only
+	 * one mutex lock.  The chunks are linked with
+	 * #MusicChunk::next.
+	 *
+	 * @return the first chunk or nullptr if there are no chunks
+	 * available
+	 */
+	MusicChunkPtr AllocateList(unsigned n) noexcept;
+
 	/**
 	 * Returns a chunk to the buffer.  It can be reused by
 	 * Allocate() then.
@@ -98,3 +98,36 @@ MusicPipe::Push(MusicChunkPtr chunk) noexcept
 
 	++size;
 }
+
+void
+MusicPipe::Push(MusicChunkPtr first, MusicChunk &last, unsigned n) noexcept
+{
+	assert(first != nullptr);
+	assert(n > 0);
+	assert(!last.next);
+
+	const std::lock_guard<Mutex> protect(mutex);
+
+#ifndef NDEBUG
+	unsigned n_chunks = 0;
+	for (const MusicChunk *i = first.get(); i != nullptr;
+	     i = i->next.get()) {
+		assert(!i->IsEmpty());
+		assert(i->length == 0 || i->audio_format.IsValid());
+		assert(!audio_format.IsDefined() ||
+		       i->CheckFormat(audio_format));
+
+		if (!audio_format.IsDefined() && i->length > 0)
+			audio_format = i->audio_format;
+
+		++n_chunks;
+	}
+
+	assert(n_chunks == n);
+#endif
+
+	*tail_r = std::move(first);
+	tail_r = &last.next;
+
+	size += n;
+}
@@ -97,6 +97,15 @@ public:
 	 */
 	void Push(MusicChunkPtr chunk) noexcept;
 
+	/**
+	 * Pushes a list of chunks (linked with #MusicChunk::next) to
+	 * the tail of the pipe, locking the mutex only once.
+	 *
+	 * @param last the last chunk of the list
+	 * @param n the number of chunks in the list
+	 */
+	void Push(MusicChunkPtr first, MusicChunk &last, unsigned n) noexcept;
+
 	/**
 	 * Returns the number of chunks currently in this pipe.
 	 */
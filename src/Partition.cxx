@@ -22,6 +22,8 @@
 #include "Instance.hxx"
 #include "Log.hxx"
 #include "song/DetachedSong.hxx"
+#include "playlist/PlaylistSong.hxx"
+#include "SongLoader.hxx"
 #include "mixer/Volume.hxx"
 #include "IdleFlags.hxx"
 #include "client/Listener.hxx"
@@ -31,6 +33,11 @@
 
 static constexpr Domain cache_domain("cache");
 
+/**
+ * The number of songs resolved by one OnResolveTimer() call.
+ */
+static constexpr unsigned RESOLVE_BATCH = 256;
+
 Partition::Partition(Instance &_instance,
 		     const char *_name,
 		     unsigned max_length,
@@ -42,18 +49,26 @@ Partition::Partition(Instance &_instance,
 	 listener(new ClientListener(instance.event_loop, *this)),
 	 idle_monitor(instance.event_loop, BIND_THIS_METHOD(OnIdleMonitor)),
 	 global_events(instance.event_loop, BIND_THIS_METHOD(OnGlobalEvent)),
+	 resolve_timer(instance.event_loop, BIND_THIS_METHOD(OnResolveTimer)),
 	 playlist(max_length, *this),
 	 outputs(pc, *this),
 	 pc(*this, outputs,
 	    instance.input_cache.get(),
 	    buffer_chunks,
-	    configured_audio_format, replay_gain_config)
+	    configured_audio_format, replay_gain_config),
+	 status_cache(instance.status_version)
 {
 	UpdateEffectiveReplayGainMode();
 }
 
 Partition::~Partition() noexcept = default;
 
+unsigned
+Partition::GetStatusVersion() const noexcept
+{
+	return status_cache.shared->GetVersion();
+}
+
 void
 Partition::BeginShutdown() noexcept
 {
@@ -183,6 +198,35 @@ Partition::OnQueueSongStarted() noexcept
 	EmitIdle(IDLE_PLAYER);
 }
 
+bool
+Partition::OnQueueResolveSong(DetachedSong &song) noexcept
+{
+#ifdef ENABLE_DATABASE
+	const SongLoader loader(instance.GetDatabase(), instance.storage);
+#else
+	const SongLoader loader(nullptr, nullptr);
+#endif
+
+	return playlist_check_translate_song(song, {}, loader);
+}
+
+void
+Partition::ResolveQueueLater() noexcept
+{
+	if (playlist.queue.HasUnresolved())
+		resolve_timer.Schedule({});
+}
+
+void
+Partition::OnResolveTimer() noexcept
+{
+	if (playlist.ResolveSongs(pc, RESOLVE_BATCH))
+		/* not an IdleEvent or a zero timeout, because those
+		   would run again before the EventLoop polls the
+		   client sockets */
+		resolve_timer.Schedule(std::chrono::milliseconds(1));
+}
+
 void
 Partition::OnPlayerSync() noexcept
 {
@@ -201,6 +245,12 @@ Partition::OnBorderPause() noexcept
 	EmitGlobalEvent(BORDER_PAUSE);
 }
 
+void
+Partition::OnPlayerStatusModified() noexcept
+{
+	status_cache.Invalidate();
+}
+
 void
 Partition::OnMixerVolumeChanged(Mixer &, int) noexcept
 {
@@ -215,8 +265,7 @@ Partition::OnIdleMonitor(unsigned mask) noexcept
 {
 	/* send "idle" notifications to all subscribed
 	   clients */
-	for (auto &client : clients)
-		client.IdleAdd(mask);
+	idle_clients.Emit(mask);
 
 	if (mask & (IDLE_PLAYLIST|IDLE_PLAYER|IDLE_MIXER|IDLE_OUTPUT))
 		instance.OnStateModified();
@@ -21,6 +21,7 @@
 #define MPD_PARTITION_HXX
 
 #include "event/MaskMonitor.hxx"
+#include "event/FineTimerEvent.hxx"
 #include "queue/Playlist.hxx"
 #include "queue/Listener.hxx"
 #include "output/MultipleOutputs.hxx"
@@ -28,8 +29,10 @@
 #include "player/Control.hxx"
 #include "player/Listener.hxx"
 #include "ReplayGainMode.hxx"
+#include "StatusCache.hxx"
 #include "SingleMode.hxx"
 #include "Chrono.hxx"
+#include "client/IdleList.hxx"
 #include "config.h"
 
 #include <boost/intrusive/list.hpp>
@@ -63,6 +66,12 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 											    boost::intrusive::link_mode<boost::intrusive::normal_link>>>,
 			       boost::intrusive::constant_time_size<false>> clients;
 
+	/**
+	 * The clients of this partition which are waiting in
+	 * "idle".
+	 */
+	ClientIdleList idle_clients;
+
 	/**
 	 * Monitor for idle events local to this partition.
 	 */
@@ -70,6 +79,12 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 
 	MaskMonitor global_events;
 
+	/**
+	 * Resolves songs restored by the #StateFile in small batches
+	 * in the background; see ResolveQueueLater().
+	 */
+	FineTimerEvent resolve_timer;
+
 	struct playlist playlist;
 
 	MultipleOutputs outputs;
@@ -78,6 +93,8 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 
 	ReplayGainMode replay_gain_mode = ReplayGainMode::OFF;
 
+	StatusCache status_cache;
+
 	Partition(Instance &_instance,
 		  const char *_name,
 		  unsigned max_length,
@@ -99,9 +116,17 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 	 * This method can be called from any thread.
 	 */
 	void EmitIdle(unsigned mask) noexcept {
+		status_cache.OnIdle(mask);
 		idle_monitor.OrMask(mask);
 	}
 
+	/**
+	 * Returns a number which changes whenever the cached "status"
+	 * and "currentsong" responses become obsolete.
+	 */
+	gcc_pure
+	unsigned GetStatusVersion() const noexcept;
+
 	/**
 	 * Populate the #InputCacheManager with soon-to-be-played song
 	 * files.
@@ -141,6 +166,14 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 		playlist.StaleSong(pc, uri);
 	}
 
+	/**
+	 * Start resolving the songs which were added to the queue
+	 * without looking them up (see Queue::Item::unresolved).
+	 * This happens in small batches, so clients can be served in
+	 * between.
+	 */
+	void ResolveQueueLater() noexcept;
+
 	void Shuffle(unsigned start, unsigned end) noexcept {
 		playlist.Shuffle(pc, start, end);
 	}
@@ -279,11 +312,13 @@ private:
 	void OnQueueModified() noexcept override;
 	void OnQueueOptionsChanged() noexcept override;
 	void OnQueueSongStarted() noexcept override;
+	bool OnQueueResolveSong(DetachedSong &song) noexcept override;
 
 	/* virtual methods from class PlayerListener */
 	void OnPlayerSync() noexcept override;
 	void OnPlayerTagModified() noexcept override;
 	void OnBorderPause() noexcept override;
+	void OnPlayerStatusModified() noexcept override;
 
 	/* virtual methods from class MixerListener */
 	void OnMixerVolumeChanged(Mixer &mixer, int volume) noexcept override;
@@ -293,6 +328,9 @@ private:
 
 	/* callback for #global_events */
 	void OnGlobalEvent(unsigned mask) noexcept;
+
+	/* callback for #resolve_timer */
+	void OnResolveTimer() noexcept;
 };
 
 #endif
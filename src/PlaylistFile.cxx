@@ -39,19 +39,144 @@
 #include "fs/FileSystem.hxx"
 #include "fs/FileInfo.hxx"
 #include "fs/DirectoryReader.hxx"
+#include "event/CoarseTimerEvent.hxx"
+#include "util/BindMethod.hxx"
 #include "util/StringCompare.hxx"
 #include "util/UriExtract.hxx"
+#include "Log.hxx"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <list>
 
 static const char PLAYLIST_COMMENT = '#';
 
 static unsigned playlist_max_length;
 bool playlist_saveAbsolutePaths = DEFAULT_PLAYLIST_SAVE_ABSOLUTE_PATHS;
 
+namespace {
+
+/**
+ * A write-back cache of parsed stored playlists.  Edits modify the
+ * cached copy, and the file is rewritten after #FLUSH_DELAY, so a
+ * burst of edits results in only one write.
+ *
+ * All methods must be called from the main thread.
+ */
+class StoredPlaylistCache {
+	/**
+	 * The maximum number of cached playlists.  If the cache is
+	 * full, the least recently used one is evicted.
+	 */
+	static constexpr std::size_t MAX_ITEMS = 16;
+
+	static constexpr Event::Duration FLUSH_DELAY =
+		std::chrono::seconds(2);
+
+public:
+	struct Item {
+		const std::string name;
+
+		PlaylistFileContents contents;
+
+		/**
+		 * The modification time and size of the file after
+		 * it was last loaded or written; used to detect
+		 * modifications by other processes.  While #dirty is
+		 * set, #mtime is the time of the last edit.
+		 */
+		std::chrono::system_clock::time_point mtime;
+		uint64_t size = 0;
+
+		/**
+		 * Does #contents differ from the file?
+		 */
+		bool dirty = false;
+
+		Item(const char *_name,
+		     PlaylistFileContents &&_contents) noexcept
+			:name(_name), contents(std::move(_contents)) {}
+	};
+
+private:
+	/**
+	 * The most recently used item comes first.
+	 */
+	std::list<Item> items;
+
+	CoarseTimerEvent flush_timer;
+
+public:
+	explicit StoredPlaylistCache(EventLoop &event_loop) noexcept
+		:flush_timer(event_loop, BIND_THIS_METHOD(FlushAll)) {}
+
+	~StoredPlaylistCache() noexcept {
+		FlushAll();
+		flush_timer.Cancel();
+	}
+
+	const std::list<Item> &GetItems() const noexcept {
+		return items;
+	}
+
+	/**
+	 * Look up a playlist.  Items which are not dirty are
+	 * discarded if the file was modified by somebody else.
+	 *
+	 * @return the item or nullptr if the playlist is not cached
+	 */
+	Item *Get(const char *name, Path path_fs) noexcept;
+
+	/**
+	 * Like Get(), but load the file if it is not cached.
+	 *
+	 * Throws on error.
+	 */
+	Item &Load(const char *name, Path path_fs);
+
+	/**
+	 * The #Item's contents were modified; schedule writing it
+	 * back.
+	 */
+	void MarkDirty(Item &item) noexcept;
+
+	/**
+	 * Write the playlist to its file now if it was modified.
+	 *
+	 * Throws on error; the modifications are then kept and will
+	 * be written by the next attempt.
+	 */
+	void Flush(const char *name);
+
+	/**
+	 * Remove the playlist from the cache, discarding pending
+	 * modifications.
+	 */
+	void Remove(const char *name) noexcept;
+
+	/**
+	 * Write all modified playlists; errors are logged, and
+	 * writing the affected playlists is retried later.
+	 */
+	void FlushAll() noexcept;
+
+private:
+	std::list<Item>::iterator Find(const char *name) noexcept;
+
+	/**
+	 * Throws on error.
+	 */
+	void Flush(Item &item);
+};
+
+}
+
+static StoredPlaylistCache *spl_cache;
+
 void
-spl_global_init(const ConfigData &config)
+spl_global_init(EventLoop &event_loop, const ConfigData &config)
 {
 	playlist_max_length =
 		config.GetPositive(ConfigOption::MAX_PLAYLIST_LENGTH,
@@ -60,6 +185,16 @@ spl_global_init(const ConfigData &config)
 	playlist_saveAbsolutePaths =
 		config.GetBool(ConfigOption::SAVE_ABSOLUTE_PATHS,
 			       DEFAULT_PLAYLIST_SAVE_ABSOLUTE_PATHS);
+
+	assert(spl_cache == nullptr);
+	spl_cache = new StoredPlaylistCache(event_loop);
+}
+
+void
+spl_global_finish() noexcept
+{
+	delete spl_cache;
+	spl_cache = nullptr;
 }
 
 bool
@@ -165,8 +300,16 @@ ListPlaylistFiles()
 	PlaylistInfo info;
 	while (reader.ReadEntry()) {
 		const auto entry = reader.GetEntry();
-		if (LoadPlaylistFileInfo(info, parent_path_fs, entry))
+		if (LoadPlaylistFileInfo(info, parent_path_fs, entry)) {
+			/* modifications which have not yet been
+			   written are reported with the time they
+			   were made */
+			for (const auto &item : spl_cache->GetItems())
+				if (item.dirty && item.name == info.name)
+					info.mtime = item.mtime;
+
 			list.push_back(std::move(info));
+		}
 	}
 
 	return list;
@@ -191,14 +334,11 @@ SavePlaylistFile(const PlaylistFileContents &contents, const char *utf8path)
 	fos.Commit();
 }
 
-PlaylistFileContents
-LoadPlaylistFile(const char *utf8path)
+static PlaylistFileContents
+ParsePlaylistFile(Path path_fs)
 try {
 	PlaylistFileContents contents;
 
-	const auto path_fs = spl_map_to_fs(utf8path);
-	assert(!path_fs.IsNull());
-
 	TextFile file(path_fs);
 
 	char *s;
@@ -251,6 +391,165 @@ try {
 	throw;
 }
 
+/**
+ * Obtain the modification time and size of the playlist file.
+ */
+static bool
+StatPlaylistFile(Path path_fs,
+		 std::chrono::system_clock::time_point &mtime,
+		 uint64_t &size) noexcept
+{
+	FileInfo fi;
+	if (!GetFileInfo(path_fs, fi) || !fi.IsRegular())
+		return false;
+
+	mtime = fi.GetModificationTime();
+	size = fi.GetSize();
+	return true;
+}
+
+std::list<StoredPlaylistCache::Item>::iterator
+StoredPlaylistCache::Find(const char *name) noexcept
+{
+	return std::find_if(items.begin(), items.end(),
+			    [name](const Item &item){
+				    return item.name == name;
+			    });
+}
+
+StoredPlaylistCache::Item *
+StoredPlaylistCache::Get(const char *name, Path path_fs) noexcept
+{
+	auto i = Find(name);
+	if (i == items.end())
+		return nullptr;
+
+	if (!i->dirty) {
+		/* has the file been modified by another process? */
+		std::chrono::system_clock::time_point mtime;
+		uint64_t size;
+		if (!StatPlaylistFile(path_fs, mtime, size) ||
+		    mtime != i->mtime || size != i->size) {
+			items.erase(i);
+			return nullptr;
+		}
+	}
+
+	/* move to the front of the LRU list */
+	items.splice(items.begin(), items, i);
+	return &items.front();
+}
+
+StoredPlaylistCache::Item &
+StoredPlaylistCache::Load(const char *name, Path path_fs)
+{
+	auto *item = Get(name, path_fs);
+	if (item != nullptr)
+		return *item;
+
+	auto contents = ParsePlaylistFile(path_fs);
+
+	/* make room for the new item; if writing the evicted one
+	   fails, it stays in the cache and the error is passed to
+	   the caller */
+	while (items.size() >= MAX_ITEMS) {
+		Flush(items.back());
+		items.pop_back();
+	}
+
+	items.emplace_front(name, std::move(contents));
+	item = &items.front();
+	StatPlaylistFile(path_fs, item->mtime, item->size);
+
+	return *item;
+}
+
+void
+StoredPlaylistCache::MarkDirty(Item &item) noexcept
+{
+	item.dirty = true;
+	item.mtime = std::chrono::system_clock::now();
+
+	/* don't postpone an already scheduled flush, or else a
+	   continuous stream of edits would never be written */
+	if (!flush_timer.IsPending())
+		flush_timer.Schedule(FLUSH_DELAY);
+}
+
+void
+StoredPlaylistCache::Flush(Item &item)
+{
+	if (!item.dirty)
+		return;
+
+	SavePlaylistFile(item.contents, item.name.c_str());
+
+	item.dirty = false;
+	StatPlaylistFile(spl_map_to_fs(item.name.c_str()),
+			 item.mtime, item.size);
+}
+
+void
+StoredPlaylistCache::Flush(const char *name)
+{
+	auto i = Find(name);
+	if (i != items.end())
+		Flush(*i);
+}
+
+void
+StoredPlaylistCache::Remove(const char *name) noexcept
+{
+	auto i = Find(name);
+	if (i != items.end())
+		items.erase(i);
+}
+
+void
+StoredPlaylistCache::FlushAll() noexcept
+{
+	bool failed = false;
+
+	for (auto &item : items) {
+		try {
+			Flush(item);
+		} catch (...) {
+			FormatError(std::current_exception(),
+				    "Failed to save playlist '%s'",
+				    item.name.c_str());
+			failed = true;
+		}
+	}
+
+	if (failed)
+		flush_timer.Schedule(FLUSH_DELAY);
+}
+
+/**
+ * Load the playlist into the cache (or look it up) for modifying it.
+ */
+static StoredPlaylistCache::Item &
+LoadCachedPlaylistFile(const char *utf8path)
+{
+	const auto path_fs = spl_map_to_fs(utf8path);
+	assert(!path_fs.IsNull());
+
+	return spl_cache->Load(utf8path, path_fs);
+}
+
+PlaylistFileContents
+LoadPlaylistFile(const char *utf8path)
+{
+	return LoadCachedPlaylistFile(utf8path).contents;
+}
+
+void
+spl_flush(const char *utf8path)
+{
+	if (spl_cache != nullptr)
+		spl_cache->Flush(utf8path);
+}
+
 void
 spl_move_index(const char *utf8path, unsigned src, unsigned dest)
 {
@@ -259,7 +558,8 @@ spl_move_index(const char *utf8path, unsigned src, unsigned dest)
 		   what the hell.. */
 		return;
 
-	auto contents = LoadPlaylistFile(utf8path);
+	auto &item = LoadCachedPlaylistFile(utf8path);
+	auto &contents = item.contents;
 
 	if (src >= contents.size() || dest >= contents.size())
 		throw PlaylistError(PlaylistResult::BAD_RANGE, "Bad range");
@@ -271,7 +571,7 @@ spl_move_index(const char *utf8path, unsigned src, unsigned dest)
 	const auto dest_i = std::next(contents.begin(), dest);
 	contents.insert(dest_i, std::move(value));
 
-	SavePlaylistFile(contents, utf8path);
+	spl_cache->MarkDirty(item);
 
 	idle_add(IDLE_STORED_PLAYLIST);
 }
@@ -282,6 +582,8 @@ spl_clear(const char *utf8path)
 	const auto path_fs = spl_map_to_fs(utf8path);
 	assert(!path_fs.IsNull());
 
+	spl_cache->Remove(utf8path);
+
 	try {
 		TruncateFile(path_fs);
 	} catch (const std::system_error &e) {
@@ -301,6 +603,8 @@ spl_delete(const char *name_utf8)
 	const auto path_fs = spl_map_to_fs(name_utf8);
 	assert(!path_fs.IsNull());
 
+	spl_cache->Remove(name_utf8);
+
 	try {
 		RemoveFile(path_fs);
 	} catch (const std::system_error &e) {
@@ -317,14 +621,15 @@ spl_delete(const char *name_utf8)
 void
 spl_remove_index(const char *utf8path, unsigned pos)
 {
-	auto contents = LoadPlaylistFile(utf8path);
+	auto &item = LoadCachedPlaylistFile(utf8path);
+	auto &contents = item.contents;
 
 	if (pos >= contents.size())
 		throw PlaylistError(PlaylistResult::BAD_RANGE, "Bad range");
 
 	contents.erase(std::next(contents.begin(), pos));
 
-	SavePlaylistFile(contents, utf8path);
+	spl_cache->MarkDirty(item);
 	idle_add(IDLE_STORED_PLAYLIST);
 }
 
@@ -334,6 +639,20 @@ try {
 	const auto path_fs = spl_map_to_fs(utf8path);
 	assert(!path_fs.IsNull());
 
+	auto *item = spl_cache->Get(utf8path, path_fs);
+	if (item != nullptr && item->dirty) {
+		/* the file is outdated; it will be rewritten
+		   completely anyway */
+		if (item->contents.size() >= playlist_max_length)
+			throw PlaylistError(PlaylistResult::TOO_LARGE,
+					    "Stored playlist is too large");
+
+		item->contents.emplace_back(song.GetURI());
+		spl_cache->MarkDirty(*item);
+		idle_add(IDLE_STORED_PLAYLIST);
+		return;
+	}
+
 	FileOutputStream fos(path_fs, FileOutputStream::Mode::APPEND_OR_CREATE);
 
 	if (fos.Tell() / (MPD_PATH_MAX + 1) >= playlist_max_length)
@@ -347,6 +666,12 @@ try {
 	bos.Flush();
 	fos.Commit();
 
+	if (item != nullptr) {
+		/* keep the cached copy in sync with the file */
+		item->contents.emplace_back(song.GetURI());
+		StatPlaylistFile(path_fs, item->mtime, item->size);
+	}
+
 	idle_add(IDLE_STORED_PLAYLIST);
 } catch (const std::system_error &e) {
 	if (IsFileNotFound(e))
@@ -390,5 +715,13 @@ spl_rename(const char *utf8from, const char *utf8to)
 	const auto to_path_fs = spl_map_to_fs(utf8to);
 	assert(!to_path_fs.IsNull());
 
+	spl_cache->Flush(utf8from);
+
 	spl_rename_internal(from_path_fs, to_path_fs);
+
+	spl_cache->Remove(utf8from);
+
+	/* a cached copy of an old playlist with the new name is
+	   stale now */
+	spl_cache->Remove(utf8to);
 }
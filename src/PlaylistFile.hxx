@@ -24,6 +24,7 @@
 #include <string>
 
 struct ConfigData;
+class EventLoop;
 class DetachedSong;
 class SongLoader;
 class PlaylistVector;
@@ -37,7 +38,14 @@ extern bool playlist_saveAbsolutePaths;
  * Perform some global initialization, e.g. load configuration values.
  */
 void
-spl_global_init(const ConfigData &config);
+spl_global_init(EventLoop &event_loop, const ConfigData &config);
+
+/**
+ * Write all pending modifications and free the stored playlist
+ * cache.
+ */
+void
+spl_global_finish() noexcept;
 
 /**
  * Determines whether the specified string is a valid name for a
@@ -58,6 +66,15 @@ ListPlaylistFiles();
 PlaylistFileContents
 LoadPlaylistFile(const char *utf8path);
 
+/**
+ * Write pending modifications of the stored playlist to its file.
+ * This must be called before reading the file directly.
+ *
+ * Throws on error.
+ */
+void
+spl_flush(const char *utf8path);
+
 void
 spl_move_index(const char *utf8path, unsigned src, unsigned dest);
 
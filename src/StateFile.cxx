@@ -24,11 +24,12 @@
 #include "fs/io/TextFile.hxx"
 #include "fs/io/FileOutputStream.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
+#include "fs/io/StringOutputStream.hxx"
 #include "storage/StorageState.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "mixer/Volume.hxx"
-#include "SongLoader.hxx"
+#include "thread/Name.hxx"
 #include "util/Domain.hxx"
 #include "Log.hxx"
 
@@ -36,6 +37,11 @@
 
 static constexpr Domain state_file_domain("state_file");
 
+/**
+ * Compact the journal after this many records, to keep Read() fast.
+ */
+static constexpr unsigned MAX_JOURNAL_RECORDS = 256;
+
 StateFile::StateFile(StateFileConfig &&_config,
 		     Partition &_partition, EventLoop &_loop)
 	:config(std::move(_config)), path_utf8(config.path.ToUTF8()),
@@ -44,6 +50,20 @@ StateFile::StateFile(StateFileConfig &&_config,
 {
 }
 
+StateFile::~StateFile() noexcept
+{
+	if (!thread.IsDefined())
+		return;
+
+	{
+		const std::lock_guard<Mutex> protect(mutex);
+		quit = true;
+		cond.notify_one();
+	}
+
+	thread.Join();
+}
+
 void
 StateFile::RememberVersions() noexcept
 {
@@ -54,6 +74,7 @@ StateFile::RememberVersions() noexcept
 #ifdef ENABLE_DATABASE
 	prev_storage_version = storage_state_get_hash(partition.instance);
 #endif
+	prev_queue_version = partition.playlist.queue.version;
 }
 
 bool
@@ -83,28 +104,131 @@ StateFile::Write(BufferedOutputStream &os)
 }
 
 inline void
-StateFile::Write(OutputStream &os)
+StateFile::WriteChanges(BufferedOutputStream &os)
+{
+	/* these are small; just repeat them */
+	save_sw_volume_state(os);
+	audio_output_state_save(os, partition.outputs);
+
+	playlist_state_save_changes(os, partition.playlist, partition.pc,
+				    prev_queue_version);
+}
+
+std::string
+StateFile::MakeSnapshot(bool &append_r)
 {
-	BufferedOutputStream bos(os);
-	Write(bos);
+	const auto &queue = partition.playlist.queue;
+
+	bool append = !need_snapshot &&
+		journal_records < MAX_JOURNAL_RECORDS &&
+		journal_size < snapshot_size
+#ifdef ENABLE_DATABASE
+		/* mounts are not journaled */
+		&& prev_storage_version == storage_state_get_hash(partition.instance)
+#endif
+		;
+
+	/* if most of the queue was modified, a journal record isn't
+	   worth it */
+	if (append &&
+	    queue_count_changes(queue, prev_queue_version) > queue.GetLength() / 2)
+		append = false;
+
+	StringOutputStream sos;
+	BufferedOutputStream bos(sos);
+	if (append)
+		WriteChanges(bos);
+	else
+		Write(bos);
 	bos.Flush();
+
+	auto data = std::move(sos).GetValue();
+
+	if (append) {
+		journal_size += data.size();
+		++journal_records;
+	} else {
+		snapshot_size = data.size();
+		journal_size = 0;
+		journal_records = 0;
+		need_snapshot = false;
+	}
+
+	RememberVersions();
+
+	append_r = append;
+	return data;
+}
+
+void
+StateFile::WriteFile(const std::string &data, bool append) const
+{
+	FileOutputStream fos(config.path,
+			     append
+			     ? FileOutputStream::Mode::APPEND_EXISTING
+			     : FileOutputStream::Mode::CREATE);
+	fos.Write(data.data(), data.size());
+	fos.Commit();
+}
+
+void
+StateFile::WaitIdle(std::unique_lock<Mutex> &lock) noexcept
+{
+	cond.wait(lock, [this]{ return !busy; });
+
+	if (failed) {
+		/* we don't know what's in the file now; start
+		   over */
+		failed = false;
+		need_snapshot = true;
+	}
+}
+
+void
+StateFile::RunThread() noexcept
+{
+	SetThreadName("state_file");
+
+	std::unique_lock<Mutex> lock(mutex);
+
+	while (true) {
+		cond.wait(lock, [this]{ return busy || quit; });
+		if (quit)
+			break;
+
+		try {
+			const ScopeUnlock unlock(mutex);
+			WriteFile(pending_data, pending_append);
+		} catch (...) {
+			LogError(std::current_exception());
+			failed = true;
+		}
+
+		pending_data = {};
+		busy = false;
+		cond.notify_one();
+	}
 }
 
 void
 StateFile::Write()
 {
+	{
+		std::unique_lock<Mutex> lock(mutex);
+		WaitIdle(lock);
+	}
+
 	FormatDebug(state_file_domain,
 		    "Saving state file %s", path_utf8.c_str());
 
 	try {
-		FileOutputStream fos(config.path);
-		Write(fos);
-		fos.Commit();
+		bool append;
+		const auto data = MakeSnapshot(append);
+		WriteFile(data, append);
 	} catch (...) {
 		LogError(std::current_exception());
+		need_snapshot = true;
 	}
-
-	RememberVersions();
 }
 
 void
@@ -114,32 +238,38 @@ try {
 
 	FormatDebug(state_file_domain, "Loading state file %s", path_utf8.c_str());
 
-	TextFile file(config.path);
+	PlaylistStateLoader playlist_loader;
 
-#ifdef ENABLE_DATABASE
-	const SongLoader song_loader(partition.instance.GetDatabase(),
-				     partition.instance.storage);
-#else
-	const SongLoader song_loader(nullptr, nullptr);
-#endif
+	try {
+		TextFile file(config.path);
 
-	const char *line;
-	while ((line = file.ReadLine()) != nullptr) {
-		success = read_sw_volume_state(line, partition.outputs) ||
-			audio_output_state_read(line, partition.outputs) ||
-			playlist_state_restore(config, line, file, song_loader,
-					       partition.playlist,
-					       partition.pc);
+		const char *line;
+		while ((line = file.ReadLine()) != nullptr) {
+			success = read_sw_volume_state(line, partition.outputs) ||
+				audio_output_state_read(line, partition.outputs) ||
+				playlist_loader.ReadLine(line, file,
+							 partition.playlist,
+							 partition.pc);
 #ifdef ENABLE_DATABASE
-		success = success || storage_state_restore(line, file, partition.instance);
+			success = success || storage_state_restore(line, file, partition.instance);
 #endif
 
-		if (!success)
-			FormatError(state_file_domain,
-				    "Unrecognized line in state file: %s",
-				    line);
+			if (!success)
+				FormatError(state_file_domain,
+					    "Unrecognized line in state file: %s",
+					    line);
+		}
+	} catch (...) {
+		/* restore what we have so far; a crash may have
+		   truncated the last journal record */
+		LogError(std::current_exception());
 	}
 
+	playlist_loader.Finish(config, partition.playlist, partition.pc);
+
+	/* look up the restored songs after startup */
+	partition.ResolveQueueLater();
+
 	RememberVersions();
 } catch (...) {
 	LogError(std::current_exception());
@@ -148,12 +278,51 @@ try {
 void
 StateFile::CheckModified() noexcept
 {
-	if (!timer_event.IsPending() && IsModified())
+	if (timer_event.IsPending())
+		return;
+
+	bool retry;
+	{
+		const std::lock_guard<Mutex> protect(mutex);
+		retry = failed;
+	}
+
+	if (retry || IsModified())
 		timer_event.Schedule(config.interval);
 }
 
 void
 StateFile::OnTimeout() noexcept
 {
-	Write();
+	{
+		std::unique_lock<Mutex> lock(mutex);
+		if (busy) {
+			/* the previous write is still in progress;
+			   try again later */
+			timer_event.Schedule(config.interval);
+			return;
+		}
+
+		WaitIdle(lock);
+	}
+
+	FormatDebug(state_file_domain,
+		    "Saving state file %s", path_utf8.c_str());
+
+	try {
+		bool append;
+		auto data = MakeSnapshot(append);
+
+		if (!thread.IsDefined())
+			thread.Start();
+
+		const std::lock_guard<Mutex> protect(mutex);
+		pending_data = std::move(data);
+		pending_append = append;
+		busy = true;
+		cond.notify_one();
+	} catch (...) {
+		LogError(std::current_exception());
+		need_snapshot = true;
+	}
 }
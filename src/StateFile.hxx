@@ -22,9 +22,13 @@
 
 #include "StateFileConfig.hxx"
 #include "event/FarTimerEvent.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
 #include "util/Compiler.h"
 #include "config.h"
 
+#include <cstdint>
 #include <string>
 
 struct Partition;
@@ -51,11 +55,74 @@ class StateFile final {
 	unsigned prev_storage_version = 0;
 #endif
 
+	/**
+	 * The queue version at the time of the last write.  Journal
+	 * records contain only songs modified after that.
+	 */
+	uint32_t prev_queue_version = 0;
+
+	/**
+	 * The size of the last full snapshot, and the number of
+	 * bytes and records appended to it since.  These decide when
+	 * the journal gets compacted.
+	 */
+	std::size_t snapshot_size = 0, journal_size = 0;
+	unsigned journal_records = 0;
+
+	/**
+	 * If true, then the next write must be a full snapshot,
+	 * e.g. because the file on disk doesn't match what we think
+	 * it contains.
+	 */
+	bool need_snapshot = true;
+
+	/**
+	 * The thread which writes the file, so the #EventLoop never
+	 * blocks on disk I/O.  It is started on demand.
+	 */
+	Thread thread{BIND_THIS_METHOD(RunThread)};
+
+	/**
+	 * Protects the following fields, which are shared with the
+	 * #thread.
+	 */
+	Mutex mutex;
+	Cond cond;
+
+	/**
+	 * The data to be written by the #thread.
+	 */
+	std::string pending_data;
+
+	/**
+	 * Shall #pending_data be appended to the file instead of
+	 * replacing it?
+	 */
+	bool pending_append;
+
+	/**
+	 * Has the #thread not yet finished writing #pending_data?
+	 */
+	bool busy = false;
+
+	/**
+	 * Was there an error during the last write by the #thread?
+	 */
+	bool failed = false;
+
+	bool quit = false;
+
 public:
 	StateFile(StateFileConfig &&_config,
 		  Partition &partition, EventLoop &loop);
+	~StateFile() noexcept;
 
 	void Read();
+
+	/**
+	 * Save the state synchronously (after waiting for pending
+	 * asynchronous writes).  This is used on shutdown.
+	 */
 	void Write();
 
 	/**
@@ -64,8 +131,33 @@ public:
 	void CheckModified() noexcept;
 
 private:
-	void Write(OutputStream &os);
 	void Write(BufferedOutputStream &os);
+	void WriteChanges(BufferedOutputStream &os);
+
+	/**
+	 * Serialize the current state, either a full snapshot or a
+	 * journal record with the changes since the last call.
+	 *
+	 * @param append_r receives true if the result shall be
+	 * appended to the existing file
+	 */
+	std::string MakeSnapshot(bool &append_r);
+
+	/**
+	 * Write the result of MakeSnapshot() to the file.  This runs
+	 * in the #thread (or in the main thread during shutdown).
+	 *
+	 * Throws on error.
+	 */
+	void WriteFile(const std::string &data, bool append) const;
+
+	/**
+	 * Wait until the #thread has finished writing, and check for
+	 * errors.
+	 */
+	void WaitIdle(std::unique_lock<Mutex> &lock) noexcept;
+
+	void RunThread() noexcept;
 
 	/**
 	 * Save the current state versions for use with IsModified().
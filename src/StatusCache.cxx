@@ -0,0 +1,75 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "StatusCache.hxx"
+
+#include <utility>
+
+#include <stdio.h>
+
+void
+StatusCache::Status::AppendTo(std::string &dest,
+			      std::chrono::steady_clock::time_point now) const
+{
+	dest.append(head);
+
+	if (state != PlayerState::STOP) {
+		/* extrapolate the elapsed time instead of asking
+		   the player thread again */
+		SongTime elapsed = elapsed_time;
+		if (state == PlayerState::PLAY)
+			elapsed = elapsed + SongTime::Cast(now - time);
+
+		if (!total_time.IsNegative() &&
+		    elapsed > SongTime(total_time))
+			elapsed = SongTime(total_time);
+
+		char buffer[64];
+		int length = snprintf(buffer, sizeof(buffer),
+				      "time: %i:%i\n"
+				      "elapsed: %1.3f\n",
+				      elapsed.RoundS(),
+				      total_time.IsNegative()
+				      ? 0U
+				      : unsigned(total_time.RoundS()),
+				      elapsed.ToDoubleS());
+		dest.append(buffer, length);
+	}
+
+	dest.append(tail);
+}
+
+std::shared_ptr<const StatusCache::Status>
+StatusCache::Shared::GetStatus(std::chrono::steady_clock::time_point now) const noexcept
+{
+	const unsigned current_version = GetVersion();
+
+	const std::lock_guard<Mutex> lock(mutex);
+	if (status == nullptr || !status->IsValid(current_version, now))
+		return nullptr;
+
+	return status;
+}
+
+void
+StatusCache::Shared::SetStatus(std::shared_ptr<const Status> _status) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+	status = std::move(_status);
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_STATUS_CACHE_HXX
+#define MPD_STATUS_CACHE_HXX
+
+#include "IdleFlags.hxx"
+#include "Chrono.hxx"
+#include "player/Control.hxx"
+#include "tag/Mask.hxx"
+#include "thread/Mutex.hxx"
+#include "util/Compiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+/**
+ * Pre-rendered responses of the "status" and "currentsong" commands
+ * of one #Partition.  Clients tend to poll these commands, and
+ * re-rendering them each time requires a round trip to the player
+ * thread and dozens of allocations.
+ *
+ * A response is valid as long as no idle event which may affect it
+ * has been emitted; see Partition::GetStatusVersion().
+ */
+struct StatusCache {
+	/**
+	 * The idle events which invalidate the cache.
+	 */
+	static constexpr unsigned IDLE_MASK = IDLE_PLAYLIST|IDLE_PLAYER|
+		IDLE_MIXER|IDLE_OUTPUT|IDLE_OPTIONS|IDLE_UPDATE;
+
+	/**
+	 * Render "status" again after this duration even without an
+	 * idle event, because some values (e.g. the bit rate) change
+	 * silently.
+	 */
+	static constexpr std::chrono::steady_clock::duration MAX_AGE =
+		std::chrono::milliseconds(500);
+
+	/**
+	 * A rendered "status" response.  It is never modified after
+	 * it has been published with Shared::SetStatus().
+	 */
+	struct Status {
+		/**
+		 * The version this response was rendered for.
+		 */
+		unsigned version;
+
+		PlayerState state;
+
+		/**
+		 * When was the player status obtained?
+		 */
+		std::chrono::steady_clock::time_point time;
+
+		/**
+		 * The elapsed time at #time.
+		 */
+		SongTime elapsed_time;
+
+		SignedSongTime total_time;
+
+		/**
+		 * The "time" and "elapsed" lines are rendered for
+		 * each request; these are the lines before and after
+		 * them.
+		 */
+		std::string head, tail;
+
+		bool IsValid(unsigned _version,
+			     std::chrono::steady_clock::time_point now) const noexcept {
+			return version == _version && now - time < MAX_AGE;
+		}
+
+		/**
+		 * Append the response (without the trailing "OK") to
+		 * the given buffer.
+		 */
+		void AppendTo(std::string &dest,
+			      std::chrono::steady_clock::time_point now) const;
+	};
+
+	/**
+	 * The part of the cache which is shared with the
+	 * #ClientThread instances; they answer "status" without
+	 * involving the main thread if possible.  It is
+	 * reference-counted because a #ClientSocket may still refer
+	 * to it after the #Partition has been deleted.
+	 */
+	struct Shared {
+		/**
+		 * See Instance::status_version.
+		 */
+		const std::atomic_uint &instance_version;
+
+		/**
+		 * Incremented by Partition::EmitIdle().  This may be
+		 * modified by any thread.
+		 */
+		std::atomic_uint version{0};
+
+		mutable Mutex mutex;
+
+		/**
+		 * The most recent "status" response; nullptr if none
+		 * was rendered yet.  Protected by #mutex.
+		 */
+		std::shared_ptr<const Status> status;
+
+		explicit Shared(const std::atomic_uint &_instance_version) noexcept
+			:instance_version(_instance_version) {}
+
+		Shared(const Shared &) = delete;
+		Shared &operator=(const Shared &) = delete;
+
+		/**
+		 * Returns a number which changes whenever the cached
+		 * responses become obsolete.  This method is
+		 * thread-safe.
+		 */
+		gcc_pure
+		unsigned GetVersion() const noexcept {
+			return instance_version.load() + version.load();
+		}
+
+		/**
+		 * Returns the cached "status" response if it is still
+		 * valid, nullptr otherwise.  This method is
+		 * thread-safe.
+		 */
+		gcc_pure
+		std::shared_ptr<const Status> GetStatus(std::chrono::steady_clock::time_point now) const noexcept;
+
+		/**
+		 * Publish a new "status" response.  Must be called in
+		 * the main thread.
+		 */
+		void SetStatus(std::shared_ptr<const Status> _status) noexcept;
+	};
+
+	const std::shared_ptr<Shared> shared;
+
+	struct CurrentSong {
+		unsigned version;
+
+		bool valid = false;
+
+		/**
+		 * The tag mask of the client which this response was
+		 * rendered for.
+		 */
+		TagMask tag_mask;
+
+		std::string text;
+
+		bool IsValid(unsigned _version,
+			     TagMask _tag_mask) const noexcept {
+			return valid && version == _version &&
+				tag_mask == _tag_mask;
+		}
+	} current_song;
+
+	explicit StatusCache(const std::atomic_uint &instance_version)
+		:shared(std::make_shared<Shared>(instance_version)) {}
+
+	/**
+	 * Discard all cached responses.  This method is thread-safe.
+	 */
+	void Invalidate() noexcept {
+		++shared->version;
+	}
+
+	void OnIdle(unsigned mask) noexcept {
+		if (mask & IDLE_MASK)
+			Invalidate();
+	}
+};
+
+#endif
@@ -22,13 +22,14 @@
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "BackgroundCommand.hxx"
+#include "Socket.hxx"
 #include "IdleFlags.hxx"
 #include "config.h"
 
 Client::~Client() noexcept
 {
-	if (FullyBufferedSocket::IsDefined())
-		FullyBufferedSocket::Close();
+	if (socket != nullptr)
+		socket->Close(false);
 
 	if (background_command) {
 		background_command->Cancel();
@@ -55,9 +56,8 @@ Client::OnBackgroundCommandFinished() noexcept
 
 	background_command.reset();
 
-	/* just in case OnSocketInput() has returned
-	   InputResult::PAUSE meanwhile */
-	ResumeInput();
+	/* process the input which has been received meanwhile */
+	defer_event.Schedule();
 
 	timeout_event.Schedule(client_timeout);
 }
@@ -71,6 +71,7 @@ Client::SetPartition(Partition &new_partition) noexcept
 	partition->clients.erase(partition->clients.iterator_to(*this));
 	partition = &new_partition;
 	partition->clients.push_back(*this);
+	idle_serial = partition->idle_clients.GetSerial();
 
 	/* set idle flags for those subsystems which are specific to
 	   the current partition to force the client to reload its
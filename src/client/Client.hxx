@@ -24,14 +24,15 @@
 #include "command/CommandResult.hxx"
 #include "command/CommandListBuilder.hxx"
 #include "tag/Mask.hxx"
-#include "event/FullyBufferedSocket.hxx"
 #include "event/CoarseTimerEvent.hxx"
+#include "event/DeferEvent.hxx"
 #include "util/Compiler.h"
 
 #include <boost/intrusive/link_mode.hpp>
 #include <boost/intrusive/list_hook.hpp>
 
 #include <cstddef>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <set>
@@ -40,6 +41,8 @@
 class SocketAddress;
 class UniqueSocketDescriptor;
 class EventLoop;
+class ClientSocket;
+class ClientThread;
 class Path;
 struct Instance;
 struct Partition;
@@ -48,14 +51,39 @@ struct playlist;
 class Database;
 class Storage;
 class BackgroundCommand;
+class ClientIdleList;
 
 class Client final
-	: FullyBufferedSocket,
-	  public boost::intrusive::list_base_hook<boost::intrusive::tag<Partition>,
+	: public boost::intrusive::list_base_hook<boost::intrusive::tag<Partition>,
+						  boost::intrusive::link_mode<boost::intrusive::normal_link>>,
+	  public boost::intrusive::list_base_hook<boost::intrusive::tag<ClientIdleList>,
 						  boost::intrusive::link_mode<boost::intrusive::normal_link>>,
 	  public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
 	CoarseTimerEvent timeout_event;
 
+	/**
+	 * Submits #output to the #ClientSocket and processes #input
+	 * after a #BackgroundCommand has finished.
+	 */
+	DeferEvent defer_event;
+
+	/**
+	 * The socket, served by a #ClientThread.  This is nullptr
+	 * after the connection has expired.
+	 */
+	ClientSocket *socket;
+
+	/**
+	 * Request lines received from #socket which have not yet been
+	 * processed.
+	 */
+	std::string input;
+
+	/**
+	 * Response data which has not yet been submitted to #socket.
+	 */
+	std::string output;
+
 	Partition *partition;
 
 	unsigned permission;
@@ -77,6 +105,24 @@ class Client final
 	/** idle flags that the client wants to receive */
 	unsigned idle_subscriptions;
 
+	/**
+	 * The ClientIdleList::GetSerial() value when #idle_flags was
+	 * last updated from the partition's #ClientIdleList.
+	 */
+	uint64_t idle_serial;
+
+	/**
+	 * Has the client requested response compression with the
+	 * "compress" command?
+	 */
+	bool compression = false;
+
+	/**
+	 * Shall compression be enabled after the response to the
+	 * current command has been submitted?
+	 */
+	bool compression_pending = false;
+
 public:
 	// TODO: make this attribute "private"
 	/**
@@ -120,19 +166,32 @@ private:
 	std::unique_ptr<BackgroundCommand> background_command;
 
 public:
-	Client(EventLoop &loop, Partition &partition,
+	/**
+	 * Throws on error.
+	 *
+	 * @param loop the main #EventLoop
+	 * @param thread the #ClientThread which performs socket I/O
+	 */
+	Client(EventLoop &loop, ClientThread &thread, Partition &partition,
 	       UniqueSocketDescriptor fd, int uid,
 	       unsigned _permission,
-	       int num) noexcept;
+	       int num);
 
 	~Client() noexcept;
 
-	using FullyBufferedSocket::GetEventLoop;
-	using FullyBufferedSocket::GetOutputMaxSize;
+	Client(const Client &) = delete;
+	Client &operator=(const Client &) = delete;
+
+	EventLoop &GetEventLoop() const noexcept {
+		return defer_event.GetEventLoop();
+	}
+
+	gcc_pure
+	std::size_t GetOutputMaxSize() const noexcept;
 
 	gcc_pure
 	bool IsExpired() const noexcept {
-		return !FullyBufferedSocket::IsDefined();
+		return socket == nullptr;
 	}
 
 	void Close() noexcept;
@@ -173,9 +232,28 @@ public:
 	 * Send "idle" response to this client.
 	 */
 	void IdleNotify() noexcept;
+
+	/**
+	 * Add idle flags which concern only this client (e.g.
+	 * #IDLE_MESSAGE).  Partition-wide events are delivered by
+	 * #ClientIdleList.
+	 */
 	void IdleAdd(unsigned flags) noexcept;
 	bool IdleWait(unsigned flags) noexcept;
 
+	/**
+	 * Leave "idle" mode without sending a response (for the
+	 * "noidle" command).
+	 */
+	void IdleCancel() noexcept;
+
+	/**
+	 * Called by #ClientIdleList when an event this client is
+	 * waiting for has occurred.  The client has already been
+	 * unregistered.
+	 */
+	void IdleWake() noexcept;
+
 	/**
 	 * Called by a command handler to defer execution to a
 	 * #BackgroundCommand.
@@ -189,6 +267,15 @@ public:
 	 */
 	void OnBackgroundCommandFinished() noexcept;
 
+	/**
+	 * Called by the "compress" command handler: compress all
+	 * responses after the response to the current command (or
+	 * command list).
+	 *
+	 * @return false if compression was already enabled
+	 */
+	bool RequestCompression() noexcept;
+
 	enum class SubscribeResult {
 		/** success */
 		OK,
@@ -269,14 +356,35 @@ public:
 
 private:
 	CommandResult ProcessCommandList(bool list_ok,
-					 std::list<std::string> &&list) noexcept;
+					 std::string &&list) noexcept;
 
 	CommandResult ProcessLine(char *line) noexcept;
 
-	/* virtual methods from class BufferedSocket */
-	InputResult OnSocketInput(void *data, size_t length) noexcept override;
-	void OnSocketError(std::exception_ptr ep) noexcept override;
-	void OnSocketClosed() noexcept override;
+	/**
+	 * Process the complete lines in #input.
+	 *
+	 * @return false if this object has been deleted
+	 */
+	bool ProcessInput() noexcept;
+
+	/**
+	 * Submit #output to the #ClientSocket.
+	 *
+	 * @return false if the output buffer is full
+	 */
+	bool FlushOutput() noexcept;
+
+	/**
+	 * Submit #output uncompressed and tell the #ClientSocket to
+	 * compress everything after it.
+	 */
+	void StartCompression() noexcept;
+
+	/* callback for ClientSocket */
+	void OnSocketInput() noexcept;
+
+	/* callback for DeferEvent */
+	void OnDeferred() noexcept;
 
 	/* callback for TimerEvent */
 	void OnTimeout() noexcept;
@@ -19,6 +19,8 @@
 
 #include "Client.hxx"
 #include "BackgroundCommand.hxx"
+#include "Socket.hxx"
+#include "Config.hxx"
 #include "Domain.hxx"
 #include "Log.hxx"
 
@@ -33,7 +35,8 @@ Client::SetExpired() noexcept
 		background_command.reset();
 	}
 
-	FullyBufferedSocket::Close();
+	defer_event.Cancel();
+	std::exchange(socket, nullptr)->Close(false);
 	timeout_event.Schedule(Event::Duration::zero());
 }
 
@@ -44,6 +47,13 @@ Client::OnTimeout() noexcept
 		assert(!idle_waiting);
 		assert(!background_command);
 
+		if (socket->CheckLocalActivity()) {
+			/* the client thread has executed commands
+			   meanwhile */
+			timeout_event.Schedule(client_timeout);
+			return;
+		}
+
 		FormatDebug(client_domain, "[%u] timeout", num);
 	}
 
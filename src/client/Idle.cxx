@@ -21,6 +21,7 @@
 #include "Config.hxx"
 #include "Response.hxx"
 #include "Idle.hxx"
+#include "Partition.hxx"
 
 #include <cassert>
 
@@ -58,8 +59,24 @@ Client::IdleAdd(unsigned flags) noexcept
 		return;
 
 	idle_flags |= flags;
-	if (idle_waiting && (idle_flags & idle_subscriptions))
+	if (idle_waiting && (idle_flags & idle_subscriptions)) {
+		partition->idle_clients.Remove(*this, idle_subscriptions);
 		IdleNotify();
+	}
+}
+
+void
+Client::IdleWake() noexcept
+{
+	assert(idle_waiting);
+
+	if (IsExpired()) {
+		idle_waiting = false;
+		return;
+	}
+
+	idle_flags |= partition->idle_clients.Collect(idle_serial);
+	IdleNotify();
 }
 
 bool
@@ -69,13 +86,25 @@ Client::IdleWait(unsigned flags) noexcept
 
 	idle_waiting = true;
 	idle_subscriptions = flags;
+	idle_flags |= partition->idle_clients.Collect(idle_serial);
 
 	if (idle_flags & idle_subscriptions) {
 		IdleNotify();
 		return true;
 	} else {
+		partition->idle_clients.Add(*this, idle_subscriptions);
+
 		/* disable timeouts while in "idle" */
 		timeout_event.Cancel();
 		return false;
 	}
 }
+
+void
+Client::IdleCancel() noexcept
+{
+	assert(idle_waiting);
+
+	partition->idle_clients.Remove(*this, idle_subscriptions);
+	idle_waiting = false;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "IdleList.hxx"
+#include "Client.hxx"
+
+#include <cassert>
+
+unsigned
+ClientIdleList::Collect(uint64_t &since) const noexcept
+{
+	unsigned flags = 0;
+	for (unsigned i = 0; i < flag_serials.size(); ++i)
+		if (flag_serials[i] > since)
+			flags |= 1U << i;
+
+	since = serial;
+	return flags;
+}
+
+void
+ClientIdleList::Add(Client &client, unsigned subscriptions) noexcept
+{
+	groups[subscriptions].push_back(client);
+}
+
+void
+ClientIdleList::Remove(Client &client, unsigned subscriptions) noexcept
+{
+	auto i = groups.find(subscriptions);
+	assert(i != groups.end());
+
+	auto &list = i->second;
+	list.erase(list.iterator_to(client));
+	if (list.empty())
+		groups.erase(i);
+}
+
+void
+ClientIdleList::Emit(unsigned mask) noexcept
+{
+	++serial;
+	for (unsigned i = 0; i < flag_serials.size(); ++i)
+		if (mask & (1U << i))
+			flag_serials[i] = serial;
+
+	/* move all interested clients to a local list first, because
+	   waking up a client may modify #groups */
+	List wake;
+	for (auto i = groups.begin(); i != groups.end();) {
+		if (i->first & mask) {
+			wake.splice(wake.end(), i->second);
+			i = groups.erase(i);
+		} else
+			++i;
+	}
+
+	wake.clear_and_dispose([](Client *client){
+		client->IdleWake();
+	});
+}
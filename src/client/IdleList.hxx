@@ -0,0 +1,99 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_CLIENT_IDLE_LIST_HXX
+#define MPD_CLIENT_IDLE_LIST_HXX
+
+#include <boost/intrusive/list.hpp>
+
+#include <array>
+#include <cstdint>
+#include <map>
+
+class Client;
+
+/**
+ * Dispatches the "idle" events of one #Partition to its clients.
+ *
+ * Only clients which are currently waiting in "idle" are linked
+ * here, grouped by their subscription mask, so an event costs only
+ * O(interested clients).  The events which occur while a client is
+ * busy are not delivered to it; instead, each flag remembers the
+ * serial number of its most recent event, and the client collects
+ * all newer flags with Collect() when it enters "idle" again.
+ */
+class ClientIdleList {
+	using List =
+		boost::intrusive::list<Client,
+				       boost::intrusive::base_hook<boost::intrusive::list_base_hook<boost::intrusive::tag<ClientIdleList>,
+												    boost::intrusive::link_mode<boost::intrusive::normal_link>>>,
+				       boost::intrusive::constant_time_size<false>>;
+
+	/**
+	 * The waiting clients, indexed by their subscription mask.
+	 * Empty lists are removed.
+	 */
+	std::map<unsigned, List> groups;
+
+	/**
+	 * Incremented for each Emit() call.
+	 */
+	uint64_t serial = 0;
+
+	/**
+	 * The #serial of the most recent event of each flag.
+	 */
+	std::array<uint64_t, 32> flag_serials{};
+
+public:
+	ClientIdleList() = default;
+
+	ClientIdleList(const ClientIdleList &) = delete;
+	ClientIdleList &operator=(const ClientIdleList &) = delete;
+
+	uint64_t GetSerial() const noexcept {
+		return serial;
+	}
+
+	/**
+	 * Determine which flags have been emitted since the given
+	 * serial number and update it.
+	 */
+	unsigned Collect(uint64_t &since) const noexcept;
+
+	/**
+	 * Register a client which has entered "idle".
+	 */
+	void Add(Client &client, unsigned subscriptions) noexcept;
+
+	/**
+	 * Unregister a client which has left "idle" without having
+	 * been woken up by Emit().
+	 */
+	void Remove(Client &client, unsigned subscriptions) noexcept;
+
+	/**
+	 * Record an event and wake up all clients which are
+	 * subscribed to at least one of the given flags.  They are
+	 * unregistered before Client::IdleWake() is invoked.
+	 */
+	void Emit(unsigned mask) noexcept;
+};
+
+#endif
@@ -21,6 +21,8 @@
 #include "Config.hxx"
 #include "Domain.hxx"
 #include "List.hxx"
+#include "Socket.hxx"
+#include "Thread.hxx"
 #include "BackgroundCommand.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
@@ -34,17 +36,19 @@
 
 static constexpr char GREETING[] = "OK MPD " PROTOCOL_VERSION "\n";
 
-Client::Client(EventLoop &_loop, Partition &_partition,
+Client::Client(EventLoop &_loop, ClientThread &thread, Partition &_partition,
 	       UniqueSocketDescriptor _fd,
 	       int _uid, unsigned _permission,
-	       int _num) noexcept
-	:FullyBufferedSocket(_fd.Release(), _loop,
-			     16384, client_max_output_buffer_size),
-	 timeout_event(_loop, BIND_THIS_METHOD(OnTimeout)),
+	       int _num)
+	:timeout_event(_loop, BIND_THIS_METHOD(OnTimeout)),
+	 defer_event(_loop, BIND_THIS_METHOD(OnDeferred)),
+	 socket(&thread.AddSocket(std::move(_fd), _loop,
+				  BIND_THIS_METHOD(OnSocketInput))),
 	 partition(&_partition),
 	 permission(_permission),
 	 uid(_uid),
-	 num(_num)
+	 num(_num),
+	 idle_serial(_partition.idle_clients.GetSerial())
 {
 	timeout_event.Schedule(client_timeout);
 }
@@ -68,9 +72,18 @@ client_new(EventLoop &loop, Partition &partition,
 	(void)fd.Write(GREETING, sizeof(GREETING) - 1);
 
 	const unsigned num = next_client_num++;
-	auto *client = new Client(loop, partition, std::move(fd), uid,
+
+	Client *client;
+	try {
+		client = new Client(loop,
+				    partition.instance.client_threads->Next(),
+				    partition, std::move(fd), uid,
 				    permission,
 				    num);
+	} catch (...) {
+		LogError(std::current_exception());
+		return;
+	}
 
 	client_list.Add(*client);
 	partition.clients.push_back(*client);
@@ -85,8 +98,15 @@ Client::Close() noexcept
 	partition->instance.client_list->Remove(*this);
 	partition->clients.erase(partition->clients.iterator_to(*this));
 
-	if (FullyBufferedSocket::IsDefined())
-		FullyBufferedSocket::Close();
+	if (idle_waiting)
+		partition->idle_clients.Remove(*this, idle_subscriptions);
+
+	if (socket != nullptr) {
+		/* send the pending response before closing the
+		   socket */
+		const bool flush = FlushOutput();
+		std::exchange(socket, nullptr)->Close(flush);
+	}
 
 	FormatInfo(client_domain, "[%u] closed", num);
 	delete this;
@@ -32,25 +32,28 @@
 
 inline CommandResult
 Client::ProcessCommandList(bool list_ok,
-			   std::list<std::string> &&list) noexcept
+			   std::string &&list) noexcept
 {
 	unsigned n = 0;
+	CommandResult result = CommandResult::OK;
 
-	for (auto &&i : list) {
-		char *cmd = &*i.begin();
-
+	CommandListBuilder::ForEachCommand(list, [&](char *cmd){
 		FormatDebug(client_domain, "process command \"%s\"", cmd);
 		auto ret = command_process(*this, n++, cmd);
 		FormatDebug(client_domain, "command returned %i", int(ret));
-		if (IsExpired())
-			return CommandResult::CLOSE;
-		else if (ret != CommandResult::OK)
-			return ret;
-		else if (list_ok)
+		if (IsExpired()) {
+			result = CommandResult::CLOSE;
+			return false;
+		} else if (ret != CommandResult::OK) {
+			result = ret;
+			return false;
+		} else if (list_ok)
 			Write("list_OK\n");
-	}
 
-	return CommandResult::OK;
+		return true;
+	});
+
+	return result;
 }
 
 CommandResult
@@ -71,7 +74,7 @@ Client::ProcessLine(char *line) noexcept
 	if (StringIsEqual(line, "noidle")) {
 		if (idle_waiting) {
 			/* send empty idle response and leave idle mode */
-			idle_waiting = false;
+			IdleCancel();
 			command_success(*this);
 		}
 
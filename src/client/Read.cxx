@@ -19,60 +19,114 @@
 
 #include "Client.hxx"
 #include "Config.hxx"
+#include "Domain.hxx"
+#include "Socket.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "util/StringStrip.hxx"
+#include "Log.hxx"
 
+#include <cassert>
 #include <cstring>
 
-BufferedSocket::InputResult
-Client::OnSocketInput(void *data, size_t length) noexcept
+bool
+Client::ProcessInput() noexcept
 {
-	if (background_command)
-		return InputResult::PAUSE;
+	std::size_t position = 0;
 
-	char *p = (char *)data;
-	char *newline = (char *)std::memchr(p, '\n', length);
-	if (newline == nullptr)
-		return InputResult::MORE;
+	while (!background_command && position < input.size()) {
+		char *p = input.data() + position;
+		char *newline = (char *)std::memchr(p, '\n',
+						    input.size() - position);
+		/* ClientSocket passes only complete lines */
+		assert(newline != nullptr);
 
-	timeout_event.Schedule(client_timeout);
+		position = newline + 1 - input.data();
 
-	BufferedSocket::ConsumeInput(newline + 1 - p);
+		timeout_event.Schedule(client_timeout);
 
-	/* skip whitespace at the end of the line */
-	char *end = StripRight(p, newline);
+		/* skip whitespace at the end of the line */
+		char *end = StripRight(p, newline);
 
-	/* terminate the string at the end of the line */
-	*end = 0;
+		/* terminate the string at the end of the line */
+		*end = 0;
 
-	CommandResult result = ProcessLine(p);
-	switch (result) {
-	case CommandResult::OK:
-	case CommandResult::IDLE:
-	case CommandResult::BACKGROUND:
-	case CommandResult::ERROR:
-		break;
+		CommandResult result = ProcessLine(p);
+		switch (result) {
+		case CommandResult::OK:
+		case CommandResult::IDLE:
+		case CommandResult::BACKGROUND:
+		case CommandResult::ERROR:
+			break;
 
-	case CommandResult::KILL:
-		partition->instance.Break();
-		Close();
-		return InputResult::CLOSED;
+		case CommandResult::KILL:
+			partition->instance.Break();
+			Close();
+			return false;
 
-	case CommandResult::FINISH:
-		if (Flush())
+		case CommandResult::FINISH:
+		case CommandResult::CLOSE:
 			Close();
-		return InputResult::CLOSED;
+			return false;
+		}
 
-	case CommandResult::CLOSE:
-		Close();
-		return InputResult::CLOSED;
+		if (IsExpired()) {
+			Close();
+			return false;
+		}
+
+		if (compression_pending) {
+			StartCompression();
+			if (IsExpired()) {
+				Close();
+				return false;
+			}
+		}
 	}
 
-	if (IsExpired()) {
+	input.erase(0, position);
+	return true;
+}
+
+void
+Client::OnSocketInput() noexcept
+{
+	assert(socket != nullptr);
+
+	const bool alive = socket->ReadInput(input);
+
+	/* process the lines received before the peer has closed the
+	   connection */
+	if (!ProcessInput())
+		return;
+
+	if (!alive)
+		/* the peer has shut down its side of the
+		   connection; send the pending response and close */
 		Close();
-		return InputResult::CLOSED;
+}
+
+void
+Client::OnDeferred() noexcept
+{
+	if (IsExpired())
+		return;
+
+	/* resume processing input after a BackgroundCommand has
+	   finished */
+	if (!background_command && !input.empty() && !ProcessInput())
+		return;
+
+	if (!FlushOutput()) {
+		FormatError(client_domain, "[%u] output buffer is full", num);
+		SetExpired();
+		return;
 	}
 
-	return InputResult::AGAIN;
+	if (input.empty() && !background_command && !idle_waiting &&
+	    !cmd_list.IsActive())
+		/* waiting for the next command: let the client thread
+		   answer simple queries by itself */
+		socket->EnableLocalCommands(partition->status_cache.shared,
+					    permission);
 }
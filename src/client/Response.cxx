@@ -21,6 +21,9 @@
 #include "Client.hxx"
 #include "util/FormatString.hxx"
 #include "util/AllocatedString.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <cstring>
 
 TagMask
 Response::GetTagMask() const noexcept
@@ -31,13 +34,18 @@ Response::GetTagMask() const noexcept
 bool
 Response::Write(const void *data, size_t length) noexcept
 {
+	if (capture != nullptr) {
+		capture->append((const char *)data, length);
+		return true;
+	}
+
 	return client.Write(data, length);
 }
 
 bool
 Response::Write(const char *data) noexcept
 {
-	return client.Write(data);
+	return Write(data, strlen(data));
 }
 
 bool
@@ -25,6 +25,8 @@
 
 #include <cstdarg>
 #include <cstddef>
+#include <string>
+#include <utility>
 
 template<typename T> struct ConstBuffer;
 class Client;
@@ -44,6 +46,12 @@ class Response {
 	 */
 	const char *command = "";
 
+	/**
+	 * If not nullptr, then all output is appended to this string
+	 * instead of being sent to the client.  See SetCapture().
+	 */
+	std::string *capture = nullptr;
+
 public:
 	Response(Client &_client, unsigned _list_index) noexcept
 		:client(_client), list_index(_list_index) {}
@@ -72,6 +80,17 @@ public:
 		command = _command;
 	}
 
+	/**
+	 * Redirect all output to the given string (or back to the
+	 * client if nullptr is passed).  This can be used to render
+	 * a response into a cache.
+	 *
+	 * @return the previous capture string
+	 */
+	std::string *SetCapture(std::string *_capture) noexcept {
+		return std::exchange(capture, _capture);
+	}
+
 	bool Write(const void *data, size_t length) noexcept;
 	bool Write(const char *data) noexcept;
 	bool FormatV(const char *fmt, std::va_list args) noexcept;
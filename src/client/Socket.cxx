@@ -0,0 +1,636 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Socket.hxx"
+#include "Thread.hxx"
+#include "Config.hxx"
+#include "Permission.hxx"
+#include "net/SocketError.hxx"
+#include "event/Loop.hxx"
+#include "util/Compiler.h"
+#include "util/StringStrip.hxx"
+#include "Log.hxx"
+
+#ifdef HAVE_URING
+#include "io/uring/Queue.hxx"
+#endif
+
+#include <cassert>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+ClientSocket::ClientSocket(ClientThread &_thread, SocketDescriptor fd,
+			   EventLoop &main_loop,
+			   BoundMethod<void() noexcept> input_callback) noexcept
+	:thread(_thread),
+	 event(thread.GetEventLoop(), BIND_THIS_METHOD(OnSocketReady), fd),
+	 input_event(main_loop, input_callback),
+	 output_event(thread.GetEventLoop(), BIND_THIS_METHOD(OnOutput))
+{
+	/* the first OnOutput() call begins reading from the socket */
+	output_event.Schedule();
+}
+
+ClientSocket::~ClientSocket() noexcept
+{
+	CloseSocket();
+}
+
+void
+ClientSocket::CloseSocket() noexcept
+{
+#ifdef HAVE_URING
+	if (uring != nullptr && event.IsDefined()) {
+		if (recv_operation)
+			recv_operation.release()->Cancel();
+		if (send_operation)
+			send_operation.release()->Cancel();
+
+		/* closing the descriptor would not abort the pending
+		   operations, because io_uring holds a reference to
+		   the socket; shutting it down completes them */
+		event.GetSocket().Shutdown();
+	}
+#endif
+
+	event.Close();
+}
+
+void
+ClientSocket::ScheduleRead() noexcept
+{
+#ifdef HAVE_URING
+	if (uring != nullptr) {
+		StartRecv();
+		return;
+	}
+#endif
+
+	event.ScheduleRead();
+}
+
+void
+ClientSocket::CancelRead() noexcept
+{
+#ifdef HAVE_URING
+	if (uring != nullptr) {
+		/* OnRecv() will not submit another single-shot
+		   operation, but a multishot operation must be
+		   stopped */
+		if (recv_operation)
+			recv_operation->Stop();
+		return;
+	}
+#endif
+
+	event.CancelRead();
+}
+
+void
+ClientSocket::Destroy() noexcept
+{
+	thread.Remove(*this);
+	delete this;
+}
+
+bool
+ClientSocket::ReadInput(std::string &dest) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	if (dest.empty())
+		dest.swap(input);
+	else
+		dest.append(input);
+	input.clear();
+
+	if (input_paused) {
+		input_paused = false;
+		resume_input = true;
+		output_event.Schedule();
+	}
+
+	return !hangup;
+}
+
+bool
+ClientSocket::WriteOutput(std::string &src, std::size_t max_size) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	if (output.size() + pending_send + src.size() > max_size)
+		return false;
+
+	if (output.empty())
+		/* swap instead of copying; this also passes the
+		   buffer capacity back and forth */
+		output.swap(src);
+	else
+		output.append(src);
+	src.clear();
+
+	output_event.Schedule();
+	return true;
+}
+
+void
+ClientSocket::EnableCompression() noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	assert(!compress_requested);
+
+	compress_requested = true;
+	compress_offset = output.size();
+}
+
+void
+ClientSocket::EnableLocalCommands(std::shared_ptr<const StatusCache::Shared> status,
+				  unsigned permission) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	if (!input.empty())
+		/* more commands are already waiting for the Client;
+		   a local response would overtake their responses */
+		return;
+
+	local_status = std::move(status);
+	local_permission = permission;
+	local_commands = true;
+}
+
+bool
+ClientSocket::CheckLocalActivity() noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+	return std::exchange(local_activity, false);
+}
+
+void
+ClientSocket::Close(bool flush) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+
+	closing = true;
+	flush_on_close = flush;
+
+	/* the client thread does not schedule this event anymore
+	   after it has seen the "closing" flag */
+	input_event.Cancel();
+
+	output_event.Schedule();
+}
+
+void
+ClientSocket::Hangup(bool abort) noexcept
+{
+	if (abort)
+		CloseSocket();
+	else
+		CancelRead();
+
+	const std::lock_guard<Mutex> lock(mutex);
+	hangup = true;
+
+	if (closing)
+		/* the Client is already gone; let OnOutput() delete
+		   this object */
+		output_event.Schedule();
+	else
+		input_event.Schedule();
+}
+
+void
+ClientSocket::Receive() noexcept
+{
+	char buffer[16384];
+	const auto nbytes = event.GetSocket().Read(buffer, sizeof(buffer));
+	if (gcc_unlikely(nbytes <= 0)) {
+		if (nbytes == 0) {
+			/* the peer may have shut down only its
+			   sending side, so keep the socket open for
+			   the response */
+			Hangup(false);
+			return;
+		}
+
+		const auto code = GetSocketError();
+		if (IsSocketErrorReceiveWouldBlock(code))
+			return;
+
+		if (IsSocketErrorClosed(code))
+			Hangup(true);
+		else
+			OnSocketError(std::make_exception_ptr(MakeSocketError(code, "Failed to receive from socket")));
+		return;
+	}
+
+	if (!OnReceived({buffer, std::size_t(nbytes)}))
+		event.CancelRead();
+}
+
+bool
+ClientSocket::OnReceived(std::string_view src) noexcept
+{
+	const auto newline = src.rfind('\n');
+	if (newline == src.npos) {
+		partial.append(src);
+		if (partial.size() >= MAX_LINE) {
+			OnSocketError(std::make_exception_ptr(std::runtime_error("Input buffer is full")));
+			return false;
+		}
+
+		return true;
+	}
+
+	const std::lock_guard<Mutex> lock(mutex);
+
+	if (closing)
+		/* the Client is gone and doesn't want any more
+		   input */
+		return false;
+
+	if (!partial.empty()) {
+		/* complete the pending line first */
+		const auto eol = src.find('\n');
+		partial.append(src.substr(0, eol + 1));
+		PushLines(partial);
+		src = src.substr(eol + 1);
+	}
+
+	PushLines(src.substr(0, src.rfind('\n') + 1));
+	partial.assign(src.substr(src.rfind('\n') + 1));
+
+	if (input.size() >= MAX_PENDING_INPUT) {
+		/* wait for the Client to catch up; ReadInput() will
+		   resume */
+		input_paused = true;
+		return false;
+	}
+
+	return true;
+}
+
+void
+ClientSocket::PushLines(std::string_view src) noexcept
+{
+	while (local_commands && !src.empty()) {
+		const auto eol = src.find('\n');
+		if (!ExecuteLocal(src.substr(0, eol))) {
+			local_commands = false;
+			break;
+		}
+
+		src = src.substr(eol + 1);
+	}
+
+	if (!src.empty()) {
+		input.append(src);
+		input_event.Schedule();
+	}
+}
+
+bool
+ClientSocket::ExecuteLocal(std::string_view line) noexcept
+{
+	line = line.substr(0, StripRight(line.data(), line.size()));
+
+	/* leave room for the largest local response; if the buffer
+	   is full, the Client shall deal with it */
+	if (output.size() + pending_send + 4096 > client_max_output_buffer_size)
+		return false;
+
+	if (line == "status") {
+		if ((local_permission & PERMISSION_READ) == 0 ||
+		    local_status == nullptr)
+			return false;
+
+		const auto now = thread.GetEventLoop().SteadyNow();
+		const auto status = local_status->GetStatus(now);
+		if (status == nullptr)
+			/* the cache is stale; let the main thread
+			   render a new response */
+			return false;
+
+		const auto old_size = output.size();
+		try {
+			status->AppendTo(output, now);
+		} catch (...) {
+			output.resize(old_size);
+			return false;
+		}
+	} else if (line != "ping")
+		return false;
+
+	output.append("OK\n");
+	local_activity = true;
+	output_event.Schedule();
+	return true;
+}
+
+bool
+ClientSocket::TakeOutput(std::string &dest) noexcept
+{
+	assert(dest.empty());
+
+#ifdef ENABLE_ZLIB
+	bool start_compression;
+	std::size_t plain_size;
+#endif
+
+	{
+		const std::lock_guard<Mutex> lock(mutex);
+		dest.swap(output);
+		pending_send = dest.size();
+
+#ifdef ENABLE_ZLIB
+		start_compression = std::exchange(compress_requested, false);
+		plain_size = start_compression ? compress_offset : 0;
+#endif
+	}
+
+#ifdef ENABLE_ZLIB
+	try {
+		if (start_compression)
+			deflate = std::make_unique<DeflateEncoder>();
+
+		if (deflate && plain_size < dest.size()) {
+			deflate_input.assign(dest, plain_size);
+			dest.resize(plain_size);
+			deflate->Encode(deflate_input, dest);
+			deflate_input.clear();
+		}
+	} catch (...) {
+		OnSocketError(std::current_exception());
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+bool
+ClientSocket::Flush() noexcept
+{
+	assert(event.IsDefined());
+
+#ifdef HAVE_URING
+	if (uring != nullptr)
+		return UringFlush();
+#endif
+
+	while (true) {
+		if (sending_position == sending.size()) {
+			sending.clear();
+			sending_position = 0;
+
+			if (!TakeOutput(sending))
+				return false;
+
+			if (sending.empty())
+				break;
+		}
+
+		const std::string_view rest(sending.data() + sending_position,
+					    sending.size() - sending_position);
+		const auto nbytes = event.GetSocket().Write(rest.data(),
+							    rest.size());
+		if (gcc_unlikely(nbytes < 0)) {
+			const auto code = GetSocketError();
+			if (IsSocketErrorSendWouldBlock(code)) {
+				event.ScheduleWrite();
+				return true;
+			}
+
+			if (IsSocketErrorClosed(code))
+				Hangup(true);
+			else
+				OnSocketError(std::make_exception_ptr(MakeSocketError(code, "Failed to send to socket")));
+			return false;
+		}
+
+		sending_position += nbytes;
+	}
+
+	event.CancelWrite();
+
+	bool close;
+
+	{
+		const std::lock_guard<Mutex> lock(mutex);
+		close = closing;
+	}
+
+	if (close) {
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void
+ClientSocket::OnOutput() noexcept
+{
+	bool close, flush, resume;
+
+	{
+		const std::lock_guard<Mutex> lock(mutex);
+		close = closing;
+		flush = flush_on_close;
+		resume = std::exchange(resume_input, false);
+	}
+
+	if (close && (!flush || !event.IsDefined())) {
+		Destroy();
+		return;
+	}
+
+	if (!event.IsDefined())
+		/* the peer has closed the connection; wait for the
+		   Client to call Close() */
+		return;
+
+	if (!started) {
+		started = true;
+		resume = true;
+
+#ifdef HAVE_URING
+		if (thread.IsUringEnabled())
+			uring = thread.GetEventLoop().GetUring();
+#endif
+	}
+
+	if (close)
+		/* no more input after the Client has closed the
+		   connection */
+		CancelRead();
+
+	if (!Flush())
+		return;
+
+	if (resume && !close)
+		ScheduleRead();
+}
+
+void
+ClientSocket::OnSocketError(std::exception_ptr ep) noexcept
+{
+	LogError(ep, "error on client socket");
+
+	Hangup(true);
+}
+
+void
+ClientSocket::OnSocketReady(unsigned flags) noexcept
+{
+	if (flags & SocketEvent::ERROR) {
+		Hangup(true);
+		return;
+	}
+
+	if (flags & SocketEvent::WRITE) {
+		if (!Flush())
+			return;
+	}
+
+	if (flags & SocketEvent::READ)
+		/* on HANGUP, read the pending input first;
+		   Receive() will see the end of the stream */
+		Receive();
+	else if (flags & SocketEvent::HANGUP) {
+		/* reading is paused because the Client has not yet
+		   consumed all input; stop polling until ReadInput()
+		   resumes reading, which will then see the end of the
+		   stream */
+		if (!event.IsWritePending())
+			event.Cancel();
+	}
+}
+
+#ifdef HAVE_URING
+
+void
+ClientSocket::StartRecv() noexcept
+{
+	assert(uring != nullptr);
+
+	if (!recv_operation)
+		recv_operation = std::make_unique<Uring::RecvOperation>();
+
+	const auto fd = event.GetSocket().ToFileDescriptor();
+
+	try {
+#ifdef HAVE_URING_RECV_MULTISHOT
+		if (auto *buffer_ring = uring->GetBufferRing();
+		    buffer_ring != nullptr) {
+			recv_operation->StartMultishot(*uring, fd,
+						       *buffer_ring, *this);
+			return;
+		}
+#endif
+
+		if (!recv_operation->IsUringPending())
+			recv_operation->Start(*uring, fd, 16384, *this);
+	} catch (...) {
+		OnSocketError(std::current_exception());
+	}
+}
+
+bool
+ClientSocket::UringFlush() noexcept
+{
+	if (!send_operation)
+		send_operation = std::make_unique<Uring::SendOperation>();
+	else if (send_operation->IsUringPending())
+		/* OnSend() will call this method again */
+		return true;
+
+	if (!TakeOutput(send_operation->GetBuffer()))
+		return false;
+
+	bool close;
+
+	{
+		const std::lock_guard<Mutex> lock(mutex);
+		close = closing;
+	}
+
+	if (send_operation->GetBuffer().empty()) {
+		if (close) {
+			Destroy();
+			return false;
+		}
+
+		return true;
+	}
+
+	try {
+		send_operation->Start(*uring, event.GetSocket().ToFileDescriptor(),
+				      *this);
+	} catch (...) {
+		OnSocketError(std::current_exception());
+		return false;
+	}
+
+	return true;
+}
+
+void
+ClientSocket::OnRecv(const void *data, std::size_t size) noexcept
+{
+	if (size == 0) {
+		Hangup(false);
+		return;
+	}
+
+	if (!OnReceived({(const char *)data, size}))
+		CancelRead();
+	else if (event.IsDefined())
+		StartRecv();
+}
+
+void
+ClientSocket::OnRecvError(int error) noexcept
+{
+	if (IsSocketErrorClosed(error))
+		Hangup(true);
+	else
+		OnSocketError(std::make_exception_ptr(MakeSocketError(error, "Failed to receive from socket")));
+}
+
+void
+ClientSocket::OnSend() noexcept
+{
+	if (event.IsDefined())
+		UringFlush();
+}
+
+void
+ClientSocket::OnSendError(int error) noexcept
+{
+	if (IsSocketErrorClosed(error))
+		Hangup(true);
+	else
+		OnSocketError(std::make_exception_ptr(MakeSocketError(error, "Failed to send to socket")));
+}
+
+#endif
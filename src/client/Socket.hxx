@@ -0,0 +1,411 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_CLIENT_SOCKET_HXX
+#define MPD_CLIENT_SOCKET_HXX
+
+#include "event/SocketEvent.hxx"
+#include "event/InjectEvent.hxx"
+#include "thread/Mutex.hxx"
+#include "util/BindMethod.hxx"
+#include "util/IntrusiveList.hxx"
+#include "io/uring/Features.h"
+#include "StatusCache.hxx"
+#include "config.h"
+
+#ifdef HAVE_URING
+#include "io/uring/RecvOperation.hxx"
+#include "io/uring/SendOperation.hxx"
+#endif
+
+#ifdef ENABLE_ZLIB
+#include "lib/zlib/DeflateEncoder.hxx"
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class ClientThread;
+
+/**
+ * The socket of a #Client.  It lives in the #EventLoop of a
+ * #ClientThread, which performs all socket I/O, while the #Client
+ * itself (and all command handlers) live in the main thread.  The two
+ * exchange complete request lines and response data through buffers
+ * protected by a mutex.
+ *
+ * While the #Client is waiting for the next command, the client
+ * thread executes some read-only commands (e.g. "status") itself;
+ * see EnableLocalCommands().
+ *
+ * If the #ClientThread has enabled io_uring, sockets are read and
+ * written with io_uring operations instead of waiting for readiness
+ * and calling recv()/send().
+ *
+ * After construction, this object is owned by the #ClientThread; the
+ * #Client gives up its reference by calling Close().
+ */
+class ClientSocket final
+	: public IntrusiveListHook
+#ifdef HAVE_URING
+	, Uring::RecvHandler, Uring::SendHandler
+#endif
+{
+	/**
+	 * The maximum length of a request line.
+	 */
+	static constexpr std::size_t MAX_LINE = 8192;
+
+	/**
+	 * Stop reading from the socket if there are more than this
+	 * number of bytes of unprocessed input.
+	 */
+	static constexpr std::size_t MAX_PENDING_INPUT = 64 * 1024;
+
+	ClientThread &thread;
+
+	SocketEvent event;
+
+	/**
+	 * Scheduled in the main thread when there is new input or
+	 * when the peer has closed the connection.
+	 */
+	InjectEvent input_event;
+
+	/**
+	 * Scheduled in the client thread when there is new output,
+	 * when input shall be resumed or when the #Client has closed
+	 * the connection.
+	 */
+	InjectEvent output_event;
+
+	Mutex mutex;
+
+	/**
+	 * Complete request lines which were not yet consumed by the
+	 * #Client.  Protected by #mutex.
+	 */
+	std::string input;
+
+	/**
+	 * Response data submitted by the #Client.  Protected by
+	 * #mutex.
+	 */
+	std::string output;
+
+	/**
+	 * The number of bytes which were taken from #output by the
+	 * client thread, but have not been sent yet.  They count
+	 * against the output buffer limit.  Protected by #mutex.
+	 */
+	std::size_t pending_send = 0;
+
+	/**
+	 * The status cache of the #Client's partition, used to
+	 * answer "status" in the client thread.  Protected by
+	 * #mutex.
+	 */
+	std::shared_ptr<const StatusCache::Shared> local_status;
+
+	/**
+	 * The permissions of the #Client.  Protected by #mutex.
+	 */
+	unsigned local_permission = 0;
+
+	/**
+	 * May the client thread execute commands itself?  This is
+	 * only allowed while the #Client waits for the next command
+	 * and all of its responses have been submitted, because a
+	 * local response must not overtake another one.  Cleared
+	 * when a request line is passed to the #Client.  Protected by
+	 * #mutex.
+	 */
+	bool local_commands = false;
+
+	/**
+	 * Was a command executed by the client thread since the last
+	 * CheckLocalActivity() call?  Protected by #mutex.
+	 */
+	bool local_activity = false;
+
+	/**
+	 * Was reading paused because #input is full?  Protected by
+	 * #mutex.
+	 */
+	bool input_paused = false;
+
+	/**
+	 * Shall reading be resumed?  Protected by #mutex.
+	 */
+	bool resume_input = false;
+
+	/**
+	 * Has the peer closed the connection (or was there a socket
+	 * error)?  Protected by #mutex.
+	 */
+	bool hangup = false;
+
+	/**
+	 * Has the #Client called Close()?  Protected by #mutex.
+	 */
+	bool closing = false;
+
+	/**
+	 * Shall pending output be sent before closing?  Protected by
+	 * #mutex.
+	 */
+	bool flush_on_close;
+
+	/**
+	 * Has the #Client called EnableCompression()?  Protected by
+	 * #mutex.
+	 */
+	bool compress_requested = false;
+
+	/**
+	 * The number of bytes at the beginning of #output which shall
+	 * not be compressed; only valid if #compress_requested is
+	 * set.  Protected by #mutex.
+	 */
+	std::size_t compress_offset;
+
+	/**
+	 * Has the client thread begun serving this socket?  Only
+	 * accessed by the client thread.
+	 */
+	bool started = false;
+
+	/**
+	 * An incomplete request line.  Only accessed by the client
+	 * thread.
+	 */
+	std::string partial;
+
+	/**
+	 * Data taken from #output which is being sent.  Only
+	 * accessed by the client thread.
+	 */
+	std::string sending;
+
+	/**
+	 * The number of bytes of #sending which have already been
+	 * sent.
+	 */
+	std::size_t sending_position = 0;
+
+#ifdef ENABLE_ZLIB
+	/**
+	 * Compresses all output after EnableCompression() was
+	 * called.  Only accessed by the client thread.
+	 */
+	std::unique_ptr<DeflateEncoder> deflate;
+
+	/**
+	 * Uncompressed output being passed to #deflate.  This is a
+	 * member only to reuse its allocation.
+	 */
+	std::string deflate_input;
+#endif
+
+#ifdef HAVE_URING
+	/**
+	 * The io_uring queue of the client thread; nullptr if the
+	 * socket is served with #event.
+	 */
+	Uring::Queue *uring = nullptr;
+
+	std::unique_ptr<Uring::RecvOperation> recv_operation;
+	std::unique_ptr<Uring::SendOperation> send_operation;
+#endif
+
+public:
+	/**
+	 * Construct the object and tell the #ClientThread to begin
+	 * serving it.  Must be called in the main thread.
+	 *
+	 * @param main_loop the #EventLoop of the #Client
+	 * @param input_callback invoked in the main thread when
+	 * ReadInput() has something to report
+	 */
+	ClientSocket(ClientThread &_thread, SocketDescriptor fd,
+		     EventLoop &main_loop,
+		     BoundMethod<void() noexcept> input_callback) noexcept;
+
+	~ClientSocket() noexcept;
+
+	ClientSocket(const ClientSocket &) = delete;
+	ClientSocket &operator=(const ClientSocket &) = delete;
+
+	/**
+	 * Move pending request lines to the end of the given buffer.
+	 * Only complete lines are passed.  Must be called in the main
+	 * thread.
+	 *
+	 * @return false if the peer has closed the connection
+	 */
+	bool ReadInput(std::string &dest) noexcept;
+
+	/**
+	 * Submit response data, clearing the given buffer.  Must be
+	 * called in the main thread.
+	 *
+	 * @param max_size the maximum number of bytes which may be
+	 * queued
+	 * @return false if the output buffer is full
+	 */
+	bool WriteOutput(std::string &src, std::size_t max_size) noexcept;
+
+	/**
+	 * Compress all output which is submitted after this call
+	 * with "deflate".  Must be called in the main thread.
+	 */
+	void EnableCompression() noexcept;
+
+	/**
+	 * Allow the client thread to execute read-only commands
+	 * until the next request line is passed to the #Client.  This
+	 * has no effect if there is unconsumed input.  Must be called
+	 * in the main thread after all responses have been submitted.
+	 *
+	 * @param status the status cache of the #Client's partition
+	 * @param permission the permissions of the #Client
+	 */
+	void EnableLocalCommands(std::shared_ptr<const StatusCache::Shared> status,
+				 unsigned permission) noexcept;
+
+	/**
+	 * Were commands executed by the client thread since the last
+	 * call?  Must be called in the main thread.
+	 */
+	bool CheckLocalActivity() noexcept;
+
+	/**
+	 * Detach this object from the #Client and close the socket
+	 * asynchronously.  Must be called in the main thread; the
+	 * caller must not use this object afterwards.
+	 *
+	 * @param flush send pending output before closing
+	 */
+	void Close(bool flush) noexcept;
+
+private:
+	/**
+	 * Remove this object from the #ClientThread and delete it.
+	 */
+	void Destroy() noexcept;
+
+	/**
+	 * Mark the connection as closed by the peer and notify the
+	 * #Client.
+	 *
+	 * @param abort true if the socket is unusable and shall be
+	 * closed; false if the peer has only shut down its sending
+	 * side and may still receive the response
+	 */
+	void Hangup(bool abort) noexcept;
+
+	/**
+	 * Close the socket, cancelling all pending operations.
+	 */
+	void CloseSocket() noexcept;
+
+	/**
+	 * Begin receiving data from the socket.
+	 */
+	void ScheduleRead() noexcept;
+
+	/**
+	 * Stop receiving data from the socket.
+	 */
+	void CancelRead() noexcept;
+
+	/**
+	 * Read from the socket and pass complete lines to the
+	 * #Client.
+	 */
+	void Receive() noexcept;
+
+	/**
+	 * Pass complete lines from the given data to the #Client.
+	 *
+	 * @return true if more data shall be received
+	 */
+	bool OnReceived(std::string_view src) noexcept;
+
+	/**
+	 * Execute the given complete lines locally if possible, and
+	 * pass the rest to the #Client.  Caller must lock #mutex.
+	 */
+	void PushLines(std::string_view src) noexcept;
+
+	/**
+	 * Execute the given command in the client thread if
+	 * possible, appending the response to #output.  Caller must
+	 * lock #mutex.
+	 *
+	 * @param line a request line without the newline character
+	 * @return true if the command was executed, false if it must
+	 * be passed to the #Client
+	 */
+	bool ExecuteLocal(std::string_view line) noexcept;
+
+	/**
+	 * Move all output submitted by the #Client to the given
+	 * (empty) buffer, compressing it if enabled.
+	 *
+	 * @return false if the socket was closed due to an error
+	 */
+	bool TakeOutput(std::string &dest) noexcept;
+
+	/**
+	 * Send as much pending output as possible.  Deletes this
+	 * object if the #Client has closed the connection and all
+	 * output has been sent.
+	 *
+	 * @return false if the socket was closed or this object was
+	 * deleted
+	 */
+	bool Flush() noexcept;
+
+	/**
+	 * Log the error and close the socket.
+	 */
+	void OnSocketError(std::exception_ptr ep) noexcept;
+
+	void OnOutput() noexcept;
+	void OnSocketReady(unsigned flags) noexcept;
+
+#ifdef HAVE_URING
+	void StartRecv() noexcept;
+	bool UringFlush() noexcept;
+
+	/* virtual methods from class Uring::RecvHandler */
+	void OnRecv(const void *data, std::size_t size) noexcept override;
+	void OnRecvError(int error) noexcept override;
+
+	/* virtual methods from class Uring::SendHandler */
+	void OnSend() noexcept override;
+	void OnSendError(int error) noexcept override;
+#endif
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Thread.hxx"
+#include "Socket.hxx"
+#include "event/Call.hxx"
+#include "event/Thread.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "util/DeleteDisposer.hxx"
+
+ClientThread::ClientThread(EventLoop &_loop, bool _uring_enabled) noexcept
+	:loop(_loop), uring_enabled(_uring_enabled)
+{
+}
+
+ClientThread::ClientThread(bool _uring_enabled)
+	:thread(std::make_unique<EventThread>()),
+	 loop(thread->GetEventLoop()),
+	 uring_enabled(_uring_enabled)
+{
+}
+
+ClientThread::~ClientThread() noexcept
+{
+	/* the sockets must be deleted inside the EventLoop, before
+	   the thread gets stopped */
+	BlockingCall(loop, [this](){
+		const std::lock_guard<Mutex> lock(mutex);
+		sockets.clear_and_dispose(DeleteDisposer());
+	});
+}
+
+void
+ClientThread::Start()
+{
+	if (thread)
+		thread->Start();
+}
+
+ClientSocket &
+ClientThread::AddSocket(UniqueSocketDescriptor &&fd, EventLoop &main_loop,
+			BoundMethod<void() noexcept> input_callback)
+{
+	auto *socket = new ClientSocket(*this, fd.Release(),
+					main_loop, input_callback);
+
+	const std::lock_guard<Mutex> lock(mutex);
+	sockets.push_back(*socket);
+	return *socket;
+}
+
+void
+ClientThread::Remove(ClientSocket &socket) noexcept
+{
+	const std::lock_guard<Mutex> lock(mutex);
+	socket.unlink();
+}
+
+ClientThreadList::ClientThreadList(EventLoop &main_loop, unsigned n,
+				   bool uring_enabled)
+{
+	if (n == 0)
+		threads.emplace_front(main_loop, uring_enabled);
+	else
+		for (unsigned i = 0; i < n; ++i)
+			threads.emplace_front(uring_enabled);
+
+	next = threads.begin();
+}
+
+void
+ClientThreadList::Start()
+{
+	for (auto &i : threads)
+		i.Start();
+}
+
+ClientThread &
+ClientThreadList::Next() noexcept
+{
+	auto &thread = *next;
+	if (++next == threads.end())
+		next = threads.begin();
+	return thread;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_CLIENT_THREAD_HXX
+#define MPD_CLIENT_THREAD_HXX
+
+#include "thread/Mutex.hxx"
+#include "util/BindMethod.hxx"
+#include "util/IntrusiveList.hxx"
+
+#include <forward_list>
+#include <memory>
+
+class EventLoop;
+class EventThread;
+class ClientSocket;
+class UniqueSocketDescriptor;
+
+/**
+ * An #EventLoop which performs the socket I/O of clients.  This is
+ * either a dedicated thread or the main thread.
+ */
+class ClientThread final {
+	/**
+	 * The dedicated thread; nullptr if clients are served by the
+	 * main thread.
+	 */
+	const std::unique_ptr<EventThread> thread;
+
+	EventLoop &loop;
+
+	/**
+	 * Shall sockets use io_uring instead of readiness
+	 * notifications (if available)?
+	 */
+	const bool uring_enabled;
+
+	/**
+	 * Protects #sockets.
+	 */
+	Mutex mutex;
+
+	/**
+	 * All sockets served by this thread.  Sockets are added by
+	 * the main thread and removed by this thread.
+	 */
+	IntrusiveList<ClientSocket> sockets;
+
+public:
+	/**
+	 * Serve clients in the given (main) #EventLoop.
+	 */
+	ClientThread(EventLoop &_loop, bool _uring_enabled) noexcept;
+
+	/**
+	 * Serve clients in a new thread.
+	 */
+	explicit ClientThread(bool _uring_enabled);
+
+	~ClientThread() noexcept;
+
+	ClientThread(const ClientThread &) = delete;
+	ClientThread &operator=(const ClientThread &) = delete;
+
+	EventLoop &GetEventLoop() const noexcept {
+		return loop;
+	}
+
+	bool IsUringEnabled() const noexcept {
+		return uring_enabled;
+	}
+
+	void Start();
+
+	/**
+	 * Create a new #ClientSocket served by this thread.  Must be
+	 * called in the main thread.
+	 *
+	 * @param input_callback see #ClientSocket
+	 */
+	ClientSocket &AddSocket(UniqueSocketDescriptor &&fd, EventLoop &main_loop,
+				BoundMethod<void() noexcept> input_callback);
+
+	/**
+	 * Called by #ClientSocket before it deletes itself.  Must be
+	 * called inside the #EventLoop.
+	 */
+	void Remove(ClientSocket &socket) noexcept;
+};
+
+/**
+ * The #ClientThread instances; new connections are distributed among
+ * them in a round-robin fashion.
+ */
+class ClientThreadList final {
+	std::forward_list<ClientThread> threads;
+
+	std::forward_list<ClientThread>::iterator next;
+
+public:
+	/**
+	 * @param n the number of dedicated client threads; 0 means
+	 * that clients are served by the main thread
+	 * @param uring_enabled use io_uring for socket I/O (if
+	 * available)
+	 */
+	ClientThreadList(EventLoop &main_loop, unsigned n,
+			 bool uring_enabled);
+
+	void Start();
+
+	/**
+	 * Choose the thread for a new connection.
+	 */
+	ClientThread &Next() noexcept;
+};
+
+#endif
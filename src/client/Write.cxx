@@ -18,14 +18,38 @@
  */
 
 #include "Client.hxx"
+#include "Config.hxx"
+#include "Domain.hxx"
+#include "Socket.hxx"
+#include "Log.hxx"
 
+#include <cassert>
 #include <string.h>
 
+std::size_t
+Client::GetOutputMaxSize() const noexcept
+{
+	return client_max_output_buffer_size;
+}
+
 bool
 Client::Write(const void *data, size_t length) noexcept
 {
 	/* if the client is going to be closed, do nothing */
-	return !IsExpired() && FullyBufferedSocket::Write(data, length);
+	if (IsExpired())
+		return false;
+
+	if (output.size() + length > client_max_output_buffer_size) {
+		FormatError(client_domain, "[%u] output buffer is full", num);
+		SetExpired();
+		return false;
+	}
+
+	output.append((const char *)data, length);
+
+	/* submit all output of this EventLoop iteration at once */
+	defer_event.Schedule();
+	return true;
 }
 
 bool
@@ -33,3 +57,39 @@ Client::Write(const char *data) noexcept
 {
 	return Write(data, strlen(data));
 }
+
+bool
+Client::FlushOutput() noexcept
+{
+	assert(socket != nullptr);
+
+	return output.empty() ||
+		socket->WriteOutput(output, client_max_output_buffer_size);
+}
+
+bool
+Client::RequestCompression() noexcept
+{
+	if (compression)
+		return false;
+
+	compression = compression_pending = true;
+	return true;
+}
+
+void
+Client::StartCompression() noexcept
+{
+	assert(compression_pending);
+	assert(socket != nullptr);
+
+	compression_pending = false;
+
+	if (!FlushOutput()) {
+		FormatError(client_domain, "[%u] output buffer is full", num);
+		SetExpired();
+		return;
+	}
+
+	socket->EnableCompression();
+}
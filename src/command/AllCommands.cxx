@@ -43,6 +43,7 @@
 #include "client/Response.hxx"
 #include "util/Tokenizer.hxx"
 #include "util/StringAPI.hxx"
+#include "util/StringPerfectHash.hxx"
 
 #ifdef ENABLE_SQLITE
 #include "StickerCommands.hxx"
@@ -94,6 +95,9 @@ static constexpr struct command commands[] = {
 	{ "cleartagid", PERMISSION_ADD, 1, 2, handle_cleartagid },
 	{ "close", PERMISSION_NONE, -1, -1, handle_close },
 	{ "commands", PERMISSION_NONE, 0, 0, handle_commands },
+#ifdef ENABLE_ZLIB
+	{ "compress", PERMISSION_NONE, 1, 1, handle_compress },
+#endif
 	{ "config", PERMISSION_ADMIN, 0, 0, handle_config },
 	{ "consume", PERMISSION_CONTROL, 1, 1, handle_consume },
 #ifdef ENABLE_DATABASE
@@ -216,6 +220,14 @@ static constexpr struct command commands[] = {
 
 static constexpr unsigned num_commands = std::size(commands);
 
+/**
+ * Maps command names to indexes in #commands; initialized by
+ * command_init().
+ */
+static StringPerfectHash<2048> command_hash;
+
+static_assert(num_commands <= decltype(command_hash)::MAX_KEYS);
+
 gcc_pure
 static bool
 command_available([[maybe_unused]] const Partition &partition,
@@ -294,12 +306,25 @@ command_init() noexcept
 	for (unsigned i = 0; i < num_commands - 1; ++i)
 		assert(strcmp(commands[i].cmd, commands[i + 1].cmd) < 0);
 #endif
+
+	/* this should always succeed; if it does not, command_lookup()
+	   falls back to binary search */
+	command_hash.Build(num_commands, [](std::size_t i){
+		return std::string_view(commands[i].cmd);
+	});
 }
 
-gcc_pure
-static const struct command *
+const struct command *
 command_lookup(const char *name) noexcept
 {
+	if (command_hash.IsDefined()) {
+		const int i = command_hash.Find(name);
+		if (i < 0 || !StringIsEqual(commands[i].cmd, name))
+			return nullptr;
+
+		return &commands[i];
+	}
+
 	unsigned a = 0, b = num_commands, i;
 
 	/* binary search */
@@ -21,12 +21,23 @@
 #define MPD_ALL_COMMANDS_HXX
 
 #include "CommandResult.hxx"
+#include "util/Compiler.h"
 
 class Client;
+struct command;
 
 void
 command_init() noexcept;
 
+/**
+ * Look up a command by its name.
+ *
+ * @return the command or nullptr if there is no such command
+ */
+gcc_pure
+const struct command *
+command_lookup(const char *name) noexcept;
+
 CommandResult
 command_process(Client &client, unsigned num, char *line) noexcept;
 
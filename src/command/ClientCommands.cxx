@@ -55,6 +55,22 @@ handle_binary_limit(Client &client, Request args,
 	return CommandResult::OK;
 }
 
+CommandResult
+handle_compress(Client &client, Request args, Response &r)
+{
+	if (!StringIsEqual(args.front(), "deflate")) {
+		r.Error(ACK_ERROR_ARG, "Unsupported compression method");
+		return CommandResult::ERROR;
+	}
+
+	if (!client.RequestCompression()) {
+		r.Error(ACK_ERROR_ARG, "Compression is already enabled");
+		return CommandResult::ERROR;
+	}
+
+	return CommandResult::OK;
+}
+
 CommandResult
 handle_password(Client &client, Request args, Response &r)
 {
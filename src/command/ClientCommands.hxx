@@ -35,6 +35,9 @@ handle_ping(Client &client, Request request, Response &response);
 CommandResult
 handle_binary_limit(Client &client, Request request, Response &response);
 
+CommandResult
+handle_compress(Client &client, Request request, Response &response);
+
 CommandResult
 handle_password(Client &client, Request request, Response &response);
 
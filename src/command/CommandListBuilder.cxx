@@ -33,10 +33,9 @@ bool
 CommandListBuilder::Add(const char *cmd)
 {
 	size_t len = strlen(cmd) + 1;
-	size += len;
-	if (size > client_max_command_list_size)
+	if (list.size() + len > client_max_command_list_size)
 		return false;
 
-	list.emplace_back(cmd);
+	list.append(cmd, len);
 	return true;
 }
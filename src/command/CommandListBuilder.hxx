@@ -21,7 +21,6 @@
 #define MPD_COMMAND_LIST_BUILDER_HXX
 
 #include <cassert>
-#include <list>
 #include <string>
 
 class CommandListBuilder {
@@ -46,14 +45,12 @@ class CommandListBuilder {
 	} mode = Mode::DISABLED;
 
 	/**
-	 * for when in list mode
+	 * for when in list mode: all commands, each one terminated by
+	 * a null byte, in one contiguous buffer, so they can be
+	 * tokenized in place without allocating memory for each
+	 * command
 	 */
-	std::list<std::string> list;
-
-	/**
-	 * Memory consumed by the list.
-	 */
-	size_t size;
+	std::string list;
 
 public:
 	/**
@@ -85,7 +82,6 @@ public:
 		assert(mode == Mode::DISABLED);
 
 		mode = (Mode)ok;
-		size = 0;
 	}
 
 	/**
@@ -94,13 +90,42 @@ public:
 	bool Add(const char *cmd);
 
 	/**
-	 * Finishes the list and returns it.
+	 * Finishes the list and returns it.  Use
+	 * ForEachCommand() to iterate it.
 	 */
-	std::list<std::string> Commit() {
+	std::string Commit() {
 		assert(IsActive());
 
 		return std::move(list);
 	}
+
+	/**
+	 * Invoke a function for each command in a list returned by
+	 * Commit().  The function receives a writable pointer to the
+	 * null-terminated command and may modify it (e.g. with a
+	 * #Tokenizer).  If it returns false, iteration stops.
+	 *
+	 * @return false if the function has returned false
+	 */
+	template<typename F>
+	static bool ForEachCommand(std::string &list, F &&f) {
+		char *p = list.data();
+		char *const end = p + list.size();
+
+		while (p < end) {
+			char *cmd = p;
+
+			/* determine the next command before invoking
+			   the function, because it may insert null
+			   bytes */
+			p += std::char_traits<char>::length(cmd) + 1;
+
+			if (!f(cmd))
+				return false;
+		}
+
+		return true;
+	}
 };
 
 #endif
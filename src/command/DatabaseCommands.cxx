@@ -18,6 +18,7 @@
  */
 
 #include "DatabaseCommands.hxx"
+#include "StickerCommands.hxx"
 #include "Request.hxx"
 #include "db/DatabaseQueue.hxx"
 #include "db/DatabasePlaylist.hxx"
@@ -33,7 +34,9 @@
 #include "util/StringAPI.hxx"
 #include "util/ASCII.hxx"
 #include "song/Filter.hxx"
+#include "BulkEdit.hxx"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -74,7 +77,8 @@ ParseSortTag(const char *s)
  * @param filter a buffer to be used for DatabaseSelection::filter
  */
 static DatabaseSelection
-ParseDatabaseSelection(Request args, bool fold_case, SongFilter &filter)
+ParseDatabaseSelection(Client &client, Request args, bool fold_case,
+		       SongFilter &filter)
 {
 	RangeArg window = RangeArg::All();
 	if (args.size >= 2 && StringIsEqual(args[args.size - 2], "window")) {
@@ -106,6 +110,7 @@ ParseDatabaseSelection(Request args, bool fold_case, SongFilter &filter)
 				    GetFullMessage(std::current_exception()).c_str());
 	}
 	filter.Optimize();
+	PrepareStickerFilter(client, filter);
 
 	DatabaseSelection selection("", true, &filter);
 	selection.window = window;
@@ -118,7 +123,7 @@ static CommandResult
 handle_match(Client &client, Request args, Response &r, bool fold_case)
 {
 	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, fold_case, filter);
+	const auto selection = ParseDatabaseSelection(client, args, fold_case, filter);
 
 	db_selection_print(r, client.GetPartition(),
 			   selection, true, false);
@@ -141,9 +146,10 @@ static CommandResult
 handle_match_add(Client &client, Request args, bool fold_case)
 {
 	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, fold_case, filter);
+	const auto selection = ParseDatabaseSelection(client, args, fold_case, filter);
 
 	auto &partition = client.GetPartition();
+	const ScopeBulkEdit bulk_edit(partition);
 	AddFromDatabase(partition, selection);
 	return CommandResult::OK;
 }
@@ -166,7 +172,7 @@ handle_searchaddpl(Client &client, Request args, Response &)
 	const char *playlist = args.shift();
 
 	SongFilter filter;
-	const auto selection = ParseDatabaseSelection(args, true, filter);
+	const auto selection = ParseDatabaseSelection(client, args, true, filter);
 
 	const Database &db = client.GetDatabaseOrThrow();
 
@@ -203,6 +209,7 @@ handle_count(Client &client, Request args, Response &r)
 		}
 
 		filter.Optimize();
+		PrepareStickerFilter(client, filter);
 	}
 
 	PrintSongCount(r, client.GetPartition(), "", &filter, group);
@@ -236,6 +243,7 @@ handle_list_file(Client &client, Request args, Response &r)
 			return CommandResult::ERROR;
 		}
 		filter->Optimize();
+		PrepareStickerFilter(client, *filter);
 	}
 
 	PrintSongUris(r, client.GetPartition(), filter.get());
@@ -311,6 +319,7 @@ handle_list(Client &client, Request args, Response &r)
 			return CommandResult::ERROR;
 		}
 		filter->Optimize();
+		PrepareStickerFilter(client, *filter);
 	}
 
 	PrintUniqueTags(r, client.GetPartition(),
@@ -29,6 +29,8 @@
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "IdleFlags.hxx"
+#include "StatusCache.hxx"
+#include "event/Loop.hxx"
 #include "util/StringBuffer.hxx"
 #include "util/ScopeExit.hxx"
 #include "util/Exception.hxx"
@@ -38,6 +40,8 @@
 #include "db/update/Service.hxx"
 #endif
 
+#include <memory>
+
 #define COMMAND_STATUS_STATE            "state"
 #define COMMAND_STATUS_REPEAT           "repeat"
 #define COMMAND_STATUS_SINGLE           "single"
@@ -86,7 +90,26 @@ handle_stop(Client &client, [[maybe_unused]] Request args, [[maybe_unused]] Resp
 CommandResult
 handle_currentsong(Client &client, [[maybe_unused]] Request args, Response &r)
 {
-	playlist_print_current(r, client.GetPlaylist());
+	auto &partition = client.GetPartition();
+	auto &cache = partition.status_cache.current_song;
+
+	const unsigned version = partition.GetStatusVersion();
+	const TagMask tag_mask = r.GetTagMask();
+	if (!cache.IsValid(version, tag_mask)) {
+		cache.valid = false;
+		cache.text.clear();
+
+		auto *old_capture = r.SetCapture(&cache.text);
+		AtScopeExit(&r, old_capture) { r.SetCapture(old_capture); };
+
+		playlist_print_current(r, partition.playlist);
+
+		cache.version = version;
+		cache.tag_mask = tag_mask;
+		cache.valid = true;
+	}
+
+	r.Write(cache.text.data(), cache.text.size());
 	return CommandResult::OK;
 }
 
@@ -104,10 +127,16 @@ handle_pause(Client &client, Request args, [[maybe_unused]] Response &r)
 	return CommandResult::OK;
 }
 
-CommandResult
-handle_status(Client &client, [[maybe_unused]] Request args, Response &r)
+/**
+ * Render the "status" response into the #StatusCache, except for the
+ * "time" and "elapsed" lines, which are generated by handle_status()
+ * for each request.
+ */
+static void
+RenderStatus(Partition &partition, Response &r,
+	     StatusCache::Status &cache,
+	     std::chrono::steady_clock::time_point now)
 {
-	auto &partition = client.GetPartition();
 	auto &pc = partition.pc;
 
 	const char *state = nullptr;
@@ -127,6 +156,16 @@ handle_status(Client &client, [[maybe_unused]] Request args, Response &r)
 		break;
 	}
 
+	cache.state = player_status.state;
+	cache.time = now;
+	cache.elapsed_time = player_status.elapsed_time;
+	cache.total_time = player_status.total_time;
+	cache.head.clear();
+	cache.tail.clear();
+
+	auto *old_capture = r.SetCapture(&cache.head);
+	AtScopeExit(&r, old_capture) { r.SetCapture(old_capture); };
+
 	const auto &playlist = partition.playlist;
 
 	const auto volume = volume_level_get(partition.outputs);
@@ -167,15 +206,10 @@ handle_status(Client &client, [[maybe_unused]] Request args, Response &r)
 			 song, playlist.PositionToId(song));
 	}
 
+	r.SetCapture(&cache.tail);
+
 	if (player_status.state != PlayerState::STOP) {
-		r.Format(COMMAND_STATUS_TIME ": %i:%i\n"
-			 "elapsed: %1.3f\n"
-			 COMMAND_STATUS_BITRATE ": %u\n",
-			 player_status.elapsed_time.RoundS(),
-			 player_status.total_time.IsNegative()
-			 ? 0U
-			 : unsigned(player_status.total_time.RoundS()),
-			 player_status.elapsed_time.ToDoubleS(),
+		r.Format(COMMAND_STATUS_BITRATE ": %u\n",
 			 player_status.bit_rate);
 
 		if (!player_status.total_time.IsNegative())
@@ -210,7 +244,27 @@ handle_status(Client &client, [[maybe_unused]] Request args, Response &r)
 		r.Format(COMMAND_STATUS_NEXTSONG ": %i\n"
 			 COMMAND_STATUS_NEXTSONGID ": %u\n",
 			 song, playlist.PositionToId(song));
+}
+
+CommandResult
+handle_status(Client &client, [[maybe_unused]] Request args, Response &r)
+{
+	auto &partition = client.GetPartition();
+	auto &shared = *partition.status_cache.shared;
+
+	const auto now = client.GetEventLoop().SteadyNow();
+	auto status = shared.GetStatus(now);
+	if (status == nullptr) {
+		auto new_status = std::make_shared<StatusCache::Status>();
+		new_status->version = partition.GetStatusVersion();
+		RenderStatus(partition, r, *new_status, now);
+		shared.SetStatus(new_status);
+		status = std::move(new_status);
+	}
 
+	std::string buffer;
+	status->AppendTo(buffer, now);
+	r.Write(buffer.data(), buffer.size());
 	return CommandResult::OK;
 }
 
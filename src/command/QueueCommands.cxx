@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include "QueueCommands.hxx"
+#include "StickerCommands.hxx"
 #include "Request.hxx"
 #include "protocol/RangeArg.hxx"
 #include "db/DatabaseQueue.hxx"
@@ -273,6 +274,7 @@ handle_playlist_match(Client &client, Request args, Response &r,
 		return CommandResult::ERROR;
 	}
 	filter.Optimize();
+	PrepareStickerFilter(client, filter);
 
 	playlist_print_find(r, client.GetPlaylist(), filter);
 	return CommandResult::OK;
@@ -24,12 +24,15 @@
 #include "sticker/Sticker.hxx"
 #include "sticker/SongSticker.hxx"
 #include "sticker/Print.hxx"
+#include "song/Filter.hxx"
+#include "song/StickerSongFilter.hxx"
 #include "client/Client.hxx"
 #include "client/Response.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "util/StringAPI.hxx"
 #include "util/ScopeExit.hxx"
+#include "protocol/Ack.hxx"
 
 namespace {
 struct sticker_song_find_data {
@@ -176,3 +179,24 @@ handle_sticker(Client &client, Request args, Response &r)
 		return CommandResult::ERROR;
 	}
 }
+
+void
+PrepareStickerFilter(Client &client, SongFilter &filter)
+{
+	const auto sticker_filters = filter.GetStickerFilters();
+	if (sticker_filters.empty())
+		return;
+
+	auto &instance = client.GetInstance();
+	if (!instance.HasStickerDatabase())
+		throw ProtocolError(ACK_ERROR_UNKNOWN,
+				    "sticker database is disabled");
+
+	auto &sticker_database = *instance.sticker_database;
+
+	for (auto *f : sticker_filters) {
+		auto values = sticker_song_load_all(sticker_database,
+						    f->GetName().c_str());
+		f->SetValues(std::make_shared<const StickerSongFilter::Values>(std::move(values)));
+	}
+}
@@ -21,12 +21,36 @@
 #define MPD_STICKER_COMMANDS_HXX
 
 #include "CommandResult.hxx"
+#include "config.h"
 
 class Client;
 class Request;
 class Response;
+class SongFilter;
 
 CommandResult
 handle_sticker(Client &client, Request request, Response &response);
 
+#ifdef ENABLE_SQLITE
+
+/**
+ * Load the sticker values for all "sticker:" predicates in the given
+ * filter.
+ *
+ * Throws on error.
+ */
+void
+PrepareStickerFilter(Client &client, SongFilter &filter);
+
+#else
+
+static inline void
+PrepareStickerFilter(Client &, SongFilter &) noexcept
+{
+	/* without a sticker database, "sticker:" predicates match
+	   nothing */
+}
+
+#endif
+
 #endif
@@ -79,6 +79,10 @@ enum class ConfigOption {
 	DESPOTIFY_USER,
 	DESPOTIFY_PASSWORD,
 	DESPOTIFY_HIGH_BITRATE,
+	SEEK_INDEX_FILE,
+	AUTO_UPDATE_METHOD,
+	CLIENT_THREADS,
+	CLIENT_IO_URING,
 	MAX
 };
 
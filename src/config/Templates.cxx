@@ -75,6 +75,10 @@ const ConfigTemplate config_param_templates[] = {
 	{ "despotify_user", false, true },
 	{ "despotify_password", false, true },
 	{ "despotify_high_bitrate", false, true },
+	{ "seek_index_file" },
+	{ "auto_update_method" },
+	{ "client_threads" },
+	{ "client_io_uring" },
 };
 
 static constexpr unsigned n_config_param_templates =
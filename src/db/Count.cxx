@@ -18,28 +18,15 @@
  */
 
 #include "Count.hxx"
+#include "TagCount.hxx"
 #include "Selection.hxx"
 #include "Interface.hxx"
 #include "Partition.hxx"
 #include "client/Response.hxx"
 #include "song/LightSong.hxx"
-#include "tag/Tag.hxx"
-#include "tag/VisitFallback.hxx"
 #include "TagPrint.hxx"
 
-#include <functional>
-#include <map>
-
-struct SearchStats {
-	unsigned n_songs{0};
-	std::chrono::duration<std::uint64_t, SongTime::period> total_duration;
-
-	constexpr SearchStats()
-		: total_duration(0) {}
-};
-
-class TagCountMap : public std::map<std::string, SearchStats> {
-};
+#include <cassert>
 
 static void
 PrintSearchStats(Response &r, const SearchStats &stats) noexcept
@@ -73,26 +60,6 @@ stats_visitor_song(SearchStats &stats, const LightSong &song) noexcept
 		stats.total_duration += duration;
 }
 
-static void
-CollectGroupCounts(TagCountMap &map, const Tag &tag,
-		   const char *value) noexcept
-{
-	auto r = map.insert(std::make_pair(value, SearchStats()));
-	SearchStats &s = r.first->second;
-	++s.n_songs;
-	if (!tag.duration.IsNegative())
-		s.total_duration += tag.duration;
-}
-
-static void
-GroupCountVisitor(TagCountMap &map, TagType group,
-		  const LightSong &song) noexcept
-{
-	const Tag &tag = song.tag;
-	VisitTagWithFallbackOrEmpty(tag, group, [&](const auto &val)
-		{ return CollectGroupCounts(map, tag, val);  });
-}
-
 void
 PrintSongCount(Response &r, const Partition &partition, const char *name,
 	       const SongFilter *filter,
@@ -114,16 +81,8 @@ PrintSongCount(Response &r, const Partition &partition, const char *name,
 
 		PrintSearchStats(r, stats);
 	} else {
-		/* group by the specified tag: store counts in a
-		   std::map */
-
-		TagCountMap map;
-
-		const auto f = [&map,group](const auto &song)
-			{ return GroupCountVisitor(map, group, song); };
-
-		db.Visit(selection, f);
+		/* group by the specified tag */
 
-		Print(r, group, map);
+		Print(r, group, db.CountTags(selection, group));
 	}
 }
@@ -36,8 +36,9 @@ DatabaseDetachSong(const Storage *storage, const LightSong &song) noexcept
 
 	if (storage != nullptr) {
 		if (!detached.HasRealURI()) {
-			const auto uri = song.GetURI();
-			detached.SetRealURI(storage->MapUTF8(uri.c_str()));
+			/* reuse the URI which was already built by
+			   the DetachedSong constructor */
+			detached.SetRealURI(storage->MapUTF8(detached.GetURI()));
 		} else if (uri_is_relative_path(detached.GetRealURI())) {
 			/* if the "RealURI" is relative, translate it
 			   using the song's "URI" attribute, because
@@ -19,9 +19,11 @@
 
 #include "Helpers.hxx"
 #include "Stats.hxx"
+#include "TagCount.hxx"
 #include "Interface.hxx"
 #include "song/LightSong.hxx"
 #include "tag/Tag.hxx"
+#include "tag/VisitFallback.hxx"
 
 #include <set>
 
@@ -38,7 +40,7 @@ using StringSet = std::set<const char *, StringLess>;
 
 static void
 StatsVisitTag(DatabaseStats &stats, StringSet &artists, StringSet &albums,
-	      const Tag &tag) noexcept
+	      StringSet &album_artists, const Tag &tag) noexcept
 {
 	if (!tag.duration.IsNegative())
 		stats.total_duration += tag.duration;
@@ -53,6 +55,10 @@ StatsVisitTag(DatabaseStats &stats, StringSet &artists, StringSet &albums,
 			albums.emplace(item.value);
 			break;
 
+		case TAG_ALBUM_ARTIST:
+			album_artists.emplace(item.value);
+			break;
+
 		default:
 			break;
 		}
@@ -61,11 +67,11 @@ StatsVisitTag(DatabaseStats &stats, StringSet &artists, StringSet &albums,
 
 static void
 StatsVisitSong(DatabaseStats &stats, StringSet &artists, StringSet &albums,
-	       const LightSong &song) noexcept
+	       StringSet &album_artists, const LightSong &song) noexcept
 {
 	++stats.song_count;
 
-	StatsVisitTag(stats, artists, albums, song.tag);
+	StatsVisitTag(stats, artists, albums, album_artists, song.tag);
 }
 
 DatabaseStats
@@ -74,13 +80,49 @@ GetStats(const Database &db, const DatabaseSelection &selection)
 	DatabaseStats stats;
 	stats.Clear();
 
-	StringSet artists, albums;
+	StringSet artists, albums, album_artists;
 	const auto f = [&](const auto &song)
-		{ return StatsVisitSong(stats, artists, albums, song); };
+		{ return StatsVisitSong(stats, artists, albums, album_artists,
+					song); };
 
 	db.Visit(selection, f);
 
 	stats.artist_count = artists.size();
 	stats.album_count = albums.size();
+	stats.albumartist_count = album_artists.size();
 	return stats;
 }
+
+static void
+CollectGroupCounts(TagCountMap &map, const Tag &tag,
+		   const char *value) noexcept
+{
+	auto r = map.insert(std::make_pair(value, SearchStats()));
+	SearchStats &s = r.first->second;
+	++s.n_songs;
+	if (!tag.duration.IsNegative())
+		s.total_duration += tag.duration;
+}
+
+static void
+GroupCountVisitor(TagCountMap &map, TagType group,
+		  const LightSong &song) noexcept
+{
+	const Tag &tag = song.tag;
+	VisitTagWithFallbackOrEmpty(tag, group, [&](const auto &val)
+		{ return CollectGroupCounts(map, tag, val);  });
+}
+
+TagCountMap
+CountTags(const Database &db, const DatabaseSelection &selection,
+	  TagType group)
+{
+	TagCountMap map;
+
+	const auto f = [&map,group](const auto &song)
+		{ return GroupCountVisitor(map, group, song); };
+
+	db.Visit(selection, f);
+
+	return map;
+}
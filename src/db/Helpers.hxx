@@ -20,11 +20,23 @@
 #ifndef MPD_DATABASE_HELPERS_HXX
 #define MPD_DATABASE_HELPERS_HXX
 
+#include <cstdint>
+
+enum TagType : uint8_t;
 class Database;
+class TagCountMap;
 struct DatabaseSelection;
 struct DatabaseStats;
 
 DatabaseStats
 GetStats(const Database &db, const DatabaseSelection &selection);
 
+/**
+ * Generic implementation of Database::CountTags() which visits all
+ * selected songs.
+ */
+TagCountMap
+CountTags(const Database &db, const DatabaseSelection &selection,
+	  TagType group);
+
 #endif
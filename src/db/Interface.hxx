@@ -31,6 +31,7 @@ struct DatabasePlugin;
 struct DatabaseStats;
 struct DatabaseSelection;
 struct LightSong;
+class TagCountMap;
 template<typename Key> class RecursiveMap;
 template<typename T> struct ConstBuffer;
 
@@ -114,6 +115,15 @@ public:
 	virtual RecursiveMap<std::string> CollectUniqueTags(const DatabaseSelection &selection,
 							    ConstBuffer<TagType> tag_types) const = 0;
 
+	/**
+	 * Count the selected songs and their total duration for each
+	 * value of the given tag.
+	 *
+	 * Throws on error.
+	 */
+	virtual TagCountMap CountTags(const DatabaseSelection &selection,
+				      TagType group) const = 0;
+
 	/**
 	 * Throws on error.
 	 */
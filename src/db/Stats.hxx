@@ -43,10 +43,16 @@ struct DatabaseStats {
 	 */
 	unsigned album_count;
 
+	/**
+	 * Number of distinct album artist names.  This is not (yet)
+	 * reported by the "stats" command.
+	 */
+	unsigned albumartist_count;
+
 	void Clear() {
 		song_count = 0;
 		total_duration = total_duration.zero();
-		artist_count = album_count = 0;
+		artist_count = album_count = albumartist_count = 0;
 	}
 };
 
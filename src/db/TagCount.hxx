@@ -0,0 +1,47 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DB_TAG_COUNT_HXX
+#define MPD_DB_TAG_COUNT_HXX
+
+#include "Chrono.hxx"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * The number of songs and their total duration, as reported by the
+ * "count" command.
+ */
+struct SearchStats {
+	unsigned n_songs{0};
+	std::chrono::duration<std::uint64_t, SongTime::period> total_duration;
+
+	constexpr SearchStats()
+		: total_duration(0) {}
+};
+
+/**
+ * Maps tag values to the #SearchStats of all songs with this value.
+ */
+class TagCountMap : public std::map<std::string, SearchStats> {
+};
+
+#endif
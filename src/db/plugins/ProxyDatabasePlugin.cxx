@@ -28,6 +28,8 @@
 #include "db/LightDirectory.hxx"
 #include "song/LightSong.hxx"
 #include "db/Stats.hxx"
+#include "db/Helpers.hxx"
+#include "db/TagCount.hxx"
 #include "song/Filter.hxx"
 #include "song/UriSongFilter.hxx"
 #include "song/BaseSongFilter.hxx"
@@ -38,8 +40,10 @@
 #include "tag/Tag.hxx"
 #include "tag/ParseName.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/LruCache.hxx"
 #include "util/RecursiveMap.hxx"
 #include "util/ScopeExit.hxx"
+#include "util/StringAPI.hxx"
 #include "util/RuntimeError.hxx"
 #include "protocol/Ack.hxx"
 #include "event/SocketEvent.hxx"
@@ -51,7 +55,10 @@
 
 #include <cassert>
 #include <list>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 
 class LibmpdclientError final : public std::runtime_error {
@@ -85,6 +92,34 @@ public:
 	}
 };
 
+class ProxyEntity {
+	struct mpd_entity *entity;
+
+public:
+	explicit ProxyEntity(struct mpd_entity *_entity) noexcept
+		:entity(_entity) {}
+
+	ProxyEntity(const ProxyEntity &other) = delete;
+
+	ProxyEntity(ProxyEntity &&other) noexcept
+		:entity(other.entity) {
+		other.entity = nullptr;
+	}
+
+	~ProxyEntity() noexcept {
+		if (entity != nullptr)
+			mpd_entity_free(entity);
+	}
+
+	ProxyEntity &operator=(const ProxyEntity &other) = delete;
+
+	operator const struct mpd_entity *() const noexcept {
+		return entity;
+	}
+};
+
+using ProxyListing = std::list<ProxyEntity>;
+
 class ProxyDatabase final : public Database {
 	SocketEvent socket_event;
 	IdleEvent idle_event;
@@ -113,6 +148,28 @@ class ProxyDatabase final : public Database {
 	 */
 	bool is_idle;
 
+	/**
+	 * Cached "lsinfo" responses, indexed by URI.  The lists are
+	 * shared, because a recursive Visit() may still be iterating
+	 * over a list while the cache gets cleared.
+	 */
+	mutable LruCache<std::shared_ptr<const ProxyListing>, 1024> listing_cache;
+
+	/**
+	 * Cached "lsinfo" responses for single songs, obtained by
+	 * GetSong().  They are kept separate from #listing_cache so
+	 * they don't evict directory listings.
+	 */
+	mutable LruCache<std::shared_ptr<const ProxyListing>, 256> song_cache;
+
+	/**
+	 * Cached CollectUniqueTags() results, indexed by
+	 * MakeTagCacheKey().
+	 */
+	mutable LruCache<RecursiveMap<std::string>, 64> tag_cache;
+
+	mutable std::optional<DatabaseStats> stats_cache;
+
 public:
 	ProxyDatabase(EventLoop &_loop, DatabaseListener &_listener,
 		      const ConfigBlock &block);
@@ -135,6 +192,9 @@ public:
 	RecursiveMap<std::string> CollectUniqueTags(const DatabaseSelection &selection,
 						    ConstBuffer<TagType> tag_types) const override;
 
+	TagCountMap CountTags(const DatabaseSelection &selection,
+			      TagType group) const override;
+
 	DatabaseStats GetStats(const DatabaseSelection &selection) const override;
 
 	unsigned Update(const char *uri_utf8, bool discard) override;
@@ -143,7 +203,43 @@ public:
 		return update_stamp;
 	}
 
+	/**
+	 * Obtain the "lsinfo" response for the given URI, either from
+	 * the cache or from the remote MPD.
+	 */
+	std::shared_ptr<const ProxyListing> ListMeta(const char *uri) const;
+
 private:
+	/**
+	 * Send "lsinfo" to the remote MPD, bypassing the caches.
+	 */
+	std::shared_ptr<const ProxyListing> QueryListMeta(const char *uri) const;
+
+	/**
+	 * May the caches be used?  They are only valid while we are
+	 * connected, because we would miss "database" idle events
+	 * otherwise.
+	 */
+	bool IsCacheValid() const noexcept {
+		return connection != nullptr;
+	}
+
+	/**
+	 * Clear all caches.  This is called when the remote database
+	 * has been modified or when the connection is lost.
+	 */
+	void InvalidateCache() noexcept {
+		listing_cache.clear();
+		song_cache.clear();
+		tag_cache.clear();
+		stats_cache.reset();
+	}
+
+	RecursiveMap<std::string> QueryUniqueTags(const DatabaseSelection &selection,
+						  ConstBuffer<TagType> tag_types) const;
+
+	DatabaseStats QueryStats() const;
+
 	void Connect();
 	void CheckConnection();
 	void EnsureConnected();
@@ -524,6 +620,10 @@ ProxyDatabase::Connect()
 	idle_received = ~0U;
 	is_idle = false;
 
+	/* we may have missed database modifications while we were
+	   disconnected */
+	InvalidateCache();
+
 	socket_event.Open(SocketDescriptor(mpd_async_get_fd(mpd_connection_get_async(connection))));
 	idle_event.Schedule();
 }
@@ -550,6 +650,9 @@ ProxyDatabase::CheckConnection()
 			}
 		}
 
+		if (idle & MPD_IDLE_DATABASE)
+			InvalidateCache();
+
 		idle_received |= idle;
 		is_idle = false;
 		idle_event.Schedule();
@@ -575,6 +678,8 @@ ProxyDatabase::Disconnect() noexcept
 
 	mpd_connection_free(connection);
 	connection = nullptr;
+
+	InvalidateCache();
 }
 
 void
@@ -600,6 +705,9 @@ ProxyDatabase::OnSocketReady([[maybe_unused]] unsigned flags) noexcept
 		}
 	}
 
+	if (idle & MPD_IDLE_DATABASE)
+		InvalidateCache();
+
 	/* let OnIdle() handle this */
 	idle_received |= idle;
 	is_idle = false;
@@ -635,6 +743,7 @@ ProxyDatabase::OnIdle() noexcept
 		socket_event.ReleaseSocket();
 		mpd_connection_free(connection);
 		connection = nullptr;
+		InvalidateCache();
 		return;
 	}
 
@@ -642,27 +751,74 @@ ProxyDatabase::OnIdle() noexcept
 	socket_event.ScheduleRead();
 }
 
+/**
+ * Find the first song in the given "lsinfo" response, optionally
+ * with the given URI.
+ */
+gcc_pure
+static const struct mpd_song *
+FindSong(const ProxyListing &entities,
+	 const char *uri=nullptr) noexcept
+{
+	for (const auto &entity : entities) {
+		if (mpd_entity_get_type(entity) != MPD_ENTITY_TYPE_SONG)
+			continue;
+
+		const auto *song = mpd_entity_get_song(entity);
+		if (uri == nullptr || StringIsEqual(mpd_song_get_uri(song), uri))
+			return song;
+	}
+
+	return nullptr;
+}
+
 const LightSong *
 ProxyDatabase::GetSong(std::string_view uri) const
 {
-	// TODO: eliminate the const_cast
-	const_cast<ProxyDatabase *>(this)->EnsureConnected();
+	const std::string uri2(uri);
+
+	std::shared_ptr<const ProxyListing> listing;
+	const struct mpd_song *song = nullptr;
+
+	if (IsCacheValid()) {
+		/* the song may be in the cached listing of its
+		   parent directory, e.g. after a client has browsed
+		   it */
+		const auto slash = uri.rfind('/');
+		const auto parent = slash == uri.npos
+			? std::string_view()
+			: uri.substr(0, slash);
+
+		const auto *cached = listing_cache.Lookup(parent);
+		if (cached != nullptr) {
+			listing = *cached;
+			song = FindSong(*listing, uri2.c_str());
+		}
+	}
 
-	if (!mpd_send_list_meta(connection, std::string(uri).c_str()))
-		ThrowError(connection);
+	if (song == nullptr && IsCacheValid()) {
+		const auto *cached = song_cache.Lookup(uri);
+		if (cached != nullptr) {
+			listing = *cached;
+			song = FindSong(*listing);
+		}
+	}
 
-	struct mpd_song *song = mpd_recv_song(connection);
-	if (!mpd_response_finish(connection)) {
-		if (song != nullptr)
-			mpd_song_free(song);
-		ThrowError(connection);
+	if (song == nullptr) {
+		listing = QueryListMeta(uri2.c_str());
+		song_cache.Store(uri2, listing);
+		song = FindSong(*listing);
 	}
 
 	if (song == nullptr)
 		throw DatabaseError(DatabaseErrorCode::NOT_FOUND,
 				    "No such song");
 
-	return new AllocatedProxySong(song);
+	auto *copy = mpd_song_dup(song);
+	if (copy == nullptr)
+		throw std::bad_alloc();
+
+	return new AllocatedProxySong(copy);
 }
 
 void
@@ -676,13 +832,13 @@ ProxyDatabase::ReturnSong(const LightSong *_song) const noexcept
 }
 
 static void
-Visit(struct mpd_connection *connection, const char *uri,
+Visit(const ProxyDatabase &db, const char *uri,
       bool recursive, const SongFilter *filter,
       const VisitDirectory& visit_directory, const VisitSong& visit_song,
       const VisitPlaylist& visit_playlist);
 
 static void
-Visit(struct mpd_connection *connection,
+Visit(const ProxyDatabase &db,
       bool recursive, const SongFilter *filter,
       const struct mpd_directory *directory,
       const VisitDirectory& visit_directory, const VisitSong& visit_song,
@@ -700,7 +856,7 @@ Visit(struct mpd_connection *connection,
 		visit_directory(LightDirectory(path, mtime));
 
 	if (recursive)
-		Visit(connection, path, recursive, filter,
+		Visit(db, path, recursive, filter,
 		      visit_directory, visit_song, visit_playlist);
 }
 
@@ -741,32 +897,6 @@ Visit(const struct mpd_playlist *playlist,
 	visit_playlist(p, LightDirectory::Root());
 }
 
-class ProxyEntity {
-	struct mpd_entity *entity;
-
-public:
-	explicit ProxyEntity(struct mpd_entity *_entity) noexcept
-		:entity(_entity) {}
-
-	ProxyEntity(const ProxyEntity &other) = delete;
-
-	ProxyEntity(ProxyEntity &&other) noexcept
-		:entity(other.entity) {
-		other.entity = nullptr;
-	}
-
-	~ProxyEntity() noexcept {
-		if (entity != nullptr)
-			mpd_entity_free(entity);
-	}
-
-	ProxyEntity &operator=(const ProxyEntity &other) = delete;
-
-	operator const struct mpd_entity *() const noexcept {
-		return entity;
-	}
-};
-
 static std::list<ProxyEntity>
 ReceiveEntities(struct mpd_connection *connection) noexcept
 {
@@ -779,25 +909,49 @@ ReceiveEntities(struct mpd_connection *connection) noexcept
 	return entities;
 }
 
-static void
-Visit(struct mpd_connection *connection, const char *uri,
-      bool recursive, const SongFilter *filter,
-      const VisitDirectory& visit_directory, const VisitSong& visit_song,
-      const VisitPlaylist& visit_playlist)
+std::shared_ptr<const ProxyListing>
+ProxyDatabase::ListMeta(const char *uri) const
 {
+	if (IsCacheValid()) {
+		const auto *cached = listing_cache.Lookup(uri);
+		if (cached != nullptr)
+			return *cached;
+	}
+
+	auto entities = QueryListMeta(uri);
+	listing_cache.Store(uri, entities);
+	return entities;
+}
+
+std::shared_ptr<const ProxyListing>
+ProxyDatabase::QueryListMeta(const char *uri) const
+{
+	// TODO: eliminate the const_cast
+	const_cast<ProxyDatabase *>(this)->EnsureConnected();
+
 	if (!mpd_send_list_meta(connection, uri))
 		ThrowError(connection);
 
-	std::list<ProxyEntity> entities(ReceiveEntities(connection));
+	auto entities = std::make_shared<const ProxyListing>(ReceiveEntities(connection));
 	CheckError(connection);
+	return entities;
+}
 
-	for (const auto &entity : entities) {
+static void
+Visit(const ProxyDatabase &db, const char *uri,
+      bool recursive, const SongFilter *filter,
+      const VisitDirectory& visit_directory, const VisitSong& visit_song,
+      const VisitPlaylist& visit_playlist)
+{
+	const auto entities = db.ListMeta(uri);
+
+	for (const auto &entity : *entities) {
 		switch (mpd_entity_get_type(entity)) {
 		case MPD_ENTITY_TYPE_UNKNOWN:
 			break;
 
 		case MPD_ENTITY_TYPE_DIRECTORY:
-			Visit(connection, recursive, filter,
+			Visit(db, recursive, filter,
 			      mpd_entity_get_directory(entity),
 			      visit_directory, visit_song, visit_playlist);
 			break;
@@ -985,17 +1139,61 @@ ProxyDatabase::Visit(const DatabaseSelection &selection,
 		return;
 	}
 
-	/* fall back to recursive walk (slow!) */
-	::Visit(connection, selection.uri.c_str(),
+	/* fall back to recursive walk (slow, but the listings are
+	   cached) */
+	::Visit(*this, selection.uri.c_str(),
 		selection.recursive, selection.filter,
 		visit_directory, visit_song, visit_playlist);
 
 	helper.Commit();
 }
 
+static std::string
+MakeTagCacheKey(const DatabaseSelection &selection,
+		ConstBuffer<TagType> tag_types)
+{
+	std::string key = selection.uri;
+	key.push_back('\n');
+
+	if (selection.filter != nullptr)
+		key += selection.filter->ToExpression();
+	key.push_back('\n');
+
+	key += std::to_string(selection.window.start);
+	key.push_back('-');
+	key += std::to_string(selection.window.end);
+	key.push_back(' ');
+	key += std::to_string(unsigned(selection.sort));
+	key.push_back(selection.descending ? '-' : '+');
+
+	for (const auto i : tag_types) {
+		key.push_back(' ');
+		key += std::to_string(unsigned(i));
+	}
+
+	return key;
+}
+
 RecursiveMap<std::string>
 ProxyDatabase::CollectUniqueTags(const DatabaseSelection &selection,
 				 ConstBuffer<TagType> tag_types) const
+{
+	auto key = MakeTagCacheKey(selection, tag_types);
+
+	if (IsCacheValid()) {
+		const auto *cached = tag_cache.Lookup(key);
+		if (cached != nullptr)
+			return *cached;
+	}
+
+	auto result = QueryUniqueTags(selection, tag_types);
+	tag_cache.Store(std::move(key), result);
+	return result;
+}
+
+RecursiveMap<std::string>
+ProxyDatabase::QueryUniqueTags(const DatabaseSelection &selection,
+			       ConstBuffer<TagType> tag_types) const
 try {
 	// TODO: eliminate the const_cast
 	const_cast<ProxyDatabase *>(this)->EnsureConnected();
@@ -1055,12 +1253,28 @@ try {
 	throw;
 }
 
+TagCountMap
+ProxyDatabase::CountTags(const DatabaseSelection &selection,
+			 TagType group) const
+{
+	return ::CountTags(*this, selection, group);
+}
+
 DatabaseStats
 ProxyDatabase::GetStats(const DatabaseSelection &selection) const
 {
 	// TODO: match
 	(void)selection;
 
+	if (!IsCacheValid() || !stats_cache)
+		stats_cache = QueryStats();
+
+	return *stats_cache;
+}
+
+DatabaseStats
+ProxyDatabase::QueryStats() const
+{
 	// TODO: eliminate the const_cast
 	const_cast<ProxyDatabase *>(this)->EnsureConnected();
 
@@ -1076,6 +1290,8 @@ ProxyDatabase::GetStats(const DatabaseSelection &selection) const
 	stats.total_duration = std::chrono::seconds(mpd_stats_get_db_play_time(stats2));
 	stats.artist_count = mpd_stats_get_number_of_artists(stats2);
 	stats.album_count = mpd_stats_get_number_of_albums(stats2);
+	/* not supported by libmpdclient */
+	stats.albumartist_count = 0;
 	mpd_stats_free(stats2);
 	return stats;
 }
@@ -22,6 +22,7 @@
 #include "SongSort.hxx"
 #include "Song.hxx"
 #include "Mount.hxx"
+#include "IncrementalStats.hxx"
 #include "db/LightDirectory.hxx"
 #include "db/Uri.hxx"
 #include "db/DatabaseLock.hxx"
@@ -39,9 +40,17 @@
 #include <string.h>
 #include <stdlib.h>
 
-Directory::Directory(std::string &&_path_utf8, Directory *_parent) noexcept
+Directory::Directory(std::string &&_path_utf8, Directory *_parent,
+		     IncrementalStats *_stats) noexcept
 	:parent(_parent),
-	 path(std::move(_path_utf8))
+	 path(std::move(_path_utf8)),
+	 stats(_stats)
+{
+}
+
+Directory::Directory(std::string &&_path_utf8, Directory *_parent) noexcept
+	:Directory(std::move(_path_utf8), _parent,
+		   _parent != nullptr ? _parent->stats : nullptr)
 {
 }
 
@@ -62,8 +71,36 @@ Directory::Delete() noexcept
 	assert(holding_db_lock());
 	assert(parent != nullptr);
 
+	if (stats == nullptr) {
+		parent->children.erase_and_dispose(parent->children.iterator_to(*this),
+						   DeleteDisposer());
+		return;
+	}
+
+	RemoveStatsRecursive();
+
+	auto *const _stats = stats;
+	std::string _path = _stats->HasReferrers() ? path : std::string();
+
 	parent->children.erase_and_dispose(parent->children.iterator_to(*this),
 					   DeleteDisposer());
+
+	/* songs outside of this directory may have referred to songs
+	   inside it */
+	if (!_path.empty())
+		_stats->UpdateDirectoryReferrers(_path);
+}
+
+void
+Directory::RemoveStatsRecursive() noexcept
+{
+	assert(stats != nullptr);
+
+	for (const auto &song : songs)
+		stats->Remove(song);
+
+	for (auto &child : children)
+		child.RemoveStatsRecursive();
 }
 
 const char *
@@ -165,7 +202,14 @@ Directory::AddSong(SongPtr song) noexcept
 	assert(song != nullptr);
 	assert(&song->parent == this);
 
-	songs.push_back(*song.release());
+	auto &s = *song.release();
+	songs.push_back(s);
+
+	if (stats != nullptr) {
+		stats->Add(s);
+		if (stats->HasReferrers())
+			stats->UpdateReferrers(s.GetURI());
+	}
 }
 
 SongPtr
@@ -176,9 +220,39 @@ Directory::RemoveSong(Song *song) noexcept
 	assert(&song->parent == this);
 
 	songs.erase(songs.iterator_to(*song));
+
+	if (stats != nullptr) {
+		stats->Remove(*song);
+		if (stats->HasReferrers())
+			stats->UpdateReferrers(song->GetURI());
+	}
+
 	return SongPtr(song);
 }
 
+void
+Directory::BeginSongTagUpdate(const Song &song) noexcept
+{
+	assert(holding_db_lock());
+	assert(&song.parent == this);
+
+	if (stats != nullptr)
+		stats->Remove(song);
+}
+
+void
+Directory::EndSongTagUpdate(const Song &song) noexcept
+{
+	assert(holding_db_lock());
+	assert(&song.parent == this);
+
+	if (stats != nullptr) {
+		stats->Add(song);
+		if (stats->HasReferrers())
+			stats->UpdateReferrers(song.GetURI());
+	}
+}
+
 const Song *
 Directory::FindSong(std::string_view name_utf8) const noexcept
 {
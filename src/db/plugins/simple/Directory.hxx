@@ -52,6 +52,7 @@ static constexpr unsigned DEVICE_CONTAINER = -2;
 static constexpr unsigned DEVICE_PLAYLIST = -3;
 
 class SongFilter;
+class IncrementalStats;
 
 struct Directory {
 	static constexpr auto link_mode = boost::intrusive::normal_link;
@@ -106,16 +107,33 @@ struct Directory {
 	 */
 	DatabasePtr mounted_database;
 
+	/**
+	 * The statistics of the #Database which owns this directory
+	 * tree; they are updated by AddSong(), RemoveSong() and
+	 * Delete().  This is inherited from the parent directory and
+	 * may be nullptr.
+	 */
+	IncrementalStats *const stats;
+
 public:
 	Directory(std::string &&_path_utf8, Directory *_parent) noexcept;
 	~Directory() noexcept;
 
+private:
+	Directory(std::string &&_path_utf8, Directory *_parent,
+		  IncrementalStats *_stats) noexcept;
+
+public:
+
 	/**
 	 * Create a new root #Directory object.
+	 *
+	 * @param _stats the statistics to be updated by this directory
+	 * tree (optional)
 	 */
 	gcc_malloc gcc_returns_nonnull
-	static Directory *NewRoot() noexcept {
-		return new Directory(std::string(), nullptr);
+	static Directory *NewRoot(IncrementalStats *_stats=nullptr) noexcept {
+		return new Directory(std::string(), nullptr, _stats);
 	}
 
 	/**
@@ -148,6 +166,15 @@ public:
 	 */
 	void Delete() noexcept;
 
+private:
+	/**
+	 * Remove all songs in this directory and all sub directories
+	 * from the statistics.
+	 */
+	void RemoveStatsRecursive() noexcept;
+
+public:
+
 	/**
 	 * Create a new #Directory object as a child of the given one.
 	 *
@@ -282,6 +309,23 @@ public:
 	 */
 	SongPtr RemoveSong(Song *song) noexcept;
 
+	/**
+	 * Call this before modifying the #Tag of a song which is in
+	 * this directory; it removes the song from the statistics
+	 * until EndSongTagUpdate() is called.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void BeginSongTagUpdate(const Song &song) noexcept;
+
+	/**
+	 * Account the (possibly modified) #Tag of a song after
+	 * BeginSongTagUpdate().
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	void EndSongTagUpdate(const Song &song) noexcept;
+
 	/**
 	 * Caller must lock the #db_mutex.
 	 */
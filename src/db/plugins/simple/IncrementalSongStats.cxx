@@ -0,0 +1,153 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The parts of #IncrementalStats which deal with #Song objects and
+ * their targets.
+ */
+
+#include "IncrementalStats.hxx"
+#include "Song.hxx"
+#include "Directory.hxx"
+#include "ExportedSong.hxx"
+#include "util/IterableSplitString.hxx"
+
+#include <cassert>
+
+/**
+ * Determine the URI of the song's target, by applying its (relative)
+ * target path to the URI of its parent directory.
+ *
+ * @return the URI or an empty string if the target path leaves the
+ * music directory
+ */
+gcc_pure
+static std::string
+ResolveTarget(const Song &song) noexcept
+{
+	std::string uri = song.parent.GetPath();
+
+	for (const StringView name : IterableSplitString(std::string_view(song.target), '/')) {
+		if (name.empty() || name.Equals("."))
+			continue;
+
+		if (name.Equals("..")) {
+			if (uri.empty())
+				return {};
+
+			const auto slash = uri.rfind('/');
+			uri.erase(slash == uri.npos ? 0 : slash);
+		} else {
+			if (!uri.empty())
+				uri.push_back('/');
+			uri.append(name.data, name.size);
+		}
+	}
+
+	return uri;
+}
+
+void
+IncrementalStats::Add(const Song &song) noexcept
+{
+	if (song.target.empty()) {
+		Add(song.tag);
+		return;
+	}
+
+	const auto exported = song.Export();
+	Add(exported.tag);
+	target_tags.emplace(&song, exported.tag);
+
+	auto uri = ResolveTarget(song);
+	if (!uri.empty())
+		referrers.emplace(std::move(uri), &song);
+}
+
+void
+IncrementalStats::Remove(const Song &song) noexcept
+{
+	if (song.target.empty()) {
+		Remove(song.tag);
+		return;
+	}
+
+	auto i = target_tags.find(&song);
+	assert(i != target_tags.end());
+	Remove(i->second);
+	target_tags.erase(i);
+
+	const auto uri = ResolveTarget(song);
+	if (uri.empty())
+		return;
+
+	auto r = referrers.equal_range(uri);
+	for (auto j = r.first; j != r.second; ++j) {
+		if (j->second == &song) {
+			referrers.erase(j);
+			break;
+		}
+	}
+}
+
+const Tag &
+IncrementalStats::GetAccountedTag(const Song &song) const noexcept
+{
+	if (song.target.empty())
+		return song.tag;
+
+	auto i = target_tags.find(&song);
+	assert(i != target_tags.end());
+	return i->second;
+}
+
+inline void
+IncrementalStats::UpdateReferrer(const Song &song) noexcept
+{
+	auto i = target_tags.find(&song);
+	assert(i != target_tags.end());
+
+	const auto exported = song.Export();
+	Remove(i->second);
+	Add(exported.tag);
+	i->second = Tag(exported.tag);
+}
+
+void
+IncrementalStats::UpdateReferrers(std::string_view uri) noexcept
+{
+	auto r = referrers.equal_range(uri);
+	for (auto i = r.first; i != r.second; ++i)
+		UpdateReferrer(*i->second);
+}
+
+void
+IncrementalStats::UpdateDirectoryReferrers(std::string_view uri) noexcept
+{
+	/* all URIs which begin with "URI/" sort between "URI/" and
+	   "URI0", because '0' follows '/' */
+	std::string begin(uri), end(uri);
+	begin.push_back('/');
+	end.push_back('/' + 1);
+
+	for (auto i = referrers.lower_bound(begin),
+		     e = referrers.lower_bound(end);
+	     i != e; ++i)
+		UpdateReferrer(*i->second);
+}
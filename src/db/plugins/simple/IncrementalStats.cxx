@@ -0,0 +1,155 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "IncrementalStats.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <cassert>
+
+inline IncrementalStats::ValueCounter *
+IncrementalStats::GetCounter(TagType type) noexcept
+{
+	switch (type) {
+	case TAG_ARTIST:
+		return &artists;
+
+	case TAG_ALBUM:
+		return &albums;
+
+	case TAG_ALBUM_ARTIST:
+		return &album_artists;
+
+	default:
+		return nullptr;
+	}
+}
+
+inline void
+IncrementalStats::Increment(ValueCounter &counter,
+			    std::string_view value) noexcept
+{
+	auto i = counter.lower_bound(value);
+	if (i != counter.end() && i->first == value)
+		++i->second;
+	else
+		counter.emplace_hint(i, value, 1U);
+}
+
+inline void
+IncrementalStats::Decrement(ValueCounter &counter,
+			    std::string_view value) noexcept
+{
+	auto i = counter.find(value);
+	assert(i != counter.end());
+	if (i == counter.end())
+		return;
+
+	assert(i->second > 0);
+	if (--i->second == 0)
+		counter.erase(i);
+}
+
+void
+IncrementalStats::Add(const Tag &tag) noexcept
+{
+	++song_count;
+
+	if (!tag.duration.IsNegative())
+		total_duration += tag.duration;
+
+	for (const auto &item : tag) {
+		auto *counter = GetCounter(item.type);
+		if (counter != nullptr)
+			Increment(*counter, item.value);
+	}
+
+	for (auto &i : aggregates)
+		i.Add(tag);
+}
+
+void
+IncrementalStats::Remove(const Tag &tag) noexcept
+{
+	assert(song_count > 0);
+	--song_count;
+
+	if (!tag.duration.IsNegative()) {
+		assert(total_duration >= tag.duration);
+		total_duration -= tag.duration;
+	}
+
+	for (const auto &item : tag) {
+		auto *counter = GetCounter(item.type);
+		if (counter != nullptr)
+			Decrement(*counter, item.value);
+	}
+
+	for (auto &i : aggregates)
+		i.Remove(tag);
+}
+
+void
+IncrementalStats::Clear() noexcept
+{
+	artists.clear();
+	albums.clear();
+	album_artists.clear();
+	aggregates.clear();
+
+	target_tags.clear();
+	referrers.clear();
+
+	song_count = 0;
+	total_duration = total_duration.zero();
+}
+
+DatabaseStats
+IncrementalStats::Get() const noexcept
+{
+	DatabaseStats stats;
+	stats.song_count = song_count;
+	stats.total_duration = total_duration;
+	stats.artist_count = artists.size();
+	stats.album_count = albums.size();
+	stats.albumartist_count = album_artists.size();
+	return stats;
+}
+
+const TagAggregate *
+IncrementalStats::FindAggregate(ConstBuffer<TagType> tag_types) noexcept
+{
+	for (auto i = aggregates.begin(); i != aggregates.end(); ++i) {
+		if (i->Matches(tag_types)) {
+			/* move to the front of the LRU list */
+			aggregates.splice(aggregates.begin(), aggregates, i);
+			return &*i;
+		}
+	}
+
+	return nullptr;
+}
+
+TagAggregate &
+IncrementalStats::MakeAggregate(ConstBuffer<TagType> tag_types)
+{
+	if (aggregates.size() >= MAX_AGGREGATES)
+		aggregates.pop_back();
+
+	return aggregates.emplace_front(tag_types);
+}
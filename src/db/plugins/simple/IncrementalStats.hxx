@@ -0,0 +1,175 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DB_SIMPLE_INCREMENTAL_STATS_HXX
+#define MPD_DB_SIMPLE_INCREMENTAL_STATS_HXX
+
+#include "TagAggregate.hxx"
+#include "db/Stats.hxx"
+#include "tag/Tag.hxx"
+#include "tag/Type.h"
+#include "util/Compiler.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <string_view>
+
+struct Song;
+
+/**
+ * Database statistics which are updated whenever a song is added to
+ * or removed from the #SimpleDatabase, so they can be obtained
+ * without walking the whole tree.
+ *
+ * The number of distinct tag values is tracked with a reference
+ * counted set per tag type.  In addition, it owns the
+ * #TagAggregate instances which were requested recently.
+ *
+ * Songs with a "target" (e.g. the tracks of a CUE sheet) are
+ * exported with their tags complemented by the tags of the target
+ * song.  These are accounted with their exported tags, and they are
+ * accounted again whenever the target song changes.
+ *
+ * This object is protected with the global #db_mutex.
+ */
+class IncrementalStats {
+	/**
+	 * The maximum number of #TagAggregate instances.  Each one
+	 * adds some overhead to Add() and Remove().
+	 */
+	static constexpr std::size_t MAX_AGGREGATES = 8;
+
+	/**
+	 * Maps a tag value to the number of occurrences.
+	 */
+	using ValueCounter = std::map<std::string, unsigned, std::less<>>;
+
+	ValueCounter artists, albums, album_artists;
+
+	unsigned song_count = 0;
+
+	/**
+	 * The exported tags which were accounted for songs with a
+	 * "target".  They are subtracted by Remove(), even if the
+	 * target song has been modified in the meantime.
+	 */
+	std::map<const Song *, Tag> target_tags;
+
+	/**
+	 * Maps the URI of a target song to the songs referring to it.
+	 */
+	std::multimap<std::string, const Song *, std::less<>> referrers;
+
+	decltype(DatabaseStats::total_duration) total_duration{};
+
+	/**
+	 * The most recently used one comes first.
+	 */
+	std::list<TagAggregate> aggregates;
+
+public:
+	/**
+	 * Account a song which was added to the database.
+	 */
+	void Add(const Tag &tag) noexcept;
+
+	/**
+	 * Undo Add() for a song which is being removed from the
+	 * database.
+	 */
+	void Remove(const Tag &tag) noexcept;
+
+	/**
+	 * Account a song which was added to the database, with the
+	 * tags it is exported with.  The song must already be linked
+	 * into its #Directory.
+	 */
+	void Add(const Song &song) noexcept;
+
+	/**
+	 * Undo Add(const Song &).
+	 */
+	void Remove(const Song &song) noexcept;
+
+	/**
+	 * Returns the #Tag which was accounted for the given song;
+	 * for songs with a "target", this is the exported #Tag.
+	 */
+	gcc_pure
+	const Tag &GetAccountedTag(const Song &song) const noexcept;
+
+	/**
+	 * Are there songs with a "target"?  If not, calling
+	 * UpdateReferrers() is not necessary.
+	 */
+	bool HasReferrers() const noexcept {
+		return !referrers.empty();
+	}
+
+	/**
+	 * The song with the given URI has been added, removed or
+	 * modified: account the songs whose target it is again.
+	 */
+	void UpdateReferrers(std::string_view uri) noexcept;
+
+	/**
+	 * The directory with the given URI has been deleted: account
+	 * the songs whose target was in it again.
+	 */
+	void UpdateDirectoryReferrers(std::string_view uri) noexcept;
+
+	void Clear() noexcept;
+
+	gcc_pure
+	DatabaseStats Get() const noexcept;
+
+	/**
+	 * Look up the #TagAggregate for the given tag types and mark
+	 * it as recently used.
+	 *
+	 * @return the #TagAggregate or nullptr if there is none
+	 */
+	const TagAggregate *FindAggregate(ConstBuffer<TagType> tag_types) noexcept;
+
+	/**
+	 * Create a new (empty) #TagAggregate for the given tag types,
+	 * discarding the least recently used one if there are too
+	 * many.  The caller is responsible for adding all songs which
+	 * were already added to this object.
+	 */
+	TagAggregate &MakeAggregate(ConstBuffer<TagType> tag_types);
+
+private:
+	/**
+	 * Returns the #ValueCounter for the given tag type or nullptr
+	 * if values of this type are not counted.
+	 */
+	gcc_pure
+	ValueCounter *GetCounter(TagType type) noexcept;
+
+	void UpdateReferrer(const Song &song) noexcept;
+
+	static void Increment(ValueCounter &counter,
+			      std::string_view value) noexcept;
+	static void Decrement(ValueCounter &counter,
+			      std::string_view value) noexcept;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "db/Selection.hxx"
 #include "db/Helpers.hxx"
 #include "db/Stats.hxx"
+#include "db/TagCount.hxx"
 #include "db/UniqueTags.hxx"
 #include "db/VHelper.hxx"
 #include "db/LightDirectory.hxx"
@@ -166,7 +167,9 @@ SimpleDatabase::Open()
 {
 	assert(prefixed_light_song == nullptr);
 
-	root = Directory::NewRoot();
+	stats.Clear();
+	mount_count = 0;
+	root = Directory::NewRoot(&stats);
 	mtime = std::chrono::system_clock::time_point::min();
 
 #ifndef NDEBUG
@@ -182,7 +185,8 @@ SimpleDatabase::Open()
 
 		Check();
 
-		root = Directory::NewRoot();
+		stats.Clear();
+		root = Directory::NewRoot(&stats);
 	}
 }
 
@@ -330,16 +334,78 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 			    "No such directory");
 }
 
+inline bool
+SimpleDatabase::CanUseIncrementalStats(const DatabaseSelection &selection) const noexcept
+{
+	return selection.IsEmpty() && selection.recursive &&
+		selection.window.IsAll() &&
+		mount_count == 0;
+}
+
+static void
+AddRecursive(TagAggregate &aggregate, const IncrementalStats &stats,
+	     const Directory &directory) noexcept
+{
+	/* use the same tags as IncrementalStats, which will later
+	   remove them from the aggregate */
+	for (const auto &song : directory.songs)
+		aggregate.Add(stats.GetAccountedTag(song));
+
+	for (const auto &child : directory.children)
+		AddRecursive(aggregate, stats, child);
+}
+
+const TagAggregate &
+SimpleDatabase::GetAggregate(ConstBuffer<TagType> tag_types) const
+{
+	const auto *aggregate = stats.FindAggregate(tag_types);
+	if (aggregate != nullptr)
+		return *aggregate;
+
+	/* not yet materialized: walk the whole tree once; from now
+	   on, the Directory tree keeps it up to date */
+	auto &new_aggregate = stats.MakeAggregate(tag_types);
+	AddRecursive(new_aggregate, stats, *root);
+	return new_aggregate;
+}
+
 RecursiveMap<std::string>
 SimpleDatabase::CollectUniqueTags(const DatabaseSelection &selection,
 				  ConstBuffer<TagType> tag_types) const
 {
+	{
+		const ScopeDatabaseLock protect;
+		if (CanUseIncrementalStats(selection))
+			return GetAggregate(tag_types).ToRecursiveMap();
+	}
+
 	return ::CollectUniqueTags(*this, selection, tag_types);
 }
 
+TagCountMap
+SimpleDatabase::CountTags(const DatabaseSelection &selection,
+			  TagType group) const
+{
+	{
+		const ScopeDatabaseLock protect;
+		if (CanUseIncrementalStats(selection))
+			return GetAggregate({&group, 1}).ToCountMap();
+	}
+
+	return ::CountTags(*this, selection, group);
+}
+
 DatabaseStats
 SimpleDatabase::GetStats(const DatabaseSelection &selection) const
 {
+	{
+		/* the whole database: use the statistics which are
+		   maintained by the Directory tree */
+		const ScopeDatabaseLock protect;
+		if (CanUseIncrementalStats(selection))
+			return stats.Get();
+	}
+
 	return ::GetStats(*this, selection);
 }
 
@@ -413,6 +479,7 @@ SimpleDatabase::Mount(const char *uri, DatabasePtr db)
 
 	Directory *mnt = r.directory->CreateChild(r.rest);
 	mnt->mounted_database = std::move(db);
+	++mount_count;
 }
 
 static constexpr bool
@@ -465,6 +532,9 @@ SimpleDatabase::LockUmountSteal(const char *uri) noexcept
 	auto db = std::move(r.directory->mounted_database);
 	r.directory->Delete();
 
+	assert(mount_count > 0);
+	--mount_count;
+
 	return db;
 }
 
@@ -21,6 +21,7 @@
 #define MPD_SIMPLE_DATABASE_PLUGIN_HXX
 
 #include "ExportedSong.hxx"
+#include "IncrementalStats.hxx"
 #include "db/Interface.hxx"
 #include "db/Ptr.hxx"
 #include "fs/AllocatedPath.hxx"
@@ -52,6 +53,25 @@ class SimpleDatabase : public Database {
 
 	Directory *root;
 
+	/**
+	 * Statistics of all songs in the #root tree, updated by
+	 * #Directory.  They do not include mounted databases.
+	 *
+	 * This is mutable because const methods create
+	 * #TagAggregate instances on demand.
+	 *
+	 * Protected with the global #db_mutex.
+	 */
+	mutable IncrementalStats stats;
+
+	/**
+	 * The number of databases mounted with Mount().  As long as
+	 * this is non-zero, GetStats() needs to walk the tree.
+	 *
+	 * Protected with the global #db_mutex.
+	 */
+	unsigned mount_count = 0;
+
 	std::chrono::system_clock::time_point mtime;
 
 	/**
@@ -127,6 +147,9 @@ public:
 	RecursiveMap<std::string> CollectUniqueTags(const DatabaseSelection &selection,
 						    ConstBuffer<TagType> tag_types) const override;
 
+	TagCountMap CountTags(const DatabaseSelection &selection,
+			      TagType group) const override;
+
 	DatabaseStats GetStats(const DatabaseSelection &selection) const override;
 
 	std::chrono::system_clock::time_point GetUpdateStamp() const noexcept override {
@@ -138,6 +161,23 @@ private:
 
 	void Check() const;
 
+	/**
+	 * Can the given selection be answered by #stats, i.e. does
+	 * it select all songs, and are there no mounts?
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	gcc_pure
+	bool CanUseIncrementalStats(const DatabaseSelection &selection) const noexcept;
+
+	/**
+	 * Look up the #TagAggregate for the given tag types, and
+	 * create it if it does not exist yet.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	const TagAggregate &GetAggregate(ConstBuffer<TagType> tag_types) const;
+
 	/**
 	 * Throws #std::runtime_error on error.
 	 */
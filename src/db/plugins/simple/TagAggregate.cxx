@@ -0,0 +1,140 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "TagAggregate.hxx"
+#include "tag/Tag.hxx"
+#include "tag/VisitFallback.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/RecursiveMap.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
+TagAggregate::TagAggregate(ConstBuffer<TagType> _tag_types) noexcept
+	:tag_types(_tag_types.begin(), _tag_types.end())
+{
+}
+
+bool
+TagAggregate::Matches(ConstBuffer<TagType> other) const noexcept
+{
+	return std::equal(tag_types.begin(), tag_types.end(),
+			  other.begin(), other.end());
+}
+
+static void
+AddDuration(SearchStats &stats, const Tag &tag) noexcept
+{
+	++stats.n_songs;
+	if (!tag.duration.IsNegative())
+		stats.total_duration += tag.duration;
+}
+
+static void
+SubtractDuration(SearchStats &stats, const Tag &tag) noexcept
+{
+	assert(stats.n_songs > 0);
+	--stats.n_songs;
+	if (!tag.duration.IsNegative())
+		stats.total_duration -= tag.duration;
+}
+
+void
+TagAggregate::Add(Node &node, const Tag &tag,
+		  ConstBuffer<TagType> types) noexcept
+{
+	if (types.empty())
+		return;
+
+	const auto type = types.shift();
+
+	VisitTagWithFallbackOrEmpty(tag, type, [&node, &tag, types](const char *value){
+			const std::string_view key(value);
+			auto i = node.children.lower_bound(key);
+			if (i == node.children.end() || i->first != key)
+				i = node.children.emplace_hint(i, key, Node());
+
+			AddDuration(i->second.stats, tag);
+			Add(i->second, tag, types);
+		});
+}
+
+void
+TagAggregate::Remove(Node &node, const Tag &tag,
+		     ConstBuffer<TagType> types) noexcept
+{
+	if (types.empty())
+		return;
+
+	const auto type = types.shift();
+
+	VisitTagWithFallbackOrEmpty(tag, type, [&node, &tag, types](const char *value){
+			auto i = node.children.find(std::string_view(value));
+			assert(i != node.children.end());
+			if (i == node.children.end())
+				return;
+
+			Remove(i->second, tag, types);
+
+			SubtractDuration(i->second.stats, tag);
+			if (i->second.stats.n_songs == 0)
+				node.children.erase(i);
+		});
+}
+
+void
+TagAggregate::Add(const Tag &tag) noexcept
+{
+	AddDuration(root.stats, tag);
+	Add(root, tag, {tag_types.data(), tag_types.size()});
+}
+
+void
+TagAggregate::Remove(const Tag &tag) noexcept
+{
+	Remove(root, tag, {tag_types.data(), tag_types.size()});
+	SubtractDuration(root.stats, tag);
+}
+
+void
+TagAggregate::Export(RecursiveMap<std::string> &dest, const Node &src)
+{
+	for (const auto &[value, child] : src.children)
+		Export(dest.emplace_hint(dest.end(), value,
+					 RecursiveMap<std::string>())->second,
+		       child);
+}
+
+RecursiveMap<std::string>
+TagAggregate::ToRecursiveMap() const
+{
+	RecursiveMap<std::string> result;
+	Export(result, root);
+	return result;
+}
+
+TagCountMap
+TagAggregate::ToCountMap() const
+{
+	TagCountMap result;
+	for (const auto &[value, child] : root.children)
+		result.emplace_hint(result.end(), value, child.stats);
+	return result;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DB_SIMPLE_TAG_AGGREGATE_HXX
+#define MPD_DB_SIMPLE_TAG_AGGREGATE_HXX
+
+#include "db/TagCount.hxx"
+#include "tag/Type.h"
+#include "util/Compiler.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Tag;
+template<typename T> struct ConstBuffer;
+template<typename Key> class RecursiveMap;
+
+/**
+ * A materialized "group by" over all songs of a database: for each
+ * value of the first tag type, the number of songs and their total
+ * duration, and nested below that, the same for each following tag
+ * type.  It answers "list" and "count" with grouping without walking
+ * the database, and it is updated incrementally by Add() and
+ * Remove().
+ *
+ * Values are visited like CollectUniqueTags() does, i.e. with
+ * fallback tags and with an empty string for songs without a value.
+ */
+class TagAggregate {
+	struct Node {
+		SearchStats stats;
+
+		std::map<std::string, Node, std::less<>> children;
+	};
+
+	const std::vector<TagType> tag_types;
+
+	Node root;
+
+public:
+	explicit TagAggregate(ConstBuffer<TagType> _tag_types) noexcept;
+
+	TagAggregate(const TagAggregate &) = delete;
+	TagAggregate &operator=(const TagAggregate &) = delete;
+
+	/**
+	 * Was this object created for the given tag types?
+	 */
+	gcc_pure
+	bool Matches(ConstBuffer<TagType> other) const noexcept;
+
+	void Add(const Tag &tag) noexcept;
+
+	/**
+	 * Undo Add().  The #Tag must be equal to the one passed to
+	 * Add().
+	 */
+	void Remove(const Tag &tag) noexcept;
+
+	/**
+	 * Convert to the return value of
+	 * Database::CollectUniqueTags().
+	 */
+	RecursiveMap<std::string> ToRecursiveMap() const;
+
+	/**
+	 * Convert the first level to the return value of
+	 * Database::CountTags().
+	 */
+	TagCountMap ToCountMap() const;
+
+private:
+	static void Add(Node &node, const Tag &tag,
+			ConstBuffer<TagType> types) noexcept;
+	static void Remove(Node &node, const Tag &tag,
+			   ConstBuffer<TagType> types) noexcept;
+	static void Export(RecursiveMap<std::string> &dest, const Node &src);
+};
+
+#endif
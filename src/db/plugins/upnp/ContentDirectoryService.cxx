@@ -22,11 +22,17 @@
 #include "lib/upnp/UniqueIxml.hxx"
 #include "lib/upnp/Action.hxx"
 #include "Directory.hxx"
+#include "thread/Thread.hxx"
+#include "util/BindMethod.hxx"
 #include "util/NumberParser.hxx"
 #include "util/RuntimeError.hxx"
 #include "util/ScopeExit.hxx"
 #include "util/StringFormat.hxx"
 
+#include <algorithm>
+#include <exception>
+#include <list>
+
 static void
 ReadResultTag(UPnPDirContent &dirbuf, IXML_Document *response)
 {
@@ -81,6 +87,93 @@ ContentDirectoryService::readDirSlice(UpnpClient_Handle hdl,
 	ReadResultTag(dirbuf, response);
 }
 
+/**
+ * The maximum number of concurrent "Browse" requests for one large
+ * container.
+ */
+static constexpr unsigned MAX_CONCURRENT_BROWSE = 4;
+
+namespace {
+
+/**
+ * Reads a range of a container's children on a separate thread.
+ */
+class BrowseRangeJob {
+	const ContentDirectoryService &service;
+	const UpnpClient_Handle handle;
+	const char *const object_id;
+
+	unsigned offset;
+	const unsigned end, slice_size;
+
+	Thread thread{BIND_THIS_METHOD(Run)};
+
+	std::exception_ptr error;
+
+public:
+	UPnPDirContent content;
+
+	BrowseRangeJob(const ContentDirectoryService &_service,
+		       UpnpClient_Handle _handle, const char *_object_id,
+		       unsigned _offset, unsigned _end,
+		       unsigned _slice_size) noexcept
+		:service(_service), handle(_handle), object_id(_object_id),
+		 offset(_offset), end(_end), slice_size(_slice_size) {}
+
+	void Start() {
+		thread.Start();
+	}
+
+	/**
+	 * Wait for the thread to finish.  Returns the error which
+	 * occurred in the thread.
+	 */
+	std::exception_ptr Join() noexcept {
+		thread.Join();
+		return error;
+	}
+
+	/**
+	 * Wait for all jobs to finish and rethrow the first error.
+	 */
+	static void JoinAll(std::list<BrowseRangeJob> &jobs);
+
+private:
+	void Run() noexcept {
+		try {
+			while (offset < end) {
+				unsigned count, total;
+				service.readDirSlice(handle, object_id, offset,
+						     std::min(slice_size,
+							      end - offset),
+						     content, count, total);
+				if (count == 0)
+					break;
+
+				offset += count;
+			}
+		} catch (...) {
+			error = std::current_exception();
+		}
+	}
+};
+
+void
+BrowseRangeJob::JoinAll(std::list<BrowseRangeJob> &jobs)
+{
+	std::exception_ptr error;
+	for (auto &job : jobs) {
+		auto e = job.Join();
+		if (e && !error)
+			error = std::move(e);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+}
+
 UPnPDirContent
 ContentDirectoryService::readDir(UpnpClient_Handle handle,
 				 const char *objectId) const
@@ -88,12 +181,57 @@ ContentDirectoryService::readDir(UpnpClient_Handle handle,
 	UPnPDirContent dirbuf;
 	unsigned offset = 0, total = -1, count;
 
-	do {
-		readDirSlice(handle, objectId, offset, m_rdreqcnt, dirbuf,
-			     count, total);
+	readDirSlice(handle, objectId, offset, m_rdreqcnt, dirbuf,
+		     count, total);
+	offset += count;
 
-		offset += count;
-	} while (count > 0 && offset < total);
+	if (count == 0 || offset >= total)
+		return dirbuf;
+
+	if (total == unsigned(-1)) {
+		/* the server did not tell us how large the container
+		   is; read the remaining slices one by one */
+		do {
+			readDirSlice(handle, objectId, offset, m_rdreqcnt,
+				     dirbuf, count, total);
+			offset += count;
+		} while (count > 0 && offset < total);
+
+		return dirbuf;
+	}
+
+	/* this is a large container: split the rest into ranges and
+	   fetch them concurrently; the number of items returned by
+	   the first request is what this server is willing to send
+	   per request */
+	const unsigned remaining = total - offset;
+	const unsigned n_slices = (remaining + count - 1) / count;
+	const unsigned n_jobs = std::min(n_slices, MAX_CONCURRENT_BROWSE);
+	const unsigned range_size = (n_slices + n_jobs - 1) / n_jobs * count;
+
+	std::list<BrowseRangeJob> jobs;
+	for (unsigned start = offset; start < total; start += range_size)
+		jobs.emplace_back(*this, handle, objectId,
+				  start, std::min(start + range_size, total),
+				  count);
+
+	for (auto i = jobs.begin(); i != jobs.end(); ++i) {
+		try {
+			i->Start();
+		} catch (...) {
+			/* join the jobs which have already been
+			   started */
+			for (auto j = jobs.begin(); j != i; ++j)
+				j->Join();
+			throw;
+		}
+	}
+
+	BrowseRangeJob::JoinAll(jobs);
+
+	for (auto &job : jobs)
+		for (auto &object : job.content.objects)
+			dirbuf.objects.emplace_back(std::move(object));
 
 	return dirbuf;
 }
@@ -74,6 +74,7 @@ public:
 	Tag tag;
 
 	UPnPDirObject() = default;
+	UPnPDirObject(const UPnPDirObject &) = default;
 	UPnPDirObject(UPnPDirObject &&) = default;
 
 	~UPnPDirObject() noexcept;
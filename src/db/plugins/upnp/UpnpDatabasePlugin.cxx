@@ -28,6 +28,8 @@
 #include "db/Selection.hxx"
 #include "db/VHelper.hxx"
 #include "db/UniqueTags.hxx"
+#include "db/Helpers.hxx"
+#include "db/TagCount.hxx"
 #include "db/DatabaseError.hxx"
 #include "db/LightDirectory.hxx"
 #include "song/LightSong.hxx"
@@ -37,10 +39,14 @@
 #include "tag/Table.hxx"
 #include "fs/Traits.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/LruCache.hxx"
 #include "util/RecursiveMap.hxx"
 #include "util/SplitString.hxx"
 
 #include <cassert>
+#include <chrono>
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -71,11 +77,63 @@ public:
 	}
 };
 
+/**
+ * How long is a SystemUpdateID check trusted?  This avoids one
+ * request per song when a client adds many songs.
+ */
+static constexpr std::chrono::steady_clock::duration CACHE_CHECK_INTERVAL =
+	std::chrono::seconds(5);
+
 class UpnpDatabase : public Database {
 	EventLoop &event_loop;
 	UpnpClient_Handle handle;
 	UPnPDeviceDirectory *discovery;
 
+	/**
+	 * Cached ContentDirectory responses of one server.  They are
+	 * discarded as soon as the server reports a different
+	 * SystemUpdateID.
+	 */
+	struct ServerCache {
+		std::chrono::steady_clock::time_point next_check;
+
+		unsigned system_update_id;
+
+		/**
+		 * Is #system_update_id known?  If the server does
+		 * not implement "GetSystemUpdateID", the cache is
+		 * cleared after each #CACHE_CHECK_INTERVAL.
+		 */
+		bool valid = false;
+
+		/**
+		 * "Browse" results, indexed by container ObjectID.
+		 */
+		LruCache<std::shared_ptr<const UPnPDirContent>, 256> containers;
+
+		/**
+		 * Objects resolved by Namei(), indexed by their path
+		 * (without the server name).
+		 */
+		LruCache<UPnPDirObject, 4096> paths;
+
+		/**
+		 * Objects obtained by ReadNode(), indexed by ObjectID.
+		 */
+		LruCache<UPnPDirObject, 4096> nodes;
+
+		void Clear() noexcept {
+			containers.clear();
+			paths.clear();
+			nodes.clear();
+		}
+	};
+
+	/**
+	 * Indexed by ContentDirectoryService::GetURI().
+	 */
+	mutable std::map<std::string, ServerCache, std::less<>> caches;
+
 public:
 	explicit UpnpDatabase(EventLoop &_event_loop) noexcept
 		:Database(upnp_db_plugin),
@@ -99,6 +157,9 @@ public:
 	[[nodiscard]] RecursiveMap<std::string> CollectUniqueTags(const DatabaseSelection &selection,
 						    ConstBuffer<TagType> tag_types) const override;
 
+	[[nodiscard]] TagCountMap CountTags(const DatabaseSelection &selection,
+					    TagType group) const override;
+
 	[[nodiscard]] DatabaseStats GetStats(const DatabaseSelection &selection) const override;
 
 	[[nodiscard]] std::chrono::system_clock::time_point GetUpdateStamp() const noexcept override {
@@ -106,6 +167,20 @@ public:
 	}
 
 private:
+	/**
+	 * Obtain the cache for the given server, after clearing it if
+	 * the server's SystemUpdateID has changed.
+	 */
+	ServerCache &GetCache(const ContentDirectoryService &server) const;
+
+	/**
+	 * Read a container's children, either from the cache or from
+	 * the server.
+	 */
+	std::shared_ptr<const UPnPDirContent> ReadDir(const ContentDirectoryService &server,
+						      ServerCache &cache,
+						      const char *objid) const;
+
 	void VisitServer(const ContentDirectoryService &server,
 			 std::forward_list<std::string_view> &&vpath,
 			 const DatabaseSelection &selection,
@@ -127,12 +202,14 @@ private:
 				   const DatabaseSelection &selection) const;
 
 	UPnPDirObject Namei(const ContentDirectoryService &server,
+			    ServerCache &cache,
 			    std::forward_list<std::string_view> &&vpath) const;
 
 	/**
 	 * Take server and objid, return metadata.
 	 */
 	UPnPDirObject ReadNode(const ContentDirectoryService &server,
+			       ServerCache &cache,
 			       const char *objid) const;
 
 	/**
@@ -170,6 +247,7 @@ UpnpDatabase::Open()
 void
 UpnpDatabase::Close() noexcept
 {
+	caches.clear();
 	delete discovery;
 	UpnpClientGlobalFinish();
 }
@@ -200,16 +278,19 @@ UpnpDatabase::GetSong(std::string_view uri) const
 		throw DatabaseError(DatabaseErrorCode::NOT_FOUND,
 				    "No such song");
 
+	auto &cache = GetCache(server);
+
 	UPnPDirObject dirent;
 	if (vpath.front() != rootid) {
-		dirent = Namei(server, std::move(vpath));
+		dirent = Namei(server, cache, std::move(vpath));
 	} else {
 		vpath.pop_front();
 		if (vpath.empty())
 			throw DatabaseError(DatabaseErrorCode::NOT_FOUND,
 					    "No such song");
 
-		dirent = ReadNode(server, std::string(vpath.front()).c_str());
+		dirent = ReadNode(server, cache,
+				  std::string(vpath.front()).c_str());
 	}
 
 	return new UpnpSong(std::move(dirent), uri);
@@ -375,14 +456,64 @@ UpnpDatabase::SearchSongs(const ContentDirectoryService &server,
 	}
 }
 
+UpnpDatabase::ServerCache &
+UpnpDatabase::GetCache(const ContentDirectoryService &server) const
+{
+	auto &cache = caches[server.GetURI()];
+
+	const auto now = std::chrono::steady_clock::now();
+	if (now < cache.next_check)
+		return cache;
+
+	try {
+		const unsigned id = server.getSystemUpdateID(handle);
+		if (!cache.valid || id != cache.system_update_id) {
+			cache.Clear();
+			cache.system_update_id = id;
+			cache.valid = true;
+		}
+
+		cache.next_check = now + CACHE_CHECK_INTERVAL;
+	} catch (...) {
+		/* we can't know whether the cache is stale; fall back
+		   to discarding it after CACHE_CHECK_INTERVAL, instead
+		   of repeating the failing request on every access */
+		cache.Clear();
+		cache.valid = false;
+		cache.next_check = now + CACHE_CHECK_INTERVAL;
+	}
+
+	return cache;
+}
+
+std::shared_ptr<const UPnPDirContent>
+UpnpDatabase::ReadDir(const ContentDirectoryService &server,
+		      ServerCache &cache, const char *objid) const
+{
+	const auto *cached = cache.containers.Lookup(objid);
+	if (cached != nullptr)
+		return *cached;
+
+	auto content =
+		std::make_shared<const UPnPDirContent>(server.readDir(handle,
+								      objid));
+	cache.containers.Store(objid, content);
+	return content;
+}
+
 UPnPDirObject
 UpnpDatabase::ReadNode(const ContentDirectoryService &server,
-		       const char *objid) const
+		       ServerCache &cache, const char *objid) const
 {
+	const auto *cached = cache.nodes.Lookup(objid);
+	if (cached != nullptr)
+		return *cached;
+
 	auto dirbuf = server.getMetadata(handle, objid);
 	if (dirbuf.objects.size() != 1)
 		throw std::runtime_error("Bad resource");
 
+	cache.nodes.Store(objid, dirbuf.objects.front());
 	return std::move(dirbuf.objects.front());
 }
 
@@ -390,10 +521,12 @@ std::string
 UpnpDatabase::BuildPath(const ContentDirectoryService &server,
 			const UPnPDirObject& idirent) const
 {
+	auto &cache = GetCache(server);
+
 	const char *pid = idirent.id.c_str();
 	std::string path;
 	while (strcmp(pid, rootid) != 0) {
-		auto dirent = ReadNode(server, pid);
+		auto dirent = ReadNode(server, cache, pid);
 		pid = dirent.parent_id.c_str();
 
 		if (path.empty())
@@ -409,33 +542,47 @@ UpnpDatabase::BuildPath(const ContentDirectoryService &server,
 // Take server and internal title pathname and return objid and metadata.
 UPnPDirObject
 UpnpDatabase::Namei(const ContentDirectoryService &server,
+		    ServerCache &cache,
 		    std::forward_list<std::string_view> &&vpath) const
 {
 	if (vpath.empty())
 		// looking for root info
-		return ReadNode(server, rootid);
+		return ReadNode(server, cache, rootid);
+
+	std::string path;
+	for (const auto &i : vpath) {
+		if (!path.empty())
+			path.push_back('/');
+		path.append(i);
+	}
+
+	const auto *cached = cache.paths.Lookup(path);
+	if (cached != nullptr)
+		return *cached;
 
 	std::string objid(rootid);
 
 	// Walk the path elements, read each directory and try to find the next one
 	while (true) {
-		auto dirbuf = server.readDir(handle, objid.c_str());
+		const auto dirbuf = ReadDir(server, cache, objid.c_str());
 
 		// Look for the name in the sub-container list
-		UPnPDirObject *child = dirbuf.FindObject(vpath.front());
+		const UPnPDirObject *child = dirbuf->FindObject(vpath.front());
 		if (child == nullptr)
 			throw DatabaseError(DatabaseErrorCode::NOT_FOUND,
 					    "No such object");
 
 		vpath.pop_front();
-		if (vpath.empty())
-			return std::move(*child);
+		if (vpath.empty()) {
+			cache.paths.Store(std::move(path), *child);
+			return *child;
+		}
 
 		if (child->type != UPnPDirObject::Type::CONTAINER)
 			throw DatabaseError(DatabaseErrorCode::NOT_FOUND,
 					    "Not a container");
 
-		objid = std::move(child->id);
+		objid = child->id;
 	}
 }
 
@@ -511,6 +658,8 @@ UpnpDatabase::VisitServer(const ContentDirectoryService &server,
 	/* !Note: this *can't* be handled by Namei further down,
 	   because the path is not valid for traversal. Besides, it's
 	   just faster to access the target node directly */
+	auto &cache = GetCache(server);
+
 	if (!vpath.empty() && vpath.front() == rootid) {
 		vpath.pop_front();
 		if (vpath.empty())
@@ -523,7 +672,7 @@ UpnpDatabase::VisitServer(const ContentDirectoryService &server,
 					    "Not found");
 
 		if (visit_song) {
-			auto dirent = ReadNode(server, objid.c_str());
+			auto dirent = ReadNode(server, cache, objid.c_str());
 
 			if (dirent.type != UPnPDirObject::Type::ITEM ||
 			    dirent.item_class != UPnPDirObject::ItemClass::MUSIC)
@@ -540,7 +689,7 @@ UpnpDatabase::VisitServer(const ContentDirectoryService &server,
 	}
 
 	// Translate the target path into an object id and the associated metadata.
-	const auto tdirent = Namei(server, std::move(vpath));
+	const auto tdirent = Namei(server, cache, std::move(vpath));
 
 	/* If recursive is set, this is a search... No use sending it
 	   if the filter is empty. In this case, we implement limited
@@ -565,8 +714,8 @@ UpnpDatabase::VisitServer(const ContentDirectoryService &server,
 	/* Target was a a container. Visit it. We could read slices
 	   and loop here, but it's not useful as mpd will only return
 	   data to the client when we're done anyway. */
-	const auto contents = server.readDir(handle, tdirent.id.c_str());
-	for (const auto &dirent : contents.objects) {
+	const auto contents = ReadDir(server, cache, tdirent.id.c_str());
+	for (const auto &dirent : contents->objects) {
 		const std::string uri = PathTraitsUTF8::Build(base_uri,
 							      dirent.name.c_str());
 		VisitObject(dirent, uri.c_str(),
@@ -630,6 +779,13 @@ UpnpDatabase::CollectUniqueTags(const DatabaseSelection &selection,
 	return ::CollectUniqueTags(*this, selection, tag_types);
 }
 
+TagCountMap
+UpnpDatabase::CountTags(const DatabaseSelection &selection,
+			TagType group) const
+{
+	return ::CountTags(*this, selection, group);
+}
+
 DatabaseStats
 UpnpDatabase::GetStats(const DatabaseSelection &) const
 {
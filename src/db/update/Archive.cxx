@@ -86,7 +86,20 @@ UpdateWalk::UpdateArchiveTree(ArchiveFile &archive, Directory &directory,
 					     directory.GetPath(), name);
 			}
 		} else {
-			if (!song->UpdateFileInArchive(archive)) {
+			{
+				const ScopeDatabaseLock protect;
+				directory.BeginSongTagUpdate(*song);
+			}
+
+			const bool recognized =
+				song->UpdateFileInArchive(archive);
+
+			{
+				const ScopeDatabaseLock protect;
+				directory.EndSongTagUpdate(*song);
+			}
+
+			if (!recognized) {
 				FormatDebug(update_domain,
 					    "deleting unrecognized file %s/%s",
 					    directory.GetPath(), name);
@@ -0,0 +1,366 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "FanotifyUpdate.hxx"
+#include "InotifyQueue.hxx"
+#include "InotifyDomain.hxx"
+#include "storage/StorageInterface.hxx"
+#include "event/SocketEvent.hxx"
+#include "io/Open.hxx"
+#include "io/UniqueFileDescriptor.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileSystem.hxx"
+#include "fs/Traits.hxx"
+#include "system/Error.hxx"
+#include "system/MountInfo.hxx"
+#include "util/LruCache.hxx"
+#include "util/StringAPI.hxx"
+#include "util/StringFormat.hxx"
+#include "util/RuntimeError.hxx"
+#include "util/Compiler.h"
+#include "Log.hxx"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/fanotify.h>
+
+static constexpr uint64_t FAN_MASK =
+	FAN_CLOSE_WRITE|FAN_CREATE|FAN_DELETE|FAN_MOVED_FROM|FAN_MOVED_TO
+	|FAN_ONDIR;
+
+namespace {
+
+/**
+ * A directory which was resolved from a file handle reported by the
+ * kernel.
+ */
+struct ResolvedDirectory {
+	/**
+	 * Is this directory inside the music directory (and within
+	 * the configured depth)?
+	 */
+	bool inside;
+
+	/**
+	 * The URI relative to the music directory (in the filesystem
+	 * charset).  Only valid if #inside is true.
+	 */
+	std::string uri;
+};
+
+class FanotifyWatcher final {
+	SocketEvent socket_event;
+
+	/**
+	 * The music directory; it is used as "mount_fd" for
+	 * open_by_handle_at().
+	 */
+	UniqueFileDescriptor root_fd;
+
+	/**
+	 * The canonical path of the music directory, as reported by
+	 * /proc/self/fd.
+	 */
+	const AllocatedPath root_path;
+
+	const unsigned max_depth;
+
+	InotifyQueue queue;
+
+	/**
+	 * Maps file handles to directories.  The mark covers the
+	 * whole filesystem, and this avoids resolving the handle with
+	 * a system call for each event.
+	 */
+	LruCache<ResolvedDirectory, 1024> directory_cache;
+
+public:
+	FanotifyWatcher(EventLoop &loop, UpdateService &update,
+			UniqueFileDescriptor &&_fd,
+			UniqueFileDescriptor &&_root_fd,
+			AllocatedPath &&_root_path,
+			unsigned _max_depth) noexcept;
+
+	~FanotifyWatcher() noexcept {
+		socket_event.Close();
+	}
+
+private:
+	/**
+	 * Look up the directory with the given file handle.  Returns
+	 * nullptr if the directory is outside of the music directory
+	 * or if it does not exist anymore.
+	 */
+	const std::string *ResolveDirectory(const struct file_handle &handle) noexcept;
+
+	void HandleEvent(uint64_t mask, const struct file_handle &handle,
+			 const char *name) noexcept;
+
+	void OnSocketReady(unsigned flags) noexcept;
+};
+
+}
+
+static FanotifyWatcher *fanotify_watcher;
+
+/**
+ * Determine the path of the given file descriptor.
+ */
+static AllocatedPath
+GetFileDescriptorPath(FileDescriptor fd) noexcept
+{
+	return ReadLink(Path::FromFS(StringFormat<32>("/proc/self/fd/%d",
+						      fd.Get())));
+}
+
+gcc_pure
+static unsigned
+GetUriDepth(std::string_view uri) noexcept
+{
+	if (uri.empty())
+		return 0;
+
+	unsigned depth = 1;
+	for (char ch : uri)
+		if (ch == '/')
+			++depth;
+	return depth;
+}
+
+/* we don't look at files with newlines in their name */
+gcc_pure
+static bool
+SkipFilename(const char *name) noexcept
+{
+	return PathTraitsFS::IsSpecialFilename(name) ||
+		std::strchr(name, '\n') != nullptr;
+}
+
+FanotifyWatcher::FanotifyWatcher(EventLoop &loop, UpdateService &update,
+				 UniqueFileDescriptor &&_fd,
+				 UniqueFileDescriptor &&_root_fd,
+				 AllocatedPath &&_root_path,
+				 unsigned _max_depth) noexcept
+	:socket_event(loop, BIND_THIS_METHOD(OnSocketReady),
+		      SocketDescriptor::FromFileDescriptor(_fd.Release())),
+	 root_fd(std::move(_root_fd)),
+	 root_path(std::move(_root_path)),
+	 max_depth(_max_depth),
+	 queue(loop, update)
+{
+	socket_event.ScheduleRead();
+}
+
+const std::string *
+FanotifyWatcher::ResolveDirectory(const struct file_handle &handle) noexcept
+{
+	const std::string_view key((const char *)&handle,
+				   sizeof(handle) + handle.handle_bytes);
+
+	const auto *cached = directory_cache.Lookup(key);
+	if (cached == nullptr) {
+		/* open_by_handle_at() does not modify the handle, but
+		   its prototype is not const-correct */
+		int fd = open_by_handle_at(root_fd.Get(),
+					   const_cast<struct file_handle *>(&handle),
+					   O_PATH|O_CLOEXEC);
+		if (fd < 0) {
+			if (errno != ESTALE)
+				LogError(MakeErrno("open_by_handle_at() failed"));
+			return nullptr;
+		}
+
+		const UniqueFileDescriptor dir_fd(fd);
+		const auto path = GetFileDescriptorPath(dir_fd);
+		if (path.IsNull())
+			return nullptr;
+
+		ResolvedDirectory resolved{false, {}};
+		const char *relative = root_path.Relative(path);
+		if (relative != nullptr) {
+			resolved.inside = GetUriDepth(relative) <= max_depth;
+			resolved.uri = relative;
+		}
+
+		try {
+			directory_cache.Store(std::string(key),
+					      std::move(resolved));
+		} catch (...) {
+			/* out of memory - not fatal, this is just a
+			   cache */
+			return nullptr;
+		}
+
+		cached = directory_cache.Lookup(key);
+	}
+
+	return cached->inside ? &cached->uri : nullptr;
+}
+
+inline void
+FanotifyWatcher::HandleEvent(uint64_t mask, const struct file_handle &handle,
+			     const char *name) noexcept
+{
+	if ((mask & FAN_ONDIR) != 0 &&
+	    (mask & (FAN_MOVED_FROM|FAN_MOVED_TO|FAN_DELETE)) != 0)
+		/* a directory was renamed or deleted; the cached
+		   paths of its descendants are stale now */
+		directory_cache.clear();
+
+	if (SkipFilename(name))
+		return;
+
+	const std::string *directory_uri_fs = ResolveDirectory(handle);
+	if (directory_uri_fs == nullptr)
+		return;
+
+	std::string uri_fs;
+	if (StringIsEqual(name, ".mpdignore"))
+		/* the exclude list was modified: update the whole
+		   directory */
+		uri_fs = *directory_uri_fs;
+	else if (directory_uri_fs->empty())
+		uri_fs = name;
+	else
+		uri_fs = *directory_uri_fs + '/' + name;
+
+	if (uri_fs.empty()) {
+		queue.Enqueue("");
+		return;
+	}
+
+	const auto uri_utf8 = Path::FromFS(uri_fs.c_str()).ToUTF8();
+	if (!uri_utf8.empty())
+		queue.Enqueue(uri_utf8.c_str());
+}
+
+void
+FanotifyWatcher::OnSocketReady(unsigned) noexcept
+{
+	alignas(struct fanotify_event_metadata) uint8_t buffer[8192];
+
+	auto fd = socket_event.GetSocket().ToFileDescriptor();
+	ssize_t nbytes = fd.Read(buffer, sizeof(buffer));
+	if (nbytes < 0) {
+		if (errno != EAGAIN)
+			LogError(MakeErrno("Failed to read from fanotify"));
+		return;
+	}
+
+	const auto *event = (const struct fanotify_event_metadata *)buffer;
+	for (; FAN_EVENT_OK(event, nbytes); event = FAN_EVENT_NEXT(event, nbytes)) {
+		if (event->vers != FANOTIFY_METADATA_VERSION)
+			continue;
+
+		if ((event->mask & FAN_Q_OVERFLOW) != 0) {
+			/* events were lost: update everything */
+			LogWarning(inotify_domain, "fanotify queue overflow");
+			directory_cache.clear();
+			queue.Enqueue("");
+			continue;
+		}
+
+		/* with FAN_REPORT_DFID_NAME, the event is followed by
+		   a record describing the directory and the name of
+		   the affected entry */
+		const auto *p = (const uint8_t *)event + event->metadata_len;
+		const auto *end = (const uint8_t *)event + event->event_len;
+		while (p + sizeof(struct fanotify_event_info_header) <= end) {
+			const auto &header =
+				*(const struct fanotify_event_info_header *)p;
+			if (header.len == 0 || p + header.len > end)
+				break;
+
+			if (header.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME) {
+				const auto &info =
+					*(const struct fanotify_event_info_fid *)p;
+				const auto &handle =
+					*(const struct file_handle *)info.handle;
+				const char *name =
+					(const char *)handle.f_handle + handle.handle_bytes;
+				HandleEvent(event->mask, handle, name);
+				break;
+			}
+
+			p += header.len;
+		}
+	}
+}
+
+bool
+mpd_fanotify_init(EventLoop &loop, Storage &storage, UpdateService &update,
+		  unsigned max_depth) noexcept
+try {
+	LogDebug(inotify_domain, "initializing fanotify");
+
+	const auto path = storage.MapFS("");
+	if (path.IsNull()) {
+		LogDebug(inotify_domain, "no music directory configured");
+		return true;
+	}
+
+	int fd = fanotify_init(FAN_CLASS_NOTIF|FAN_REPORT_DFID_NAME
+			       |FAN_CLOEXEC|FAN_NONBLOCK,
+			       O_RDONLY|O_CLOEXEC);
+	if (fd < 0)
+		throw MakeErrno("fanotify_init() failed");
+
+	UniqueFileDescriptor fanotify_fd(fd);
+
+	if (fanotify_mark(fanotify_fd.Get(),
+			  FAN_MARK_ADD|FAN_MARK_FILESYSTEM, FAN_MASK,
+			  AT_FDCWD, path.c_str()) < 0)
+		throw FormatErrno("Failed to mark '%s'", path.c_str());
+
+	auto root_fd = OpenDirectory(path.c_str(), O_CLOEXEC);
+	auto root_path = GetFileDescriptorPath(root_fd);
+	if (root_path.IsNull())
+		throw FormatErrno("Failed to resolve '%s'", path.c_str());
+
+	/* the mark covers only the filesystem which contains the
+	   music directory; changes on filesystems mounted inside it
+	   would be missed (mounts added later are not detected) */
+	if (HasMountBelow(root_path.c_str()))
+		throw FormatRuntimeError("Another filesystem is mounted inside '%s'",
+					 path.c_str());
+
+	fanotify_watcher = new FanotifyWatcher(loop, update,
+					       std::move(fanotify_fd),
+					       std::move(root_fd),
+					       std::move(root_path),
+					       max_depth);
+
+	LogDebug(inotify_domain, "watching music directory with fanotify");
+	return true;
+} catch (...) {
+	LogError(std::current_exception());
+	return false;
+}
+
+void
+mpd_fanotify_finish() noexcept
+{
+	delete fanotify_watcher;
+	fanotify_watcher = nullptr;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_FANOTIFY_UPDATE_HXX
+#define MPD_FANOTIFY_UPDATE_HXX
+
+class EventLoop;
+class Storage;
+class UpdateService;
+
+/**
+ * Watch the music directory with fanotify instead of inotify.  A
+ * single mark on the whole filesystem replaces the per-directory
+ * inotify watches, so startup does not need to walk the directory
+ * tree and there is no limit on the number of directories.  This
+ * requires Linux 5.9 and the capabilities CAP_SYS_ADMIN and
+ * CAP_DAC_READ_SEARCH.
+ *
+ * The mark covers only one filesystem, therefore fanotify is not
+ * used if other filesystems are mounted inside the music directory.
+ *
+ * Errors are logged.
+ *
+ * @return true on success, false if fanotify is not available
+ */
+bool
+mpd_fanotify_init(EventLoop &loop, Storage &storage, UpdateService &update,
+		  unsigned max_depth) noexcept;
+
+void
+mpd_fanotify_finish() noexcept;
+
+#endif
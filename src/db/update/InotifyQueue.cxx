@@ -19,30 +19,63 @@
 
 #include "InotifyQueue.hxx"
 #include "InotifyDomain.hxx"
+#include "event/Loop.hxx"
 #include "Service.hxx"
 #include "Log.hxx"
 #include "protocol/Ack.hxx" // for class ProtocolError
-#include "util/StringCompare.hxx"
+#include "util/UriRelative.hxx"
+
+#include <algorithm>
 
 /**
- * Wait this long after the last change before calling
- * UpdateService::Enqueue().  This increases the probability that
- * updates can be bundled.
+ * Wait this long after the last change of a file or directory before
+ * calling UpdateService::Enqueue().  This increases the probability
+ * that updates can be bundled.
  */
 static constexpr Event::Duration INOTIFY_UPDATE_DELAY =
 	std::chrono::seconds(5);
 
+/**
+ * Don't let a file or directory which keeps changing postpone its
+ * update longer than this.
+ */
+static constexpr Event::Duration INOTIFY_UPDATE_MAX_DELAY =
+	std::chrono::seconds(30);
+
+void
+InotifyQueue::ScheduleDelay() noexcept
+{
+	if (queue.empty()) {
+		delay_event.Cancel();
+		return;
+	}
+
+	auto due = queue.front().due;
+	for (const auto &i : queue)
+		if (i.due < due)
+			due = i.due;
+
+	const auto now = delay_event.GetEventLoop().SteadyNow();
+	delay_event.Schedule(due > now ? due - now : Event::Duration{});
+}
+
 void
 InotifyQueue::OnDelay() noexcept
 {
-	unsigned id;
+	const auto now = delay_event.GetEventLoop().SteadyNow();
 
-	while (!queue.empty()) {
-		const char *uri_utf8 = queue.front().c_str();
+	for (auto i = queue.begin(); i != queue.end();) {
+		if (i->due > now) {
+			++i;
+			continue;
+		}
+
+		const char *uri_utf8 = i->uri.c_str();
+		unsigned id;
 
 		try {
 			try {
-				id = update.Enqueue(uri_utf8, false);
+				id = update.Enqueue(uri_utf8, false, true);
 			} catch (const ProtocolError &e) {
 				if (e.GetCode() == ACK_ERROR_UPDATE_ALREADY) {
 					/* retry later */
@@ -55,49 +88,55 @@ InotifyQueue::OnDelay() noexcept
 		} catch (...) {
 			FormatError(std::current_exception(),
 				    "Failed to enqueue '%s'", uri_utf8);
-			queue.pop_front();
+			i = queue.erase(i);
 			continue;
 		}
 
 		FormatDebug(inotify_domain, "updating '%s' job=%u",
 			    uri_utf8, id);
 
-		queue.pop_front();
+		i = queue.erase(i);
 	}
-}
-
-gcc_pure
-static bool
-path_in(const char *path, const char *possible_parent) noexcept
-{
-	if (StringIsEmpty(path))
-		return true;
 
-	auto rest = StringAfterPrefix(path, possible_parent);
-	return rest != nullptr &&
-		(StringIsEmpty(rest) || rest[0] == '/');
+	ScheduleDelay();
 }
 
 void
 InotifyQueue::Enqueue(const char *uri_utf8) noexcept
 {
-	delay_event.Schedule(INOTIFY_UPDATE_DELAY);
+	const auto now = delay_event.GetEventLoop().SteadyNow();
+	auto first = now;
 
 	for (auto i = queue.begin(), end = queue.end(); i != end;) {
-		const char *current_uri = i->c_str();
+		const char *current_uri = i->uri.c_str();
 
-		if (path_in(uri_utf8, current_uri))
-			/* already enqueued */
+		if (uri_is_child_or_same(current_uri, uri_utf8)) {
+			/* already enqueued; postpone it (but not
+			   forever) */
+			i->due = std::min(now + INOTIFY_UPDATE_DELAY,
+					  i->first + INOTIFY_UPDATE_MAX_DELAY);
+
+			/* if this item was the earliest one, the
+			   timer fires too early, and OnDelay() will
+			   reschedule it */
+			delay_event.ScheduleEarlier(i->due > now
+						    ? i->due - now
+						    : Event::Duration{});
 			return;
+		}
 
-		if (path_in(current_uri, uri_utf8))
+		if (uri_is_child(uri_utf8, current_uri)) {
 			/* existing path is a sub-path of the new
 			   path; we can dequeue the existing path and
 			   update the new path instead */
+			first = std::min(first, i->first);
 			i = queue.erase(i);
-		else
+		} else
 			++i;
 	}
 
-	queue.emplace_back(uri_utf8);
+	const auto due = std::min(now + INOTIFY_UPDATE_DELAY,
+				  first + INOTIFY_UPDATE_MAX_DELAY);
+	queue.push_back({uri_utf8, first, due});
+	delay_event.ScheduleEarlier(due > now ? due - now : Event::Duration{});
 }
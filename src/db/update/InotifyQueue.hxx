@@ -30,7 +30,23 @@ class UpdateService;
 class InotifyQueue final {
 	UpdateService &update;
 
-	std::list<std::string> queue;
+	struct Item {
+		std::string uri;
+
+		/**
+		 * When was this item first enqueued?  This limits
+		 * how long further events can postpone it.
+		 */
+		Event::TimePoint first;
+
+		/**
+		 * When shall this item be passed to
+		 * UpdateService::Enqueue()?
+		 */
+		Event::TimePoint due;
+	};
+
+	std::list<Item> queue;
 
 	CoarseTimerEvent delay_event;
 
@@ -39,9 +55,20 @@ public:
 		:update(_update),
 		 delay_event(_loop, BIND_THIS_METHOD(OnDelay)) {}
 
+	/**
+	 * Enqueue an update of the given file or directory.  Events
+	 * for the same URI are coalesced: the update is postponed
+	 * until there have been no more events for a while.
+	 */
 	void Enqueue(const char *uri_utf8) noexcept;
 
 private:
+	/**
+	 * Schedule #delay_event for the earliest item.  This is
+	 * O(n), it is only called by OnDelay().
+	 */
+	void ScheduleDelay() noexcept;
+
 	void OnDelay() noexcept;
 };
 
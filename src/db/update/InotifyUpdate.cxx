@@ -29,13 +29,17 @@
 #include "fs/DirectoryReader.hxx"
 #include "fs/FileInfo.hxx"
 #include "fs/Traits.hxx"
+#include "event/FineTimerEvent.hxx"
 #include "thread/Mutex.hxx"
+#include "util/BindMethod.hxx"
 #include "util/Compiler.h"
+#include "util/StringAPI.hxx"
 #include "Log.hxx"
 
 #include <cassert>
 #include <cstring>
 #include <forward_list>
+#include <list>
 #include <map>
 #include <string>
 
@@ -104,6 +108,18 @@ static unsigned inotify_max_depth;
 static WatchDirectory *inotify_root;
 static std::map<int, WatchDirectory *> inotify_directories;
 
+/**
+ * The number of directories scanned by one OnScanTimer() call.
+ */
+static constexpr unsigned SCAN_BATCH = 16;
+
+/**
+ * Watch descriptors of directories which need to be scanned for
+ * subdirectories.
+ */
+static std::list<int> inotify_scan_queue;
+static FineTimerEvent *inotify_scan_timer;
+
 static void
 tree_add_watch_directory(WatchDirectory *directory)
 {
@@ -182,19 +198,36 @@ SkipFilename(Path name) noexcept
 		name.HasNewline();
 }
 
+/**
+ * Schedule a (non-recursive) scan of the given directory for new
+ * subdirectories to be watched; see OnScanTimer().
+ */
 static void
-recursive_watch_subdirectories(WatchDirectory &parent,
-			       const Path path_fs,
-			       unsigned depth)
-try {
-	assert(depth <= inotify_max_depth);
-	assert(!path_fs.IsNull());
+ScheduleScanWatchDirectory(const WatchDirectory &directory) noexcept
+{
+	inotify_scan_queue.push_back(directory.descriptor);
 
-	++depth;
+	if (!inotify_scan_timer->IsPending())
+		inotify_scan_timer->Schedule({});
+}
 
+/**
+ * Register all subdirectories of the given directory in inotify and
+ * schedule scanning them as well.
+ */
+static void
+scan_watch_directory(WatchDirectory &parent)
+try {
+	const unsigned depth = parent.GetDepth() + 1;
 	if (depth > inotify_max_depth)
 		return;
 
+	const auto uri_fs = parent.GetUriFS();
+	const auto &root = inotify_root->name;
+	const auto path_fs = uri_fs.IsNull()
+		? root
+		: (root / uri_fs);
+
 	DirectoryReader dir(path_fs);
 	while (dir.ReadEntry()) {
 		int ret;
@@ -242,12 +275,34 @@ try {
 
 		tree_add_watch_directory(child);
 
-		recursive_watch_subdirectories(*child, child_path_fs, depth);
+		ScheduleScanWatchDirectory(*child);
 	}
 } catch (...) {
 	LogError(std::current_exception());
 }
 
+static void
+OnScanTimer() noexcept
+{
+	for (unsigned n = 0; n < SCAN_BATCH && !inotify_scan_queue.empty(); ++n) {
+		const int wd = inotify_scan_queue.front();
+		inotify_scan_queue.pop_front();
+
+		/* the directory may have been removed meanwhile */
+		WatchDirectory *directory = tree_find_watch_directory(wd);
+		if (directory != nullptr)
+			scan_watch_directory(*directory);
+	}
+
+	if (!inotify_scan_queue.empty())
+		/* continue after the EventLoop has polled (like
+		   Partition::OnResolveTimer() does), so inotify
+		   events queued meanwhile don't overflow */
+		inotify_scan_timer->Schedule(std::chrono::milliseconds(1));
+	else
+		LogDebug(inotify_domain, "watching all directories");
+}
+
 gcc_pure
 unsigned
 WatchDirectory::GetDepth() const noexcept
@@ -262,7 +317,7 @@ WatchDirectory::GetDepth() const noexcept
 
 static void
 mpd_inotify_callback(int wd, unsigned mask,
-		     [[maybe_unused]] const char *name, [[maybe_unused]] void *ctx)
+		     const char *name, [[maybe_unused]] void *ctx)
 {
 	WatchDirectory *directory;
 
@@ -278,26 +333,36 @@ mpd_inotify_callback(int wd, unsigned mask,
 	}
 
 	if ((mask & (IN_ATTRIB|IN_CREATE|IN_MOVE)) != 0 &&
-	    (mask & IN_ISDIR) != 0) {
+	    (mask & IN_ISDIR) != 0)
 		/* a sub directory was changed: register those in
 		   inotify */
-		const auto &root = inotify_root->name;
-
-		const auto path_fs = uri_fs.IsNull()
-			? root
-			: (root / uri_fs);
-
-		recursive_watch_subdirectories(*directory, path_fs,
-					       directory->GetDepth());
-	}
-
-	if ((mask & (IN_CLOSE_WRITE|IN_MOVE|IN_DELETE)) != 0 ||
-	    /* at the maximum depth, we watch out for newly created
-	       directories */
-	    (directory->GetDepth() == inotify_max_depth &&
-	     (mask & (IN_CREATE|IN_ISDIR)) == (IN_CREATE|IN_ISDIR))) {
-		/* a file was changed, or a directory was
-		   moved/deleted: queue a database update */
+		ScheduleScanWatchDirectory(*directory);
+
+	if ((mask & IN_ISDIR) == 0 &&
+	    (mask & (IN_CLOSE_WRITE|IN_MOVE|IN_DELETE)) != 0 &&
+	    name != nullptr && *name != 0 &&
+	    !StringIsEqual(name, ".mpdignore")) {
+		/* a file was changed: update only this file */
+
+		const Path name_fs = Path::FromFS(name);
+		if (SkipFilename(name_fs) ||
+		    directory->exclude_list.Check(name_fs))
+			return;
+
+		const auto file_uri_fs = uri_fs.IsNull()
+			? AllocatedPath(name_fs)
+			: (uri_fs / name_fs);
+		const std::string uri_utf8 = file_uri_fs.ToUTF8();
+		if (!uri_utf8.empty())
+			inotify_queue->Enqueue(uri_utf8.c_str());
+	} else if ((mask & (IN_CLOSE_WRITE|IN_MOVE|IN_DELETE)) != 0 ||
+		   /* at the maximum depth, we watch out for newly
+		      created directories */
+		   (directory->GetDepth() == inotify_max_depth &&
+		    (mask & (IN_CREATE|IN_ISDIR)) == (IN_CREATE|IN_ISDIR))) {
+		/* a directory was moved/deleted (or the
+		   ".mpdignore" file was modified): queue a database
+		   update of the containing directory */
 
 		if (!uri_fs.IsNull()) {
 			const std::string uri_utf8 = uri_fs.ToUTF8();
@@ -347,10 +412,13 @@ mpd_inotify_init(EventLoop &loop, Storage &storage, UpdateService &update,
 
 	tree_add_watch_directory(inotify_root);
 
-	recursive_watch_subdirectories(*inotify_root, path, 0);
-
 	inotify_queue = new InotifyQueue(loop, update);
 
+	/* register the subdirectories in the background; this may
+	   take a while with a large music directory */
+	inotify_scan_timer = new FineTimerEvent(loop, BIND_FUNCTION(OnScanTimer));
+	ScheduleScanWatchDirectory(*inotify_root);
+
 	LogDebug(inotify_domain, "watching music directory");
 }
 
@@ -360,6 +428,8 @@ mpd_inotify_finish() noexcept
 	if (inotify_source == nullptr)
 		return;
 
+	delete inotify_scan_timer;
+	inotify_scan_queue.clear();
 	delete inotify_queue;
 	delete inotify_source;
 	delete inotify_root;
@@ -18,16 +18,58 @@
  */
 
 #include "Queue.hxx"
+#include "util/UriRelative.hxx"
 
 bool
+UpdateQueueItem::Covers(const char *path) const noexcept
+{
+	if (uri_is_child_or_same(path_utf8.c_str(), path))
+		return true;
+
+	for (const auto &i : more_paths)
+		if (uri_is_child_or_same(i.c_str(), path))
+			return true;
+
+	return false;
+}
+
+void
+UpdateQueueItem::Add(std::string &&path) noexcept
+{
+	if (Covers(path.c_str()))
+		return;
+
+	/* remove the paths which are covered by the new one */
+	more_paths.remove_if([&path](const std::string &i){
+		return uri_is_child(path.c_str(), i.c_str());
+	});
+
+	if (uri_is_child(path.c_str(), path_utf8.c_str()))
+		path_utf8 = std::move(path);
+	else
+		more_paths.emplace_front(std::move(path));
+}
+
+unsigned
 UpdateQueue::Push(SimpleDatabase &db, Storage &storage,
-		  std::string_view path, bool discard, unsigned id) noexcept
+		  std::string_view path, bool discard, unsigned id,
+		  bool merge) noexcept
 {
+	if (merge) {
+		for (auto &i : update_queue) {
+			if (i.merge && i.db == &db && i.storage == &storage &&
+			    i.discard == discard) {
+				i.Add(std::string(path));
+				return i.id;
+			}
+		}
+	}
+
 	if (update_queue.size() >= MAX_UPDATE_QUEUE_SIZE)
-		return false;
+		return 0;
 
-	update_queue.emplace_back(db, storage, path, discard, id);
-	return true;
+	update_queue.emplace_back(db, storage, path, discard, id, merge);
+	return id;
 }
 
 UpdateQueueItem
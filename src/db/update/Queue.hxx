@@ -22,6 +22,7 @@
 
 #include "util/Compiler.h"
 
+#include <forward_list>
 #include <string>
 #include <string_view>
 #include <list>
@@ -34,17 +35,34 @@ struct UpdateQueueItem {
 	Storage *storage;
 
 	std::string path_utf8;
+
+	/**
+	 * More paths to be updated by this job.  Mergeable requests
+	 * for the same database are merged into one queued job (see
+	 * UpdateQueue::Push()), so a burst of small updates (e.g. one
+	 * per file from inotify) doesn't save the database each
+	 * time.
+	 */
+	std::forward_list<std::string> more_paths;
+
 	unsigned id;
 	bool discard;
 
+	/**
+	 * May other requests be merged into this job?  This is only
+	 * set for jobs from the inotify/fanotify watcher; a job
+	 * requested by a client keeps its own id.
+	 */
+	bool merge = false;
+
 	UpdateQueueItem() noexcept:id(0) {}
 
 	UpdateQueueItem(SimpleDatabase &_db,
 			Storage &_storage,
 			std::string_view _path, bool _discard,
-			unsigned _id) noexcept
+			unsigned _id, bool _merge=false) noexcept
 		:db(&_db), storage(&_storage), path_utf8(_path),
-		 id(_id), discard(_discard) {}
+		 id(_id), discard(_discard), merge(_merge) {}
 
 	bool IsDefined() const noexcept {
 		return id != 0;
@@ -53,6 +71,18 @@ struct UpdateQueueItem {
 	void Clear() noexcept {
 		id = 0;
 	}
+
+	/**
+	 * Will this job update the given path (or one of its
+	 * parents)?
+	 */
+	gcc_pure
+	bool Covers(const char *path) const noexcept;
+
+	/**
+	 * Add another path to this job.
+	 */
+	void Add(std::string &&path) noexcept;
 };
 
 class UpdateQueue {
@@ -61,9 +91,20 @@ class UpdateQueue {
 	std::list<UpdateQueueItem> update_queue;
 
 public:
+	/**
+	 * Add a job to the queue.  If #merge is set and there is
+	 * already a queued mergeable job for the same database and
+	 * storage (and the same "discard" flag), the path is added to
+	 * that job instead.
+	 *
+	 * @param id the id of the new job
+	 * @return the id of the job which will update the path, or 0
+	 * if the queue is full
+	 */
 	gcc_nonnull_all
-	bool Push(SimpleDatabase &db, Storage &storage,
-		  std::string_view path, bool discard, unsigned id) noexcept;
+	unsigned Push(SimpleDatabase &db, Storage &storage,
+		      std::string_view path, bool discard,
+		      unsigned id, bool merge=false) noexcept;
 
 	UpdateQueueItem Pop() noexcept;
 
@@ -123,6 +123,14 @@ UpdateService::Task() noexcept
 	modified = walk->Walk(next.db->GetRoot(), next.path_utf8.c_str(),
 			      next.discard);
 
+	for (const auto &path : next.more_paths) {
+		FormatDebug(update_domain, "updating: %s", path.c_str());
+
+		if (walk->Walk(next.db->GetRoot(), path.c_str(),
+			       next.discard))
+			modified = true;
+	}
+
 	if (modified || !next.db->FileExists()) {
 		try {
 			next.db->Save();
@@ -169,7 +177,7 @@ UpdateService::GenerateId() noexcept
 }
 
 unsigned
-UpdateService::Enqueue(std::string_view path, bool discard)
+UpdateService::Enqueue(std::string_view path, bool discard, bool merge)
 {
 	assert(GetEventLoop().IsInside());
 
@@ -213,12 +221,15 @@ UpdateService::Enqueue(std::string_view path, bool discard)
 
 	if (walk != nullptr) {
 		const unsigned id = GenerateId();
-		if (!queue.Push(*db2, *storage2, path, discard, id))
+		const unsigned queued_id = queue.Push(*db2, *storage2, path,
+						      discard, id, merge);
+		if (queued_id == 0)
 			throw ProtocolError(ACK_ERROR_UPDATE_ALREADY,
 					    "Update queue is full");
 
-		update_task_id = id;
-		return id;
+		if (queued_id == id)
+			update_task_id = id;
+		return queued_id;
 	}
 
 	const unsigned id = update_task_id = GenerateId();
@@ -88,10 +88,14 @@ public:
 	 *
 	 * @param path a path to update; if an empty string,
 	 * the whole music directory is updated
+	 * @param merge may the path be merged into another queued
+	 * mergeable job?  This is used by the inotify/fanotify
+	 * watcher
 	 * @return the job id
 	 */
 	gcc_nonnull_all
-	unsigned Enqueue(std::string_view path, bool discard);
+	unsigned Enqueue(std::string_view path, bool discard,
+			 bool merge=false);
 
 	/**
 	 * Clear the queue and cancel the current update.  Does not
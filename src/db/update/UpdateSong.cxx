@@ -81,7 +81,20 @@ try {
 	} else if (info.mtime != song->mtime || walk_discard) {
 		FormatNotice(update_domain, "updating %s/%s",
 			     directory.GetPath(), name);
-		if (!song->UpdateFile(storage)) {
+
+		{
+			const ScopeDatabaseLock protect;
+			directory.BeginSongTagUpdate(*song);
+		}
+
+		const bool recognized = song->UpdateFile(storage);
+
+		{
+			const ScopeDatabaseLock protect;
+			directory.EndSongTagUpdate(*song);
+		}
+
+		if (!recognized) {
 			FormatDebug(update_domain,
 				    "deleting unrecognized file %s/%s",
 				    directory.GetPath(), name);
@@ -230,6 +230,24 @@ try {
 	LogError(std::current_exception());
 }
 
+/**
+ * Load the ".mpdignore" file of the given directory into the
+ * #ExcludeList.  Errors are logged.
+ */
+static void
+LoadExcludeListOrLog(Storage &storage, const Directory &directory,
+		     ExcludeList &exclude_list) noexcept
+try {
+	Mutex mutex;
+	auto is = InputStream::OpenReady(storage.MapUTF8(PathTraitsUTF8::Build(directory.GetPath(),
+									       ".mpdignore")).c_str(),
+					 mutex);
+	exclude_list.Load(std::move(is));
+} catch (...) {
+	if (!IsFileNotFound(std::current_exception()))
+		LogError(std::current_exception());
+}
+
 /* we don't look at files with newlines in their name */
 gcc_pure
 static bool
@@ -331,17 +349,7 @@ UpdateWalk::UpdateDirectory(Directory &directory,
 	}
 
 	ExcludeList child_exclude_list(exclude_list);
-
-	try {
-		Mutex mutex;
-		auto is = InputStream::OpenReady(storage.MapUTF8(PathTraitsUTF8::Build(directory.GetPath(),
-										       ".mpdignore")).c_str(),
-						 mutex);
-		child_exclude_list.Load(std::move(is));
-	} catch (...) {
-		if (!IsFileNotFound(std::current_exception()))
-			LogError(std::current_exception());
-	}
+	LoadExcludeListOrLog(storage, directory, child_exclude_list);
 
 	if (!child_exclude_list.IsEmpty())
 		RemoveExcludedFromDirectory(directory, child_exclude_list);
@@ -456,6 +464,21 @@ try {
 
 	const char *name = PathTraitsUTF8::GetBase(uri);
 
+	/* only the parent's ".mpdignore" is consulted here; this
+	   catches files which were created in an excluded location
+	   and are now reported individually by the auto_update
+	   watcher */
+	ExcludeList exclude_list;
+	LoadExcludeListOrLog(storage, *parent, exclude_list);
+
+	{
+		const auto name_fs = AllocatedPath::FromUTF8(name);
+		if (name_fs.IsNull() || exclude_list.Check(name_fs)) {
+			modified |= editor.DeleteNameIn(*parent, name);
+			return;
+		}
+	}
+
 	if (SkipSymlink(parent, name)) {
 		modified |= editor.DeleteNameIn(*parent, name);
 		return;
@@ -467,8 +490,6 @@ try {
 		return;
 	}
 
-	ExcludeList exclude_list;
-
 	UpdateDirectoryChild(*parent, exclude_list, name, info);
 } catch (...) {
 	LogError(std::current_exception());
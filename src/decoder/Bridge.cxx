@@ -39,6 +39,7 @@
 #include <cassert>
 #include <cmath>
 #include <stdexcept>
+#include <utility>
 
 #include <string.h>
 
@@ -55,6 +56,8 @@ DecoderBridge::~DecoderBridge() noexcept
 {
 	/* caller must flush the chunk */
 	assert(current_chunk == nullptr);
+	assert(spare_chunks == nullptr);
+	assert(queued_chunks == nullptr);
 }
 
 InputStreamPtr
@@ -124,7 +127,13 @@ DecoderBridge::GetChunk() noexcept
 		return current_chunk.get();
 
 	do {
-		current_chunk = dc.buffer->Allocate();
+		if (spare_chunks != nullptr) {
+			/* use a chunk reserved by ReserveChunks() */
+			current_chunk = std::move(spare_chunks);
+			spare_chunks = std::move(current_chunk->next);
+		} else
+			current_chunk = dc.buffer->Allocate();
+
 		if (current_chunk != nullptr) {
 			current_chunk->replay_gain_serial = replay_gain_serial;
 			if (replay_gain_serial != 0)
@@ -133,6 +142,10 @@ DecoderBridge::GetChunk() noexcept
 			return current_chunk.get();
 		}
 
+		/* the buffer is full; before waiting, give the player
+		   everything we have so it can free some chunks */
+		PushQueuedChunks();
+
 		cmd = LockNeedChunks(dc);
 	} while (cmd == DecoderCommand::NONE);
 
@@ -141,6 +154,33 @@ DecoderBridge::GetChunk() noexcept
 
 void
 DecoderBridge::FlushChunk() noexcept
+{
+	QueueChunk();
+	PushQueuedChunks();
+}
+
+void
+DecoderBridge::ReserveChunks(size_t nbytes) noexcept
+{
+	assert(spare_chunks == nullptr);
+
+	const size_t frame_size = dc.out_audio_format.GetFrameSize();
+	const size_t chunk_size =
+		sizeof(MusicChunk::data) / frame_size * frame_size;
+
+	if (current_chunk != nullptr) {
+		const size_t available = chunk_size - current_chunk->length;
+		if (nbytes < available)
+			return;
+
+		nbytes -= available;
+	}
+
+	spare_chunks = dc.buffer->AllocateList(nbytes / chunk_size + 1);
+}
+
+void
+DecoderBridge::QueueChunk() noexcept
 {
 	assert(!seeking);
 	assert(!initial_seek_running);
@@ -148,8 +188,27 @@ DecoderBridge::FlushChunk() noexcept
 	assert(current_chunk != nullptr);
 
 	auto chunk = std::move(current_chunk);
-	if (!chunk->IsEmpty())
-		dc.pipe->Push(std::move(chunk));
+	if (chunk->IsEmpty())
+		return;
+
+	MusicChunk &last = *chunk;
+	if (queued_chunks == nullptr)
+		queued_chunks = std::move(chunk);
+	else
+		queued_tail->next = std::move(chunk);
+
+	queued_tail = &last;
+	++n_queued_chunks;
+}
+
+void
+DecoderBridge::PushQueuedChunks() noexcept
+{
+	if (queued_chunks == nullptr)
+		return;
+
+	dc.pipe->Push(std::move(queued_chunks), *queued_tail,
+		      std::exchange(n_queued_chunks, 0));
 
 	const std::lock_guard<Mutex> protect(dc.mutex);
 	dc.client_cond.notify_one();
@@ -524,6 +583,10 @@ DecoderBridge::SubmitData(InputStream *is,
 		assert(dc.in_audio_format == dc.out_audio_format);
 	}
 
+	/* reserve all chunks for this block at once, and push them
+	   to the pipe in one batch after the loop */
+	ReserveChunks(length);
+
 	while (length > 0) {
 		bool full;
 
@@ -539,8 +602,8 @@ DecoderBridge::SubmitData(InputStream *is,
 				     dc.song->GetStartTime(),
 				     kbit_rate);
 		if (dest.empty()) {
-			/* the chunk is full, flush it */
-			FlushChunk();
+			/* the chunk is full, queue it */
+			QueueChunk();
 			continue;
 		}
 
@@ -554,8 +617,8 @@ DecoderBridge::SubmitData(InputStream *is,
 
 		full = chunk->Expand(dc.out_audio_format, nbytes);
 		if (full) {
-			/* the chunk is full, flush it */
-			FlushChunk();
+			/* the chunk is full, queue it */
+			QueueChunk();
 		}
 
 		data = (const uint8_t *)data + nbytes;
@@ -564,6 +627,9 @@ DecoderBridge::SubmitData(InputStream *is,
 		timestamp += dc.out_audio_format.SizeToTime<FloatDuration>(nbytes);
 	}
 
+	spare_chunks.reset();
+	PushQueuedChunks();
+
 	absolute_frame += data_frames;
 
 	return cmd;
@@ -101,6 +101,28 @@ private:
 	/** the chunk currently being written to */
 	MusicChunkPtr current_chunk;
 
+	/**
+	 * Empty chunks which were reserved by SubmitData() for the
+	 * rest of the current block, linked with #MusicChunk::next.
+	 * They are returned to the #MusicBuffer before SubmitData()
+	 * returns.
+	 */
+	MusicChunkPtr spare_chunks;
+
+	/**
+	 * Full chunks which have not yet been pushed to the
+	 * #MusicPipe, linked with #MusicChunk::next.  They are pushed
+	 * all at once by PushQueuedChunks(), to avoid locking the
+	 * pipe and waking up the player thread for each chunk.
+	 */
+	MusicChunkPtr queued_chunks;
+
+	/** the last chunk in #queued_chunks */
+	MusicChunk *queued_tail;
+
+	/** the number of chunks in #queued_chunks */
+	unsigned n_queued_chunks = 0;
+
 	ReplayGainInfo replay_gain_info;
 
 	/**
@@ -144,7 +166,8 @@ public:
 	MusicChunk *GetChunk() noexcept;
 
 	/**
-	 * Flushes the current chunk.
+	 * Flushes the current chunk (and all queued chunks) to the
+	 * #MusicPipe.
 	 *
 	 * Caller must not lock the #DecoderControl object.
 	 */
@@ -165,6 +188,28 @@ public:
 	 */
 	InputStreamPtr OpenLocal(Path path_fs, const char *uri_utf8);
 
+private:
+	/**
+	 * Reserve enough chunks for writing the specified number of
+	 * bytes into #spare_chunks.
+	 */
+	void ReserveChunks(size_t nbytes) noexcept;
+
+	/**
+	 * Move the current chunk to #queued_chunks.  Empty chunks are
+	 * returned to the #MusicBuffer.
+	 */
+	void QueueChunk() noexcept;
+
+	/**
+	 * Push all chunks from #queued_chunks to the #MusicPipe and
+	 * wake up the player thread.
+	 *
+	 * Caller must not lock the #DecoderControl object.
+	 */
+	void PushQueuedChunks() noexcept;
+
+public:
 	/* virtual methods from DecoderClient */
 	void Ready(AudioFormat audio_format,
 		   bool seekable, SignedSongTime duration) noexcept override;
@@ -122,6 +122,11 @@ public:
 	 * This function is called by the decoder plugin when it has
 	 * successfully decoded block of input data.
 	 *
+	 * The block may be arbitrarily large.  It is converted in one
+	 * pass, and the resulting chunks are pushed to the player in
+	 * one batch, so submitting fewer large blocks is cheaper than
+	 * submitting many small ones.
+	 *
 	 * @param is an input stream which is buffering while we are waiting
 	 * for the player
 	 * @param data the source buffer
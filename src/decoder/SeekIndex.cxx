@@ -0,0 +1,76 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SeekIndex.hxx"
+
+#include <algorithm>
+
+static constexpr bool
+ComparePosition(const SeekIndex::Point &a, uint64_t b) noexcept
+{
+	return a.position < b;
+}
+
+bool
+SeekIndex::Add(uint64_t position, offset_type offset,
+	       uint64_t min_distance) noexcept
+{
+	const auto i = std::lower_bound(points.begin(), points.end(),
+					position, ComparePosition);
+
+	if (i != points.end() &&
+	    (i->position - position < min_distance || i->offset <= offset))
+		return false;
+
+	if (i != points.begin()) {
+		const auto &prev = *std::prev(i);
+		if (position - prev.position < min_distance ||
+		    prev.offset >= offset)
+			return false;
+	}
+
+	points.insert(i, Point{position, offset});
+	return true;
+}
+
+const SeekIndex::Point *
+SeekIndex::FindBefore(uint64_t position) const noexcept
+{
+	auto i = std::upper_bound(points.begin(), points.end(), position,
+				  [](uint64_t a, const Point &b){
+					  return a < b.position;
+				  });
+	if (i == points.begin())
+		return nullptr;
+
+	return &*std::prev(i);
+}
+
+const SeekIndex::Point *
+SeekIndex::FindAfter(uint64_t position) const noexcept
+{
+	auto i = std::upper_bound(points.begin(), points.end(), position,
+				  [](uint64_t a, const Point &b){
+					  return a < b.position;
+				  });
+	if (i == points.end())
+		return nullptr;
+
+	return &*i;
+}
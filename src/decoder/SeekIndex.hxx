@@ -0,0 +1,116 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DECODER_SEEK_INDEX_HXX
+#define MPD_DECODER_SEEK_INDEX_HXX
+
+#include "input/Offset.hxx"
+#include "util/Compiler.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A sparse table which maps a stream position to the byte offset
+ * where a decoder may resume decoding.  The meaning of "position" is
+ * up to the decoder plugin (e.g. an MP3 frame number or an Ogg
+ * granulepos); the only requirement is that it grows monotonically
+ * with the byte offset.
+ *
+ * The table is filled while a song is being decoded, and it allows
+ * later seeks to jump close to the destination instead of scanning
+ * or bisecting the file.  See seek_index_cache_lookup().
+ */
+class SeekIndex {
+public:
+	struct Point {
+		uint64_t position;
+		offset_type offset;
+	};
+
+private:
+	/**
+	 * Sorted by #Point::position (and thus by #Point::offset).
+	 */
+	std::vector<Point> points;
+
+	/**
+	 * The position at the end of the stream; 0 if unknown.
+	 */
+	uint64_t end_position = 0;
+
+public:
+	bool empty() const noexcept {
+		return points.empty();
+	}
+
+	std::size_t size() const noexcept {
+		return points.size();
+	}
+
+	const std::vector<Point> &GetPoints() const noexcept {
+		return points;
+	}
+
+	void Clear() noexcept {
+		points.clear();
+		end_position = 0;
+	}
+
+	/**
+	 * Insert a new point, unless there is already one closer than
+	 * the given distance.  Points which contradict the existing
+	 * ones (i.e. the offset does not grow with the position) are
+	 * ignored.
+	 *
+	 * @return true if the point was inserted
+	 */
+	bool Add(uint64_t position, offset_type offset,
+		 uint64_t min_distance) noexcept;
+
+	/**
+	 * Find the last point at or before the given position.
+	 *
+	 * @return the point or nullptr if there is none
+	 */
+	gcc_pure
+	const Point *FindBefore(uint64_t position) const noexcept;
+
+	/**
+	 * Find the first point after the given position.
+	 *
+	 * @return the point or nullptr if there is none
+	 */
+	gcc_pure
+	const Point *FindAfter(uint64_t position) const noexcept;
+
+	bool HasEndPosition() const noexcept {
+		return end_position > 0;
+	}
+
+	uint64_t GetEndPosition() const noexcept {
+		return end_position;
+	}
+
+	void SetEndPosition(uint64_t _end_position) noexcept {
+		end_position = _end_position;
+	}
+};
+
+#endif
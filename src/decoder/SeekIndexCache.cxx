@@ -0,0 +1,226 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SeekIndexCache.hxx"
+#include "input/InputStream.hxx"
+#include "config/Data.hxx"
+#include "config/Option.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "fs/FileSystem.hxx"
+#include "fs/io/TextFile.hxx"
+#include "fs/io/FileOutputStream.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "thread/Mutex.hxx"
+#include "util/Domain.hxx"
+#include "util/NumberParser.hxx"
+#include "util/RuntimeError.hxx"
+#include "util/StringAPI.hxx"
+#include "util/StringCompare.hxx"
+#include "util/LruCache.hxx"
+#include "Log.hxx"
+
+#include <cassert>
+#include <cinttypes>
+#include <string>
+
+#define SEEK_INDEX_BEGIN "seek_index_begin: "
+#define SEEK_INDEX_END "seek_index_end"
+
+static constexpr Domain seek_index_domain("seek_index");
+
+namespace {
+
+struct SeekIndexCache {
+	struct Item {
+		std::string plugin;
+		offset_type size;
+		SeekIndex index;
+	};
+
+	const AllocatedPath path;
+
+	Mutex mutex;
+
+	/**
+	 * Maps the URI to the #Item.  If the cache is full, the least
+	 * recently used item is evicted.
+	 */
+	LruCache<Item, 1024> items;
+
+	/**
+	 * Was the cache modified since it was loaded?
+	 */
+	bool modified = false;
+
+	explicit SeekIndexCache(AllocatedPath &&_path) noexcept
+		:path(std::move(_path)) {}
+
+	void Load(TextFile &file);
+	void Save(BufferedOutputStream &os) const;
+};
+
+}
+
+static SeekIndexCache *seek_index_cache;
+
+static SeekIndexCache::Item
+LoadItem(TextFile &file)
+{
+	SeekIndexCache::Item item{{}, 0, {}};
+
+	char *line;
+	while ((line = file.ReadLine()) != nullptr &&
+	       !StringIsEqual(line, SEEK_INDEX_END)) {
+		const char *value;
+		char *endptr;
+
+		if ((value = StringAfterPrefix(line, "plugin: ")) != nullptr) {
+			item.plugin = value;
+		} else if ((value = StringAfterPrefix(line, "size: ")) != nullptr) {
+			item.size = ParseUint64(value);
+		} else if ((value = StringAfterPrefix(line, "end: ")) != nullptr) {
+			item.index.SetEndPosition(ParseUint64(value));
+		} else {
+			const uint64_t position = ParseUint64(line, &endptr);
+			if (endptr == line || *endptr != ' ')
+				throw FormatRuntimeError("Malformed line in seek index file: %s",
+							 line);
+
+			const offset_type offset = ParseUint64(endptr + 1);
+			item.index.Add(position, offset, 0);
+		}
+	}
+
+	return item;
+}
+
+void
+SeekIndexCache::Load(TextFile &file)
+{
+	const char *line;
+	while ((line = file.ReadLine()) != nullptr) {
+		const char *uri = StringAfterPrefix(line, SEEK_INDEX_BEGIN);
+		if (uri == nullptr)
+			throw FormatRuntimeError("Malformed line in seek index file: %s",
+						 line);
+
+		auto item = LoadItem(file);
+		if (!item.plugin.empty() && !item.index.empty())
+			items.Store(uri, std::move(item));
+	}
+}
+
+void
+SeekIndexCache::Save(BufferedOutputStream &os) const
+{
+	/* oldest first, so Load() restores the LRU order */
+	items.ForEach([&os](const std::string &uri, const Item &item){
+		os.Format(SEEK_INDEX_BEGIN "%s\n", uri.c_str());
+		os.Format("plugin: %s\n", item.plugin.c_str());
+		os.Format("size: %" PRIoffset "\n", item.size);
+		if (item.index.HasEndPosition())
+			os.Format("end: %" PRIu64 "\n",
+				  item.index.GetEndPosition());
+
+		for (const auto &p : item.index.GetPoints())
+			os.Format("%" PRIu64 " %" PRIoffset "\n",
+				  p.position, p.offset);
+
+		os.Write(SEEK_INDEX_END "\n");
+	});
+}
+
+void
+seek_index_cache_init(const ConfigData &config)
+{
+	assert(seek_index_cache == nullptr);
+
+	seek_index_cache =
+		new SeekIndexCache(config.GetPath(ConfigOption::SEEK_INDEX_FILE));
+
+	const auto &path = seek_index_cache->path;
+	if (path.IsNull() || !FileExists(path))
+		return;
+
+	try {
+		TextFile file(path);
+		seek_index_cache->Load(file);
+	} catch (...) {
+		LogError(std::current_exception());
+	}
+
+	FormatDebug(seek_index_domain, "Loaded %zu seek indexes",
+		    seek_index_cache->items.size());
+}
+
+void
+seek_index_cache_deinit() noexcept
+{
+	assert(seek_index_cache != nullptr);
+
+	const auto &path = seek_index_cache->path;
+	if (!path.IsNull() && seek_index_cache->modified) {
+		try {
+			FileOutputStream fos(path);
+			BufferedOutputStream bos(fos);
+			seek_index_cache->Save(bos);
+			bos.Flush();
+			fos.Commit();
+		} catch (...) {
+			LogError(std::current_exception());
+		}
+	}
+
+	delete seek_index_cache;
+	seek_index_cache = nullptr;
+}
+
+SeekIndex
+seek_index_cache_lookup(const char *plugin, InputStream &is) noexcept
+{
+	if (seek_index_cache == nullptr ||
+	    !is.IsSeekable() || !is.KnownSize())
+		return {};
+
+	const std::lock_guard<Mutex> protect(seek_index_cache->mutex);
+
+	const auto *item = seek_index_cache->items.Lookup(is.GetURI());
+	if (item == nullptr || item->plugin != plugin ||
+	    item->size != is.GetSize())
+		return {};
+
+	return item->index;
+}
+
+void
+seek_index_cache_store(const char *plugin, InputStream &is,
+		       SeekIndex &&index) noexcept
+try {
+	if (seek_index_cache == nullptr || index.empty() ||
+	    !is.IsSeekable() || !is.KnownSize())
+		return;
+
+	const std::lock_guard<Mutex> protect(seek_index_cache->mutex);
+	seek_index_cache->items.Store(is.GetURI(),
+				      SeekIndexCache::Item{plugin, is.GetSize(),
+							   std::move(index)});
+	seek_index_cache->modified = true;
+} catch (...) {
+	/* out of memory - ignore, this is just a cache */
+}
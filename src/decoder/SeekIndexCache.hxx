@@ -0,0 +1,82 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*! \file
+ * \brief A process-wide cache of #SeekIndex objects
+ *
+ * Decoder plugins look up the #SeekIndex of a song before they start
+ * decoding, extend it while decoding and store it back when they are
+ * done.  The cache is bounded and optionally persisted in the file
+ * specified by the "seek_index_file" setting.
+ */
+
+#ifndef MPD_DECODER_SEEK_INDEX_CACHE_HXX
+#define MPD_DECODER_SEEK_INDEX_CACHE_HXX
+
+#include "SeekIndex.hxx"
+
+struct ConfigData;
+class InputStream;
+
+/**
+ * Load the cache from the configured file.  Errors are logged.
+ */
+void
+seek_index_cache_init(const ConfigData &config);
+
+/**
+ * Save the cache to the configured file (if it was modified) and
+ * free all memory.
+ */
+void
+seek_index_cache_deinit() noexcept;
+
+class ScopeSeekIndexCacheInit {
+public:
+	explicit ScopeSeekIndexCacheInit(const ConfigData &config) {
+		seek_index_cache_init(config);
+	}
+
+	~ScopeSeekIndexCacheInit() noexcept {
+		seek_index_cache_deinit();
+	}
+};
+
+/**
+ * Look up the #SeekIndex which was previously stored for the song
+ * being read from the given #InputStream.
+ *
+ * @param plugin the name of the decoder plugin; indexes stored by
+ * other plugins are ignored, because their positions are not
+ * compatible
+ * @return the #SeekIndex, or an empty one if none was found or if
+ * the stream is not seekable
+ */
+SeekIndex
+seek_index_cache_lookup(const char *plugin, InputStream &is) noexcept;
+
+/**
+ * Store (or replace) the #SeekIndex of the song being read from the
+ * given #InputStream.  Empty indexes are ignored.
+ */
+void
+seek_index_cache_store(const char *plugin, InputStream &is,
+		       SeekIndex &&index) noexcept;
+
+#endif
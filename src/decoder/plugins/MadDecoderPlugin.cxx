@@ -20,6 +20,7 @@
 #include "config.h"
 #include "MadDecoderPlugin.hxx"
 #include "../DecoderAPI.hxx"
+#include "../SeekIndexCache.hxx"
 #include "input/InputStream.hxx"
 #include "tag/Id3Scan.hxx"
 #include "tag/Id3ReplayGain.hxx"
@@ -47,6 +48,12 @@
 
 static constexpr unsigned long FRAMES_CUSHION = 2000;
 
+/**
+ * Record a #SeekIndex point every this number of frames (about 1.5
+ * seconds with 44.1 kHz layer III).
+ */
+static constexpr uint64_t SEEK_INDEX_INTERVAL = 64;
+
 enum class MadDecoderAction {
 	SKIP,
 	BREAK,
@@ -115,6 +122,20 @@ class MadDecoder {
 	size_t highest_frame = 0;
 	size_t max_frames = 0;
 	size_t current_frame = 0;
+
+	/**
+	 * Frame offsets which were recorded while decoding this song
+	 * earlier.  Unlike #frame_offsets, this table may have holes,
+	 * and it allows seeking beyond #highest_frame.
+	 */
+	SeekIndex seek_index;
+
+	/**
+	 * Was #seek_index modified since it was loaded from the
+	 * cache?
+	 */
+	bool seek_index_modified = false;
+
 	unsigned int drop_start_frames;
 	unsigned int drop_end_frames;
 	unsigned int drop_start_samples = 0;
@@ -172,6 +193,16 @@ private:
 	[[nodiscard]] gcc_pure
 	size_t TimeToFrame(SongTime t) const noexcept;
 
+	/**
+	 * Attempt to seek to the given time using the #seek_index.
+	 * On success, #mute_frame is set up to skip the remaining
+	 * frames up to the given time.
+	 *
+	 * @return true on success, false if the #seek_index does not
+	 * help
+	 */
+	bool SeekIndexed(SongTime t) noexcept;
+
 	/**
 	 * Record the current frame's offset in the "frame_offsets"
 	 * buffer and go forward to the next frame, updating the
@@ -796,7 +827,17 @@ MadDecoder::TimeToFrame(SongTime t) const noexcept
 void
 MadDecoder::UpdateTimerNextFrame() noexcept
 {
-	if (current_frame >= highest_frame) {
+	if (current_frame % SEEK_INDEX_INTERVAL == 0 &&
+	    seek_index.Add(current_frame, ThisFrameOffset(),
+			   SEEK_INDEX_INTERVAL))
+		seek_index_modified = true;
+
+	if (current_frame > highest_frame) {
+		/* after SeekIndexed(), we're beyond the contiguous
+		   part of the "frame_offsets" table; just advance
+		   the timer */
+		mad_timer_add(&timer, frame.header.duration);
+	} else if (current_frame == highest_frame) {
 		/* record this frame's properties in frame_offsets
 		   (for seeking) and times */
 
@@ -818,6 +859,51 @@ MadDecoder::UpdateTimerNextFrame() noexcept
 	elapsed_time = ToSongTime(timer);
 }
 
+inline bool
+MadDecoder::SeekIndexed(SongTime t) noexcept
+{
+	/* all frames have the same number of samples, so the frame
+	   number can be calculated */
+	const uint64_t samples_per_frame = 32 * MAD_NSBSAMPLES(&frame.header);
+	const uint64_t target_frame = uint64_t(t.ToMS()) *
+		frame.header.samplerate / (samples_per_frame * 1000);
+
+	size_t new_frame;
+	offset_type offset;
+
+	const auto *point = seek_index.FindBefore(target_frame);
+	if (point != nullptr && point->position > highest_frame) {
+		if (point->position <= current_frame &&
+		    current_frame <= target_frame)
+			/* scanning from the current position is
+			   cheaper */
+			return false;
+
+		new_frame = point->position;
+		offset = point->offset;
+	} else if (current_frame > target_frame && highest_frame > 0) {
+		/* an earlier SeekIndexed() call took us beyond the
+		   destination; go back to the end of the contiguous
+		   "frame_offsets" table and scan from there */
+		new_frame = highest_frame - 1;
+		offset = frame_offsets[new_frame];
+	} else
+		return false;
+
+	if (!Seek(offset))
+		return false;
+
+	current_frame = new_frame;
+	timer = frame.header.duration;
+	mad_timer_multiply(&timer, new_frame);
+	elapsed_time = ToSongTime(timer);
+	was_eof = false;
+
+	seek_time = t;
+	mute_frame = MadDecoderMuteFrame::SEEK;
+	return true;
+}
+
 DecoderCommand
 MadDecoder::SubmitPCM(size_t i, size_t pcm_length) noexcept
 {
@@ -914,6 +1000,8 @@ MadDecoder::HandleCurrentFrame() noexcept
 					client->CommandFinished();
 				} else
 					client->SeekError();
+			} else if (SeekIndexed(t)) {
+				client->CommandFinished();
 			} else {
 				seek_time = t;
 				mute_frame = MadDecoderMuteFrame::SEEK;
@@ -974,6 +1062,8 @@ MadDecoder::RunDecoder() noexcept
 
 	AllocateBuffers();
 
+	seek_index = seek_index_cache_lookup("mad", input_stream);
+
 	client->Ready(CheckAudioFormat(frame.header.samplerate,
 				       SampleFormat::S24_P32,
 				       MAD_NCHANNELS(&frame.header)),
@@ -984,6 +1074,10 @@ MadDecoder::RunDecoder() noexcept
 		client->SubmitTag(input_stream, std::move(tag));
 
 	while (Read()) {}
+
+	if (seek_index_modified)
+		seek_index_cache_store("mad", input_stream,
+				       std::move(seek_index));
 }
 
 static void
@@ -19,8 +19,30 @@
 
 #include "OggDecoder.hxx"
 #include "lib/xiph/OggFind.hxx"
+#include "decoder/SeekIndexCache.hxx"
 #include "input/InputStream.hxx"
 
+/**
+ * Record a #SeekIndex point every this number of granules (about 1.5
+ * seconds at 44.1 kHz).
+ */
+static constexpr uint64_t SEEK_INDEX_INTERVAL = 65536;
+
+OggDecoder::OggDecoder(DecoderReader &reader)
+	:OggVisitor(reader),
+	 seek_index(seek_index_cache_lookup("ogg", reader.GetInputStream())),
+	 client(reader.GetClient()),
+	 input_stream(reader.GetInputStream())
+{
+}
+
+OggDecoder::~OggDecoder() noexcept
+{
+	if (seek_index_modified && !seek_index_disabled)
+		seek_index_cache_store("ogg", input_stream,
+				       std::move(seek_index));
+}
+
 /**
  * Load the end-of-stream packet and restore the previous file
  * position.
@@ -72,11 +94,28 @@ OggDecoder::LoadEndGranulePos() const
 	return packet.granulepos;
 }
 
+ogg_int64_t
+OggDecoder::UpdateEndGranulePos() noexcept
+{
+	end_granulepos = LoadEndGranulePos();
+	end_from_seek_index = false;
+	if (end_granulepos < 0 && seek_index.HasEndPosition()) {
+		/* the end was seen while this song was decoded
+		   earlier */
+		end_granulepos = seek_index.GetEndPosition();
+		end_from_seek_index = true;
+	}
+
+	return end_granulepos;
+}
+
 inline void
 OggDecoder::SeekByte(offset_type offset)
 {
 	input_stream.LockSeek(offset);
 	PostSeek(offset);
+
+	last_granulepos = -1;
 }
 
 void
@@ -94,6 +133,24 @@ OggDecoder::SeekGranulePos(ogg_int64_t where_granulepos)
 	offset_type min_offset = 0, max_offset = input_stream.GetSize();
 	ogg_int64_t min_granule = 0, max_granule = end_granulepos;
 
+	/* use the seek index to narrow down the range */
+
+	if (const auto *p = seek_index.FindBefore(where_granulepos)) {
+		if (ogg_int64_t(p->position) + MARGIN_BEFORE >= where_granulepos) {
+			/* close enough */
+			SeekByte(p->offset);
+			return;
+		}
+
+		min_offset = p->offset;
+		min_granule = p->position;
+	}
+
+	if (const auto *p = seek_index.FindAfter(where_granulepos)) {
+		max_offset = p->offset;
+		max_granule = p->position;
+	}
+
 	while (true) {
 		const offset_type delta_offset = max_offset - min_offset;
 		const ogg_int64_t delta_granule = max_granule - min_granule;
@@ -147,3 +204,30 @@ OggDecoder::SeekGranulePos(ogg_int64_t where_granulepos)
 	   already) */
 	SeekByte(GetStartOffset());
 }
+
+void
+OggDecoder::AddSeekIndexPoint(const ogg_packet &packet) noexcept
+{
+	if (packet.granulepos < 0 || seek_index_disabled)
+		return;
+
+	if (packet.granulepos < last_granulepos) {
+		/* the granulepos went backwards without seeking:
+		   this is a chained stream */
+		seek_index_disabled = true;
+		return;
+	}
+
+	last_granulepos = packet.granulepos;
+
+	if (seek_index.Add(packet.granulepos, GetStartOffset(),
+			   SEEK_INDEX_INTERVAL))
+		seek_index_modified = true;
+
+	if (packet.e_o_s && !seek_index.HasEndPosition() &&
+	    input_stream.LockIsEOF()) {
+		/* this is the last page of the file */
+		seek_index.SetEndPosition(packet.granulepos);
+		seek_index_modified = true;
+	}
+}
@@ -22,20 +22,48 @@
 
 #include "lib/xiph/OggVisitor.hxx"
 #include "decoder/Reader.hxx"
+#include "decoder/SeekIndex.hxx"
 #include "input/Offset.hxx"
 
 class OggDecoder : public OggVisitor {
 	ogg_int64_t end_granulepos;
 
+	/**
+	 * Page offsets recorded while decoding this song (now or
+	 * earlier), used to narrow down the search in
+	 * SeekGranulePos().  For remote files, it also provides the
+	 * #end_granulepos which LoadEndGranulePos() does not
+	 * determine.
+	 */
+	SeekIndex seek_index;
+
+	/**
+	 * The granulepos passed to the last AddSeekIndexPoint() call
+	 * since the last seek; -1 if none.  Used to detect chained
+	 * streams, which are not supported by the #seek_index.
+	 */
+	ogg_int64_t last_granulepos = -1;
+
+	bool seek_index_modified = false;
+
+	/**
+	 * Was #end_granulepos obtained from the #seek_index (and not
+	 * from the stream)?
+	 */
+	bool end_from_seek_index = false;
+
+	/**
+	 * Set if a chained stream was detected.
+	 */
+	bool seek_index_disabled = false;
+
 protected:
 	DecoderClient &client;
 	InputStream &input_stream;
 
 public:
-	explicit OggDecoder(DecoderReader &reader)
-		:OggVisitor(reader),
-		 client(reader.GetClient()),
-		 input_stream(reader.GetInputStream()) {}
+	explicit OggDecoder(DecoderReader &reader);
+	~OggDecoder() noexcept;
 
 private:
 	/**
@@ -46,14 +74,22 @@ private:
 	ogg_int64_t LoadEndGranulePos() const;
 
 protected:
-	ogg_int64_t UpdateEndGranulePos() {
-		return end_granulepos = LoadEndGranulePos();
-	}
+	ogg_int64_t UpdateEndGranulePos() noexcept;
 
 	bool IsSeekable() const {
 		return end_granulepos > 0;
 	}
 
+	/**
+	 * Like IsSeekable(), but ignores an end position which is
+	 * only known from the #seek_index.  Decoders which support
+	 * chained (unseekable) streams use this to decide whether the
+	 * end of the Ogg stream is the end of the song.
+	 */
+	bool IsSeekableWithoutIndex() const {
+		return IsSeekable() && !end_from_seek_index;
+	}
+
 	/**
 	 * Seek the #InputStream and update the #OggVisitor.
 	 *
@@ -62,6 +98,12 @@ protected:
 	void SeekByte(offset_type offset);
 
 	void SeekGranulePos(ogg_int64_t where_granulepos);
+
+	/**
+	 * Record the position of the current page in the seek index.
+	 * Call this for each audio packet.
+	 */
+	void AddSeekIndexPoint(const ogg_packet &packet) noexcept;
 };
 
 #endif
@@ -252,7 +252,7 @@ MPDOpusDecoder::OnOggBeginning(const ogg_packet &packet)
 void
 MPDOpusDecoder::OnOggEnd()
 {
-	if (!IsSeekable() && IsInitialized()) {
+	if (!IsSeekableWithoutIndex() && IsInitialized()) {
 		/* allow chaining of (unseekable) streams */
 		assert(opus_decoder != nullptr);
 		assert(output_buffer != nullptr);
@@ -299,6 +299,8 @@ MPDOpusDecoder::HandleAudio(const ogg_packet &packet)
 {
 	assert(opus_decoder != nullptr);
 
+	AddSeekIndexPoint(packet);
+
 	if (!submitted_replay_gain) {
 		/* if we didn't see an OpusTags packet with EBU R128
 		   values, we still need to apply the output gain
@@ -275,6 +275,8 @@ VorbisDecoder::OnOggPacket(const ogg_packet &_packet)
 		if (VorbisCommentToReplayGain(rgi, vc))
 			client.SubmitReplayGain(&rgi);
 	} else {
+		AddSeekIndexPoint(packet);
+
 		if (!dsp_initialized) {
 			dsp_initialized = true;
 
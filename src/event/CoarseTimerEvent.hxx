@@ -53,7 +53,7 @@ class EventLoop;
  */
 class CoarseTimerEvent final : AutoUnlinkIntrusiveListHook
 {
-	friend class TimerWheel;
+	template<typename, unsigned> friend class HierarchicalTimerWheel;
 	friend class IntrusiveList<CoarseTimerEvent>;
 
 	EventLoop &loop;
@@ -34,8 +34,7 @@
 
 #include "Chrono.hxx"
 #include "util/BindMethod.hxx"
-
-#include <boost/intrusive/set_hook.hpp>
+#include "util/IntrusiveList.hxx"
 
 class EventLoop;
 
@@ -43,17 +42,17 @@ class EventLoop;
  * This class invokes a callback function after a certain amount of
  * time.  Use Schedule() to start the timer or Cancel() to cancel it.
  *
- * Unlike #CoarseTimerEvent, this class uses a high-resolution timer,
- * but at the cost of more expensive insertion and deletion.
+ * Unlike #CoarseTimerEvent, this class has a granularity of 1
+ * millisecond.
  *
  * This class is not thread-safe, all methods must be called from the
  * thread that runs the #EventLoop, except where explicitly documented
  * as thread-safe.
  */
-class FineTimerEvent final
-	: public boost::intrusive::set_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>>
+class FineTimerEvent final : AutoUnlinkIntrusiveListHook
 {
-	friend class TimerList;
+	template<typename, unsigned> friend class HierarchicalTimerWheel;
+	friend class IntrusiveList<FineTimerEvent>;
 
 	EventLoop &loop;
 
@@ -91,7 +90,8 @@ public:
 	void ScheduleEarlier(Event::Duration d) noexcept;
 
 	void Cancel() noexcept {
-		unlink();
+		if (IsPending())
+			unlink();
 	}
 
 private:
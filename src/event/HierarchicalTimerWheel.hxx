@@ -0,0 +1,304 @@
+/*
+ * Copyright 2007-2021 CM4all GmbH
+ * All rights reserved.
+ *
+ * author: Max Kellermann <mk@cm4all.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the
+ * distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Chrono.hxx"
+#include "util/IntrusiveList.hxx"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+/**
+ * A hierarchical timer wheel: a number of levels with 64 slots each;
+ * each slot of a level spans 64 slots of the level below.  Timers
+ * are inserted into the lowest level which can hold them, and are
+ * moved ("cascaded") to lower levels as time passes.  Insertion and
+ * cancellation are O(1); a timer is cascaded at most once per level.
+ *
+ * Each level has a bit mask of (possibly) non-empty slots, so empty
+ * slots are skipped quickly, both when running timers and when
+ * calculating the next wakeup time.  Cancelled timers just unlink
+ * themselves; the bit is cleared lazily.
+ *
+ * Timers are never invoked early, but up to #RESOLUTION_MS late.
+ *
+ * @param T the timer class; it must derive from
+ * #AutoUnlinkIntrusiveListHook and have the methods GetDue() and
+ * Run()
+ * @param RESOLUTION_MS the duration of one slot of the lowest level
+ * in milliseconds
+ */
+template<typename T, unsigned RESOLUTION_MS>
+class HierarchicalTimerWheel final {
+	static constexpr Event::Duration RESOLUTION =
+		std::chrono::milliseconds(RESOLUTION_MS);
+
+	static constexpr unsigned SLOT_BITS = 6;
+	static constexpr std::size_t N_SLOTS = std::size_t(1) << SLOT_BITS;
+	static constexpr uint_least64_t SLOT_MASK = N_SLOTS - 1;
+
+	/**
+	 * With 6 levels, the wheel spans 2^36 ticks (about 2 years
+	 * with a resolution of 1 ms).  Timers beyond that are parked
+	 * in the highest level and cascaded again.
+	 */
+	static constexpr unsigned N_LEVELS = 6;
+
+	static constexpr uint_least64_t MAX_DELTA =
+		(uint_least64_t(1) << (SLOT_BITS * N_LEVELS)) - 1;
+
+	using List = IntrusiveList<T>;
+
+	struct Level {
+		std::array<List, N_SLOTS> slots;
+
+		/**
+		 * Bit i is set if slot i may be non-empty.
+		 */
+		uint_least64_t occupied = 0;
+
+		void Add(std::size_t i, T &t) noexcept {
+			slots[i].push_back(t);
+			occupied |= uint_least64_t(1) << i;
+		}
+
+		/**
+		 * Find the first non-empty slot, starting at the given
+		 * index and wrapping around.
+		 *
+		 * @return the distance from #start or N_SLOTS if all
+		 * slots are empty
+		 */
+		std::size_t FindNext(std::size_t start) noexcept {
+			while (occupied != 0) {
+				const auto rotated = start == 0
+					? occupied
+					: (occupied >> start) |
+					(occupied << (N_SLOTS - start));
+				const std::size_t distance =
+					__builtin_ctzll(rotated);
+				const std::size_t i = (start + distance) & SLOT_MASK;
+				if (!slots[i].empty())
+					return distance;
+
+				/* all timers in this slot have been
+				   cancelled */
+				occupied &= ~(uint_least64_t(1) << i);
+			}
+
+			return N_SLOTS;
+		}
+
+		/**
+		 * Remove all timers from the given slot and pass them
+		 * to the given function.
+		 */
+		template<typename F>
+		void Flush(std::size_t i, F &&f) noexcept {
+			occupied &= ~(uint_least64_t(1) << i);
+
+			/* move all timers to a temporary list to avoid
+			   problems with timers being cancelled or
+			   scheduled by the callback */
+			auto tmp = std::move(slots[i]);
+			tmp.clear_and_dispose(f);
+		}
+	};
+
+	std::array<Level, N_LEVELS> levels;
+
+	/**
+	 * Timers which were already due when they were inserted.
+	 * They will be invoked by the next Run() call.
+	 */
+	List ready;
+
+	/**
+	 * The next tick to be processed by Run().
+	 */
+	uint_least64_t base = 0;
+
+	/**
+	 * The last time Run() was invoked.
+	 */
+	Event::TimePoint last_time{};
+
+public:
+	HierarchicalTimerWheel() noexcept = default;
+
+	HierarchicalTimerWheel(const HierarchicalTimerWheel &) = delete;
+	HierarchicalTimerWheel &operator=(const HierarchicalTimerWheel &) = delete;
+
+	void Insert(T &t) noexcept {
+		if (t.GetDue() <= last_time) {
+			/* already due: don't put it into a slot which
+			   Run() has already passed */
+			ready.push_back(t);
+			return;
+		}
+
+		Insert(t, CeilTick(t.GetDue()));
+	}
+
+	/**
+	 * Invoke all expired timers and return the duration until
+	 * the next timer expires.  Returns a negative duration if
+	 * there is no timeout.
+	 */
+	Event::Duration Run(Event::TimePoint now) noexcept {
+		last_time = now;
+
+		{
+			/* timers scheduled by these callbacks will be
+			   invoked by the next Run() call */
+			auto tmp = std::move(ready);
+			tmp.clear_and_dispose([](T *t){
+				t->Run();
+			});
+		}
+
+		const auto now_tick = FloorTick(now);
+
+		while (true) {
+			const auto next = GetNextTick();
+			if (next > now_tick)
+				break;
+
+			base = next;
+			RunTick();
+			++base;
+		}
+
+		assert(base <= now_tick + 1);
+		base = now_tick + 1;
+
+		if (!ready.empty())
+			/* a timer callback has scheduled a timer which
+			   is already due */
+			return Event::Duration::zero();
+
+		const auto next = GetNextTick();
+		if (next == UINT_LEAST64_MAX)
+			return Event::Duration(-1);
+
+		return TickToTime(next) - now;
+	}
+
+private:
+	static constexpr uint_least64_t FloorTick(Event::TimePoint t) noexcept {
+		return t.time_since_epoch() / RESOLUTION;
+	}
+
+	static constexpr uint_least64_t CeilTick(Event::TimePoint t) noexcept {
+		return (t.time_since_epoch() + RESOLUTION - Event::Duration(1))
+			/ RESOLUTION;
+	}
+
+	static constexpr Event::TimePoint TickToTime(uint_least64_t tick) noexcept {
+		return Event::TimePoint(tick * RESOLUTION);
+	}
+
+	static constexpr unsigned Shift(unsigned level) noexcept {
+		return SLOT_BITS * level;
+	}
+
+	void Insert(T &t, uint_least64_t tick) noexcept {
+		assert(tick >= base);
+
+		auto delta = tick - base;
+		if (delta > MAX_DELTA) {
+			delta = MAX_DELTA;
+			tick = base + delta;
+		}
+
+		unsigned level = 0;
+		while (level < N_LEVELS - 1 &&
+		       (delta >> Shift(level + 1)) != 0)
+			++level;
+
+		levels[level].Add((tick >> Shift(level)) & SLOT_MASK, t);
+	}
+
+	/**
+	 * Determine the next tick which needs attention: either
+	 * because a slot of the lowest level has timers, or because a
+	 * non-empty slot of a higher level needs to be cascaded.
+	 *
+	 * @return the tick or UINT_LEAST64_MAX if there are no timers
+	 */
+	uint_least64_t GetNextTick() noexcept {
+		uint_least64_t result = UINT_LEAST64_MAX;
+
+		for (unsigned l = 0; l < N_LEVELS; ++l) {
+			const unsigned shift = Shift(l);
+
+			/* the first slot of this level which begins at
+			   or after #base; slots before that have
+			   already been cascaded */
+			const auto first = (base + (uint_least64_t(1) << shift) - 1)
+				>> shift;
+
+			const auto distance =
+				levels[l].FindNext(first & SLOT_MASK);
+			if (distance < N_SLOTS) {
+				const auto tick = (first + distance) << shift;
+				if (tick < result)
+					result = tick;
+			}
+		}
+
+		return result;
+	}
+
+	/**
+	 * Process the tick #base: cascade the higher-level slots which
+	 * begin now and invoke the timers of the lowest-level slot.
+	 */
+	void RunTick() noexcept {
+		for (unsigned l = 1; l < N_LEVELS; ++l) {
+			const unsigned shift = Shift(l);
+			if ((base & ((uint_least64_t(1) << shift) - 1)) != 0)
+				break;
+
+			levels[l].Flush((base >> shift) & SLOT_MASK,
+					[this](T *t){
+						Insert(*t, CeilTick(t->GetDue()));
+					});
+		}
+
+		levels[0].Flush(base & SLOT_MASK, [](T *t){
+			t->Run();
+		});
+	}
+};
@@ -21,8 +21,9 @@
 #define EVENT_LOOP_HXX
 
 #include "Chrono.hxx"
-#include "TimerWheel.hxx"
-#include "TimerList.hxx"
+#include "HierarchicalTimerWheel.hxx"
+#include "CoarseTimerEvent.hxx"
+#include "FineTimerEvent.hxx"
 #include "Backend.hxx"
 #include "SocketEvent.hxx"
 #include "event/Features.h"
@@ -35,7 +36,6 @@
 #include "thread/Mutex.hxx"
 #endif
 
-#include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
 
 #include <atomic>
@@ -66,8 +66,8 @@ class EventLoop final
 	SocketEvent wake_event{*this, BIND_THIS_METHOD(OnSocketReady), wake_fd.GetSocket()};
 #endif
 
-	TimerWheel coarse_timers;
-	TimerList timers;
+	HierarchicalTimerWheel<CoarseTimerEvent, 1000> coarse_timers;
+	HierarchicalTimerWheel<FineTimerEvent, 1> timers;
 
 	using DeferList = IntrusiveList<DeferEvent>;
 
@@ -118,6 +118,14 @@ private:
 
 static constexpr Domain server_socket_domain("server_socket");
 
+/**
+ * The listen() backlog.  Many clients may connect at the same time
+ * (e.g. after MPD has been restarted), and with a small backlog, the
+ * kernel drops their SYN packets, delaying them by the TCP
+ * retransmission timeout.
+ */
+static constexpr int LISTEN_BACKLOG = 64;
+
 static int
 get_remote_uid(int fd)
 {
@@ -180,7 +188,7 @@ ServerSocket::OneServerSocket::Open()
 
 	auto _fd = socket_bind_listen(address.GetFamily(),
 				      SOCK_STREAM, 0,
-				      address, 5);
+				      address, LISTEN_BACKLOG);
 
 #ifdef HAVE_UN
 	/* allow everybody to connect */
@@ -21,6 +21,7 @@
 #include "FilterPlugin.hxx"
 #include "Registry.hxx"
 #include "Prepared.hxx"
+#include "plugins/ThreadedFilterPlugin.hxx"
 #include "config/Block.hxx"
 #include "util/RuntimeError.hxx"
 
@@ -36,5 +37,11 @@ filter_configured_new(const ConfigBlock &block)
 		throw FormatRuntimeError("No such filter plugin: %s",
 					 plugin_name);
 
-	return plugin->init(block);
+	auto filter = plugin->init(block);
+
+	if (block.GetBlockValue("threaded", false))
+		/* run this filter on its own worker thread */
+		filter = threaded_filter_new(std::move(filter));
+
+	return filter;
 }
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ThreadedFilterPlugin.hxx"
+#include "filter/Filter.hxx"
+#include "filter/Prepared.hxx"
+#include "pcm/Buffer.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Name.hxx"
+#include "thread/Thread.hxx"
+#include "util/BindMethod.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <cassert>
+#include <exception>
+#include <memory>
+
+#include <string.h>
+
+class ThreadedFilter final : public Filter {
+	/**
+	 * The underlying filter.  While #busy is set, it is owned by
+	 * the worker thread.
+	 */
+	const std::unique_ptr<Filter> filter;
+
+	Thread thread{BIND_THIS_METHOD(Run)};
+
+	Mutex mutex;
+
+	/**
+	 * Signals changes of #busy and #quit.
+	 */
+	Cond cond;
+
+	/**
+	 * A copy of the input block for the worker thread.
+	 */
+	PcmBuffer input_buffer;
+	size_t input_size;
+
+	/**
+	 * The worker thread copies the output of #filter to one of
+	 * these buffers, alternating, so the buffer returned by the
+	 * previous FilterPCM() call stays valid until the next call.
+	 */
+	PcmBuffer output_buffers[2];
+	unsigned output_index = 0;
+
+	/**
+	 * The output of the worker thread which has not yet been
+	 * returned by FilterPCM() or Flush().
+	 */
+	ConstBuffer<void> pending = nullptr;
+
+	std::exception_ptr error;
+
+	/**
+	 * Has FilterPCM() submitted a block which the worker thread
+	 * has not yet finished?
+	 */
+	bool busy = false;
+
+	bool quit = false;
+
+public:
+	explicit ThreadedFilter(std::unique_ptr<Filter> _filter)
+		:Filter(_filter->GetOutAudioFormat()),
+		 filter(std::move(_filter))
+	{
+		thread.Start();
+	}
+
+	~ThreadedFilter() noexcept override {
+		{
+			const std::lock_guard<Mutex> protect(mutex);
+			quit = true;
+			cond.notify_one();
+		}
+
+		thread.Join();
+	}
+
+	/* virtual methods from class Filter */
+	void Reset() noexcept override;
+	ConstBuffer<void> FilterPCM(ConstBuffer<void> src) override;
+	ConstBuffer<void> Flush() override;
+
+private:
+	/**
+	 * Wait until the worker thread has finished the current
+	 * block.
+	 */
+	void WaitIdle(std::unique_lock<Mutex> &lock) noexcept {
+		cond.wait(lock, [this]{ return !busy; });
+	}
+
+	/**
+	 * Called by the worker thread to filter the block in
+	 * #input_buffer.  Caller must not lock the mutex.
+	 */
+	ConstBuffer<void> Process();
+
+	void Run() noexcept;
+};
+
+class PreparedThreadedFilter final : public PreparedFilter {
+	/**
+	 * The underlying filter.
+	 */
+	std::unique_ptr<PreparedFilter> filter;
+
+public:
+	explicit PreparedThreadedFilter(std::unique_ptr<PreparedFilter> _filter) noexcept
+		:filter(std::move(_filter)) {}
+
+	std::unique_ptr<Filter> Open(AudioFormat &af) override {
+		return std::make_unique<ThreadedFilter>(filter->Open(af));
+	}
+};
+
+inline ConstBuffer<void>
+ThreadedFilter::Process()
+{
+	const ConstBuffer<void> src(input_buffer.Get(input_size),
+				    input_size);
+	const auto result = filter->FilterPCM(src);
+
+	/* copy the result, because it will be invalidated by the next
+	   FilterPCM() call, which may happen while the client is
+	   still using this result */
+	void *dest = output_buffers[output_index].Get(result.size);
+	if (!result.empty())
+		memcpy(dest, result.data, result.size);
+	return {dest, result.size};
+}
+
+void
+ThreadedFilter::Run() noexcept
+{
+	SetThreadName("filter");
+
+	std::unique_lock<Mutex> lock(mutex);
+
+	while (true) {
+		cond.wait(lock, [this]{ return busy || quit; });
+		if (quit)
+			break;
+
+		try {
+			const ScopeUnlock unlock(mutex);
+			auto result = Process();
+
+			/* the client thread is waiting in WaitIdle()
+			   and doesn't access "pending" without the
+			   mutex */
+			pending = result;
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		busy = false;
+		cond.notify_one();
+	}
+}
+
+void
+ThreadedFilter::Reset() noexcept
+{
+	std::unique_lock<Mutex> lock(mutex);
+	WaitIdle(lock);
+
+	pending = nullptr;
+	error = {};
+	filter->Reset();
+}
+
+ConstBuffer<void>
+ThreadedFilter::FilterPCM(ConstBuffer<void> src)
+{
+	std::unique_lock<Mutex> lock(mutex);
+	WaitIdle(lock);
+
+	if (error)
+		std::rethrow_exception(std::exchange(error, {}));
+
+	/* return the output of the previous block; the worker writes
+	   the next one to the other buffer */
+	ConstBuffer<void> result = std::exchange(pending, nullptr);
+	if (result.IsNull())
+		result = {output_buffers[output_index].Get(0), 0};
+	output_index ^= 1;
+
+	/* submit the new block to the worker thread */
+	void *dest = input_buffer.Get(src.size);
+	if (!src.empty())
+		memcpy(dest, src.data, src.size);
+	input_size = src.size;
+
+	busy = true;
+	cond.notify_one();
+
+	return result;
+}
+
+ConstBuffer<void>
+ThreadedFilter::Flush()
+{
+	std::unique_lock<Mutex> lock(mutex);
+	WaitIdle(lock);
+
+	if (error)
+		std::rethrow_exception(std::exchange(error, {}));
+
+	/* first return the output of the last FilterPCM() block */
+	if (!pending.IsNull()) {
+		auto result = std::exchange(pending, nullptr);
+		output_index ^= 1;
+		if (!result.empty())
+			return result;
+	}
+
+	/* the worker thread is idle; flush the underlying filter in
+	   this thread */
+	return filter->Flush();
+}
+
+std::unique_ptr<PreparedFilter>
+threaded_filter_new(std::unique_ptr<PreparedFilter> filter) noexcept
+{
+	return std::make_unique<PreparedThreadedFilter>(std::move(filter));
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_THREADED_FILTER_PLUGIN_HXX
+#define MPD_THREADED_FILTER_PLUGIN_HXX
+
+#include <memory>
+
+class PreparedFilter;
+
+/**
+ * Creates a new "threaded" filter.  It runs the underlying filter on
+ * a separate worker thread, so the filters of a chain can run in
+ * parallel on several CPU cores.  This adds a latency of one
+ * FilterPCM() call: each call returns the output of the previous
+ * call's input.
+ */
+std::unique_ptr<PreparedFilter>
+threaded_filter_new(std::unique_ptr<PreparedFilter> filter) noexcept;
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "BufferRing.hxx"
+#include "Ring.hxx"
+#include "system/Error.hxx"
+
+#include <cassert>
+#include <cstdint>
+
+#include <sys/mman.h>
+
+namespace Uring {
+
+BufferRing::BufferRing(Ring &_ring, unsigned _group,
+		       unsigned _n_buffers, std::size_t _buffer_size)
+	:ring(_ring), group(_group),
+	 n_buffers(_n_buffers), buffer_size(_buffer_size)
+{
+	assert(n_buffers > 0);
+	assert((n_buffers & (n_buffers - 1)) == 0);
+
+	const std::size_t ring_size = n_buffers * sizeof(struct io_uring_buf);
+	void *p = mmap(nullptr, ring_size, PROT_READ|PROT_WRITE,
+		       MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		throw MakeErrno("mmap() failed");
+
+	buf_ring = (struct io_uring_buf_ring *)p;
+
+	try {
+		buffers = std::make_unique<std::byte[]>(n_buffers * buffer_size);
+
+		struct io_uring_buf_reg reg{};
+		reg.ring_addr = (uintptr_t)buf_ring;
+		reg.ring_entries = n_buffers;
+		reg.bgid = group;
+		ring.RegisterBufferRing(reg);
+	} catch (...) {
+		munmap(buf_ring, ring_size);
+		throw;
+	}
+
+	io_uring_buf_ring_init(buf_ring);
+
+	const int mask = io_uring_buf_ring_mask(n_buffers);
+	for (unsigned i = 0; i < n_buffers; ++i)
+		io_uring_buf_ring_add(buf_ring, buffers.get() + i * buffer_size,
+				      buffer_size, i, mask, i);
+	io_uring_buf_ring_advance(buf_ring, n_buffers);
+}
+
+BufferRing::~BufferRing() noexcept
+{
+	ring.UnregisterBufferRing(group);
+	munmap(buf_ring, n_buffers * sizeof(struct io_uring_buf));
+}
+
+void
+BufferRing::Recycle(unsigned id) noexcept
+{
+	assert(id < n_buffers);
+
+	io_uring_buf_ring_add(buf_ring, buffers.get() + id * buffer_size,
+			      buffer_size, id,
+			      io_uring_buf_ring_mask(n_buffers), 0);
+	io_uring_buf_ring_advance(buf_ring, 1);
+}
+
+} // namespace Uring
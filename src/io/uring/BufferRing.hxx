@@ -0,0 +1,102 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+struct io_uring_buf_ring;
+
+namespace Uring {
+
+class Ring;
+
+/**
+ * A ring of buffers provided to the kernel
+ * (IORING_REGISTER_PBUF_RING).  Requests submitted with
+ * IOSQE_BUFFER_SELECT (e.g. a multishot receive) let the kernel pick
+ * a buffer only when data arrives, so idle sockets do not occupy
+ * one.  After the data has been consumed, the buffer must be handed
+ * back with Recycle().
+ */
+class BufferRing {
+	Ring &ring;
+
+	const unsigned group;
+
+	const unsigned n_buffers;
+
+	const std::size_t buffer_size;
+
+	/**
+	 * The ring shared with the kernel (page-aligned).
+	 */
+	struct io_uring_buf_ring *buf_ring;
+
+	std::unique_ptr<std::byte[]> buffers;
+
+	/**
+	 * Has the kernel rejected a multishot receive?  In that case,
+	 * this object remains registered, but is not used anymore.
+	 */
+	bool multishot_supported = true;
+
+public:
+	/**
+	 * Throws on error.
+	 *
+	 * @param _n_buffers the number of buffers; must be a power
+	 * of two
+	 */
+	BufferRing(Ring &_ring, unsigned _group,
+		   unsigned _n_buffers, std::size_t _buffer_size);
+
+	~BufferRing() noexcept;
+
+	BufferRing(const BufferRing &) = delete;
+	BufferRing &operator=(const BufferRing &) = delete;
+
+	unsigned GetGroup() const noexcept {
+		return group;
+	}
+
+	std::size_t GetBufferSize() const noexcept {
+		return buffer_size;
+	}
+
+	bool IsMultishotSupported() const noexcept {
+		return multishot_supported;
+	}
+
+	void DisableMultishot() noexcept {
+		multishot_supported = false;
+	}
+
+	const std::byte *GetBuffer(unsigned id) const noexcept {
+		return buffers.get() + id * buffer_size;
+	}
+
+	/**
+	 * Give the specified buffer back to the kernel.
+	 */
+	void Recycle(unsigned id) noexcept;
+};
+
+} // namespace Uring
@@ -65,6 +65,18 @@ public:
 		// TODO: io_uring_prep_cancel()
 	}
 
+	/**
+	 * The #Queue is being destroyed, and the operation will
+	 * never complete.  Detach it, so the #Operation does not
+	 * refer to this object anymore.
+	 */
+	void Abandon() noexcept {
+		if (operation != nullptr) {
+			assert(operation->cancellable == this);
+			std::exchange(operation, nullptr)->cancellable = nullptr;
+		}
+	}
+
 	void Replace(Operation &old_operation,
 		     Operation &new_operation) noexcept {
 		assert(operation == &old_operation);
@@ -75,14 +87,24 @@ public:
 		new_operation.cancellable = this;
 	}
 
-	void OnUringCompletion(int res) noexcept {
+	/**
+	 * @param more more completions of this (multishot) operation
+	 * will follow, i.e. it remains pending
+	 */
+	void OnUringCompletion(int res, unsigned flags, bool more) noexcept {
 		if (operation == nullptr)
 			return;
 
 		assert(operation->cancellable == this);
+
+		if (more) {
+			operation->OnUringCompletionFlags(res, flags);
+			return;
+		}
+
 		operation->cancellable = nullptr;
 
-		std::exchange(operation, nullptr)->OnUringCompletion(res);
+		std::exchange(operation, nullptr)->OnUringCompletionFlags(res, flags);
 	}
 };
 
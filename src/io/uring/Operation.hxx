@@ -41,6 +41,7 @@ class CancellableOperation;
  */
 class Operation {
 	friend class CancellableOperation;
+	friend class Queue;
 
 	CancellableOperation *cancellable = nullptr;
 
@@ -76,6 +77,18 @@ public:
 	 * occurred
 	 */
 	virtual void OnUringCompletion(int res) noexcept = 0;
+
+	/**
+	 * Like OnUringCompletion(), but with the completion flags
+	 * (IORING_CQE_F_*).  Operations which submit multishot
+	 * requests override this method; if IORING_CQE_F_MORE is
+	 * set, the operation remains pending and more completions
+	 * will follow.
+	 */
+	virtual void OnUringCompletionFlags(int res,
+					    [[maybe_unused]] unsigned flags) noexcept {
+		OnUringCompletion(res);
+	}
 };
 
 } // namespace Uring
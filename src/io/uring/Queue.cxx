@@ -32,7 +32,12 @@
 
 #include "Queue.hxx"
 #include "CancellableOperation.hxx"
-#include "util/DeleteDisposer.hxx"
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+#include "BufferRing.hxx"
+#endif
+
+#include <cassert>
 
 namespace Uring {
 
@@ -43,7 +48,29 @@ Queue::Queue(unsigned entries, unsigned flags)
 
 Queue::~Queue() noexcept
 {
-	operations.clear_and_dispose(DeleteDisposer{});
+#ifdef HAVE_URING_RECV_MULTISHOT
+	/* unregister while the ring still exists */
+	buffer_ring.reset();
+#endif
+
+	operations.clear_and_dispose([](CancellableOperation *c){
+		c->Abandon();
+		delete c;
+	});
+}
+
+struct io_uring_sqe &
+Queue::RequireSubmitEntry()
+{
+	auto *s = GetSubmitEntry();
+	if (s == nullptr) {
+		Submit();
+
+		s = GetSubmitEntry();
+		assert(s != nullptr);
+	}
+
+	return *s;
 }
 
 void
@@ -55,15 +82,56 @@ Queue::AddPending(struct io_uring_sqe &sqe,
 	io_uring_sqe_set_data(&sqe, c);
 }
 
+void
+Queue::RequestCancel(Operation &operation)
+{
+	assert(operation.IsUringPending());
+
+	auto &s = RequireSubmitEntry();
+	io_uring_prep_cancel(&s, operation.cancellable, 0);
+
+	/* the completion of the cancel request itself is ignored */
+	io_uring_sqe_set_data(&s, nullptr);
+	Submit();
+}
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+
+BufferRing *
+Queue::GetBufferRing() noexcept
+{
+	if (!buffer_ring && !buffer_ring_failed) {
+		try {
+			buffer_ring = std::make_unique<BufferRing>(ring,
+								   BUFFER_GROUP,
+								   N_BUFFERS,
+								   BUFFER_SIZE);
+		} catch (...) {
+			/* not supported by this kernel */
+			buffer_ring_failed = true;
+		}
+	}
+
+	if (buffer_ring && !buffer_ring->IsMultishotSupported())
+		return nullptr;
+
+	return buffer_ring.get();
+}
+
+#endif
+
 void
 Queue::DispatchOneCompletion(struct io_uring_cqe &cqe) noexcept
 {
 	void *data = io_uring_cqe_get_data(&cqe);
 	if (data != nullptr) {
 		auto *c = (CancellableOperation *)data;
-		c->OnUringCompletion(cqe.res);
-		c->unlink();
-		delete c;
+		const bool more = cqe.flags & IORING_CQE_F_MORE;
+		c->OnUringCompletion(cqe.res, cqe.flags, more);
+		if (!more) {
+			c->unlink();
+			delete c;
+		}
 	}
 
 	ring.SeenCompletion(cqe);
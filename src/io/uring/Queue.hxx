@@ -37,10 +37,16 @@
 
 #include <liburing.h>
 
+#ifdef HAVE_URING_RECV_MULTISHOT
+#include <cstddef>
+#include <memory>
+#endif
+
 namespace Uring {
 
 class Operation;
 class CancellableOperation;
+class BufferRing;
 
 /**
  * High-level C++ wrapper for a `struct io_uring`.  It supports a
@@ -51,6 +57,20 @@ class Queue {
 
 	IntrusiveList<CancellableOperation> operations;
 
+#ifdef HAVE_URING_RECV_MULTISHOT
+	static constexpr unsigned BUFFER_GROUP = 1;
+	static constexpr unsigned N_BUFFERS = 256;
+	static constexpr std::size_t BUFFER_SIZE = 4096;
+
+	/**
+	 * Provided buffers for multishot receives; created on demand
+	 * by GetBufferRing().
+	 */
+	std::unique_ptr<BufferRing> buffer_ring;
+
+	bool buffer_ring_failed = false;
+#endif
+
 public:
 	Queue(unsigned entries, unsigned flags);
 	~Queue() noexcept;
@@ -63,10 +83,33 @@ public:
 		return ring.GetSubmitEntry();
 	}
 
+	/**
+	 * Like GetSubmitEntry(), but if the submission queue is full,
+	 * submit all pending entries to make room.  Throws on error.
+	 */
+	struct io_uring_sqe &RequireSubmitEntry();
+
 	bool HasPending() const noexcept {
 		return !operations.empty();
 	}
 
+	/**
+	 * Ask the kernel to cancel the given pending operation
+	 * (IORING_OP_ASYNC_CANCEL).  This is needed to stop a
+	 * multishot request; the operation receives a final
+	 * completion (usually -ECANCELED).  Throws on error.
+	 */
+	void RequestCancel(Operation &operation);
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+	/**
+	 * Obtain the #BufferRing for multishot receives, creating it
+	 * if necessary.  Returns nullptr if the kernel does not
+	 * support it.
+	 */
+	BufferRing *GetBufferRing() noexcept;
+#endif
+
 protected:
 	void AddPending(struct io_uring_sqe &sqe,
 			Operation &operation) noexcept;
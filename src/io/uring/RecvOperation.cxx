@@ -0,0 +1,207 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "RecvOperation.hxx"
+#include "Queue.hxx"
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+#include "BufferRing.hxx"
+#endif
+
+#include <cassert>
+#include <cerrno>
+
+namespace Uring {
+
+void
+RecvOperation::Start(Queue &_queue, FileDescriptor _fd,
+		     std::size_t size, RecvHandler &_handler)
+{
+	assert(!IsUringPending());
+
+	if (size > buffer_size) {
+		buffer = std::make_unique<std::byte[]>(size);
+		buffer_size = size;
+	}
+
+	auto &s = _queue.RequireSubmitEntry();
+
+	queue = &_queue;
+	fd = _fd;
+	handler = &_handler;
+
+	io_uring_prep_recv(&s, fd.Get(), buffer.get(), size, 0);
+	queue->Push(s, *this);
+}
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+
+void
+RecvOperation::StartMultishot(Queue &_queue, FileDescriptor _fd,
+			      BufferRing &_buffer_ring,
+			      RecvHandler &_handler)
+{
+	if (IsUringPending()) {
+		/* keep receiving */
+		stopping = false;
+		return;
+	}
+
+	queue = &_queue;
+	fd = _fd;
+	handler = &_handler;
+	buffer_ring = &_buffer_ring;
+
+	SubmitMultishot();
+}
+
+void
+RecvOperation::SubmitMultishot()
+{
+	assert(buffer_ring != nullptr);
+
+	auto &s = queue->RequireSubmitEntry();
+
+	stopping = false;
+
+	io_uring_prep_recv_multishot(&s, fd.Get(), nullptr, 0, 0);
+	s.flags |= IOSQE_BUFFER_SELECT;
+	s.buf_group = buffer_ring->GetGroup();
+	queue->Push(s, *this);
+}
+
+#endif
+
+void
+RecvOperation::Stop() noexcept
+{
+#ifdef HAVE_URING_RECV_MULTISHOT
+	if (buffer_ring == nullptr || stopping || !IsUringPending())
+		return;
+
+	stopping = true;
+
+	try {
+		queue->RequestCancel(*this);
+	} catch (...) {
+		/* the request keeps running; the handler will
+		   receive more data than it asked for, but that is
+		   harmless */
+	}
+#endif
+}
+
+void
+RecvOperation::OnUringCompletion(int res) noexcept
+{
+	if (handler == nullptr)
+		/* operation was canceled */
+		delete this;
+	else if (res >= 0)
+		handler->OnRecv(buffer.get(), res);
+	else
+		handler->OnRecvError(-res);
+}
+
+void
+RecvOperation::OnUringCompletionFlags(int res, unsigned flags) noexcept
+{
+#ifdef HAVE_URING_RECV_MULTISHOT
+	if (buffer_ring == nullptr) {
+		OnUringCompletion(res);
+		return;
+	}
+
+	auto &ring = *buffer_ring;
+
+	if ((flags & IORING_CQE_F_MORE) == 0)
+		/* the request has finished; the handler may submit a
+		   new one */
+		buffer_ring = nullptr;
+
+	if (flags & IORING_CQE_F_BUFFER) {
+		const unsigned id = flags >> IORING_CQE_BUFFER_SHIFT;
+
+		/* the handler may delete this object, therefore
+		   don't touch any attributes afterwards */
+		if (handler != nullptr && res > 0)
+			handler->OnRecv(ring.GetBuffer(id), res);
+		else if (handler == nullptr && !IsUringPending())
+			delete this;
+
+		ring.Recycle(id);
+		return;
+	}
+
+	if (IsUringPending())
+		/* not the final completion; this should not happen
+		   without a buffer */
+		return;
+
+	if (handler == nullptr) {
+		delete this;
+		return;
+	}
+
+	switch (res) {
+	case -ECANCELED:
+		if (stopping)
+			break;
+
+		/* Stop() was revoked after the request had been
+		   canceled */
+		buffer_ring = &ring;
+		try {
+			SubmitMultishot();
+		} catch (...) {
+			buffer_ring = nullptr;
+			handler->OnRecvError(EIO);
+		}
+
+		break;
+
+	case -EINVAL:
+		/* this kernel does not support multishot receives */
+		ring.DisableMultishot();
+		[[fallthrough]];
+
+	case -ENOBUFS:
+		/* receive once into our own buffer; the handler
+		   will then try multishot again (if supported) */
+		if (stopping)
+			break;
+
+		try {
+			Start(*queue, fd, ring.GetBufferSize(), *handler);
+		} catch (...) {
+			handler->OnRecvError(EIO);
+		}
+
+		break;
+
+	default:
+		OnUringCompletion(res);
+	}
+#else
+	(void)flags;
+	OnUringCompletion(res);
+#endif
+}
+
+} // namespace Uring
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include "Operation.hxx"
+#include "io/FileDescriptor.hxx"
+#include "io/uring/Features.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace Uring {
+
+class Queue;
+class BufferRing;
+
+class RecvHandler {
+public:
+	/**
+	 * @param size the number of bytes received; 0 means the peer
+	 * has shut down its side of the connection
+	 */
+	virtual void OnRecv(const void *data, std::size_t size) noexcept = 0;
+
+	/**
+	 * @param error an errno value
+	 */
+	virtual void OnRecvError(int error) noexcept = 0;
+};
+
+/**
+ * Receive data from a socket (IORING_OP_RECV).
+ *
+ * In single-shot mode (Start()), the buffer is owned by this object
+ * and is reused by subsequent Start() calls.
+ *
+ * In multishot mode (StartMultishot()), one request keeps receiving
+ * into buffers picked by the kernel from a #BufferRing until Stop()
+ * is called, which saves one submission per receive and lets idle
+ * sockets go without a buffer.
+ */
+class RecvOperation final : Operation {
+	Queue *queue;
+
+	FileDescriptor fd;
+
+	RecvHandler *handler;
+
+	std::unique_ptr<std::byte[]> buffer;
+	std::size_t buffer_size = 0;
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+	/**
+	 * The buffers of the pending multishot request; nullptr if
+	 * a single-shot request is pending.
+	 */
+	BufferRing *buffer_ring = nullptr;
+
+	/**
+	 * Has Stop() requested cancellation of the multishot
+	 * request?
+	 */
+	bool stopping = false;
+#endif
+
+public:
+	using Operation::IsUringPending;
+
+	/**
+	 * Receive once.  Throws on error.
+	 */
+	void Start(Queue &_queue, FileDescriptor _fd,
+		   std::size_t size, RecvHandler &_handler);
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+	/**
+	 * Receive continuously until Stop() is called or the peer
+	 * shuts down the connection.  If a multishot request is
+	 * already pending, this only revokes a previous Stop() call.
+	 * Throws on error.
+	 */
+	void StartMultishot(Queue &_queue, FileDescriptor _fd,
+			    BufferRing &_buffer_ring, RecvHandler &_handler);
+#endif
+
+	/**
+	 * Stop a pending multishot request.  Data which has already
+	 * been received may still be delivered to the handler.  This
+	 * is a no-op for a single-shot request.
+	 */
+	void Stop() noexcept;
+
+	/**
+	 * Cancel this operation and free it; if it is pending, this
+	 * instance will be freed using `delete` after the kernel has
+	 * finished it, i.e. the caller resigns ownership.
+	 */
+	void Cancel() noexcept {
+		if (IsUringPending()) {
+			Stop();
+			handler = nullptr;
+		} else
+			delete this;
+	}
+
+private:
+#ifdef HAVE_URING_RECV_MULTISHOT
+	void SubmitMultishot();
+#endif
+
+	/* virtual methods from class Operation */
+	void OnUringCompletion(int res) noexcept override;
+	void OnUringCompletionFlags(int res, unsigned flags) noexcept override;
+};
+
+} // namespace Uring
@@ -50,6 +50,18 @@ Ring::Submit()
 		throw MakeErrno(-error, "io_uring_submit() failed");
 }
 
+#ifdef HAVE_URING_RECV_MULTISHOT
+
+void
+Ring::RegisterBufferRing(struct io_uring_buf_reg &reg)
+{
+	int error = io_uring_register_buf_ring(&ring, &reg, 0);
+	if (error < 0)
+		throw MakeErrno(-error, "io_uring_register_buf_ring() failed");
+}
+
+#endif
+
 struct io_uring_cqe *
 Ring::WaitCompletion()
 {
@@ -32,6 +32,7 @@
 
 #pragma once
 
+#include "io/uring/Features.h"
 #include "io/FileDescriptor.hxx"
 
 #include <liburing.h>
@@ -76,6 +77,18 @@ public:
 	void SeenCompletion(struct io_uring_cqe &cqe) noexcept {
 		io_uring_cqe_seen(&ring, &cqe);
 	}
+
+#ifdef HAVE_URING_RECV_MULTISHOT
+	/**
+	 * Register a ring of provided buffers
+	 * (IORING_REGISTER_PBUF_RING).  Throws on error.
+	 */
+	void RegisterBufferRing(struct io_uring_buf_reg &reg);
+
+	void UnregisterBufferRing(unsigned group) noexcept {
+		io_uring_unregister_buf_ring(&ring, group);
+	}
+#endif
 };
 
 } // namespace Uring
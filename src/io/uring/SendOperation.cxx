@@ -0,0 +1,85 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "SendOperation.hxx"
+#include "Queue.hxx"
+
+#include <cassert>
+#include <cerrno>
+
+#include <sys/socket.h>
+
+namespace Uring {
+
+void
+SendOperation::Start(Queue &_queue, FileDescriptor _fd,
+		     SendHandler &_handler)
+{
+	assert(!IsUringPending());
+	assert(!buffer.empty());
+
+	queue = &_queue;
+	fd = _fd;
+	handler = &_handler;
+	position = 0;
+
+	Submit();
+}
+
+void
+SendOperation::Submit()
+{
+	auto &s = queue->RequireSubmitEntry();
+
+	io_uring_prep_send(&s, fd.Get(), buffer.data() + position,
+			   buffer.size() - position, MSG_NOSIGNAL);
+	queue->Push(s, *this);
+}
+
+void
+SendOperation::OnUringCompletion(int res) noexcept
+{
+	if (handler == nullptr) {
+		/* operation was canceled */
+		delete this;
+		return;
+	}
+
+	if (res < 0) {
+		handler->OnSendError(-res);
+		return;
+	}
+
+	position += res;
+	if (position < buffer.size()) {
+		/* partial send: continue with the rest */
+		try {
+			Submit();
+		} catch (...) {
+			handler->OnSendError(EIO);
+		}
+
+		return;
+	}
+
+	buffer.clear();
+	handler->OnSend();
+}
+
+} // namespace Uring
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include "Operation.hxx"
+#include "io/FileDescriptor.hxx"
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+
+namespace Uring {
+
+class Queue;
+
+class SendHandler {
+public:
+	/**
+	 * The whole buffer has been sent.
+	 */
+	virtual void OnSend() noexcept = 0;
+
+	/**
+	 * @param error an errno value
+	 */
+	virtual void OnSendError(int error) noexcept = 0;
+};
+
+/**
+ * Send a buffer to a socket (IORING_OP_SEND).  Partial sends are
+ * continued until the whole buffer has been sent.
+ */
+class SendOperation final : Operation {
+	Queue *queue;
+
+	FileDescriptor fd;
+
+	SendHandler *handler;
+
+	std::string buffer;
+
+	/**
+	 * The number of bytes of #buffer which have already been
+	 * sent.
+	 */
+	std::size_t position;
+
+public:
+	using Operation::IsUringPending;
+
+	/**
+	 * Obtain the buffer which shall be sent by the next Start()
+	 * call.  Must not be used while the operation is pending.
+	 */
+	std::string &GetBuffer() noexcept {
+		assert(!IsUringPending());
+
+		return buffer;
+	}
+
+	/**
+	 * Begin sending the buffer.  Throws on error.
+	 */
+	void Start(Queue &_queue, FileDescriptor _fd,
+		   SendHandler &_handler);
+
+	/**
+	 * Like RecvOperation::Cancel().
+	 */
+	void Cancel() noexcept {
+		if (IsUringPending())
+			handler = nullptr;
+		else
+			delete this;
+	}
+
+private:
+	void Submit();
+
+	/* virtual methods from class Operation */
+	void OnUringCompletion(int res) noexcept override;
+};
+
+} // namespace Uring
@@ -112,6 +112,14 @@ public:
 	 */
 	std::forward_list<std::string> getSearchCapabilities(UpnpClient_Handle handle) const;
 
+	/**
+	 * Retrieve the SystemUpdateID, which changes whenever the
+	 * contents of the server are modified.
+	 *
+	 * Throws std::runtime_error on error.
+	 */
+	unsigned getSystemUpdateID(UpnpClient_Handle handle) const;
+
 	gcc_pure
 	std::string GetURI() const noexcept {
 		return "upnp://" + m_deviceId + "/" + m_serviceType;
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DeflateEncoder.hxx"
+#include "Error.hxx"
+
+DeflateEncoder::DeflateEncoder(int level)
+{
+	z.next_in = nullptr;
+	z.avail_in = 0;
+	z.zalloc = Z_NULL;
+	z.zfree = Z_NULL;
+	z.opaque = Z_NULL;
+
+	int result = deflateInit(&z, level);
+	if (result != Z_OK)
+		throw ZlibError(result);
+}
+
+DeflateEncoder::~DeflateEncoder() noexcept
+{
+	deflateEnd(&z);
+}
+
+void
+DeflateEncoder::Encode(std::string_view src, std::string &dest)
+{
+	/* zlib's API requires non-const input pointer */
+	z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(src.data()));
+	z.avail_in = src.size();
+
+	do {
+		Bytef output[16384];
+		z.next_out = output;
+		z.avail_out = sizeof(output);
+
+		int result = deflate(&z, Z_SYNC_FLUSH);
+		if (result != Z_OK && result != Z_BUF_ERROR)
+			throw ZlibError(result);
+
+		dest.append((const char *)output, z.next_out - output);
+
+		/* if zlib has filled the whole output buffer, there
+		   may be more pending output */
+	} while (z.avail_in > 0 || z.avail_out == 0);
+}
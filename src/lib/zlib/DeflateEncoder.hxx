@@ -0,0 +1,56 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef ZLIB_DEFLATE_ENCODER_HXX
+#define ZLIB_DEFLATE_ENCODER_HXX
+
+#include <zlib.h>
+
+#include <string>
+#include <string_view>
+
+/**
+ * A streaming "deflate" compressor (RFC 1950 "zlib" format).  Its
+ * memory usage is bounded by zlib's window size, no matter how much
+ * data is passed through it.
+ */
+class DeflateEncoder {
+	z_stream z;
+
+public:
+	/**
+	 * Throws #ZlibError on error.
+	 */
+	explicit DeflateEncoder(int level=Z_DEFAULT_COMPRESSION);
+	~DeflateEncoder() noexcept;
+
+	DeflateEncoder(const DeflateEncoder &) = delete;
+	DeflateEncoder &operator=(const DeflateEncoder &) = delete;
+
+	/**
+	 * Compress the given data and append the result to #dest.
+	 * The output is flushed (Z_SYNC_FLUSH), i.e. the peer can
+	 * decompress all of #src without waiting for more data.
+	 *
+	 * Throws #ZlibError on error.
+	 */
+	void Encode(std::string_view src, std::string &dest);
+};
+
+#endif
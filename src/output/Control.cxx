@@ -351,11 +351,18 @@ AudioOutputControl::LockIsChunkConsumed(const MusicChunk &chunk) const noexcept
 void
 AudioOutputControl::LockPlay() noexcept
 {
+	if (woken_for_play)
+		/* fast path: the OutputThread is awake and will see
+		   the new chunk without locking the mutex; this is
+		   safe because the OutputThread clears the flag
+		   before it checks the pipe for the last time */
+		return;
+
 	const std::lock_guard<Mutex> protect(mutex);
 
 	assert(allow_play);
 
-	if (IsOpen() && !in_playback_loop && !woken_for_play) {
+	if (IsOpen() && !woken_for_play) {
 		woken_for_play = true;
 		wake_cond.notify_one();
 	}
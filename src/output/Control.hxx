@@ -28,6 +28,7 @@
 #include "system/PeriodClock.hxx"
 #include "util/Compiler.h"
 
+#include <atomic>
 #include <cstdint>
 #include <exception>
 #include <map>
@@ -206,19 +207,23 @@ class AudioOutputControl {
 	bool caught_interrupted;
 
 	/**
-	 * True while the OutputThread is inside ao_play().  This
-	 * means the PlayerThread does not need to wake up the
-	 * OutputThread when new chunks are added to the MusicPipe,
-	 * because the OutputThread is already watching that.
+	 * True while the OutputThread is inside InternalPlay().
 	 */
 	bool in_playback_loop = false;
 
 	/**
-	 * Has the OutputThread been woken up to play more chunks?
-	 * This is set by audio_output_play() and reset by ao_play()
-	 * to reduce the number of duplicate wakeups.
+	 * Does the OutputThread notice new chunks without being woken
+	 * up?  This is set by LockPlay() after waking up the
+	 * OutputThread and while the OutputThread is inside its
+	 * playback loop; it is cleared by the OutputThread before it
+	 * checks the #MusicPipe for the last time prior to waiting
+	 * on #wake_cond.
+	 *
+	 * This is atomic so that LockPlay() can skip locking the
+	 * #mutex if the flag is set, which is the common case while
+	 * playing.
 	 */
-	bool woken_for_play = false;
+	std::atomic_bool woken_for_play{false};
 
 	/**
 	 * If this flag is set, then the next WaitForDelay() call is
@@ -300,6 +300,10 @@ AudioOutputControl::InternalPlay(std::unique_lock<Mutex> &lock) noexcept
 	assert(!in_playback_loop);
 	in_playback_loop = true;
 
+	/* we're watching the pipe; the player doesn't need to wake
+	   us up for each new chunk */
+	woken_for_play = true;
+
 	AtScopeExit(this) {
 		assert(in_playback_loop);
 		in_playback_loop = false;
@@ -434,13 +438,18 @@ AudioOutputControl::Task() noexcept
 			/* no pending command: play (or wait for a
 			   command) */
 
+			/* this must be cleared before checking the
+			   pipe, or else LockPlay() might skip the
+			   wakeup for a chunk which arrives after the
+			   check */
+			woken_for_play = false;
+
 			if (open && allow_play && !caught_interrupted &&
 			    InternalPlay(lock))
 				/* don't wait for an event if there
 				   are more chunks in the pipe */
 				continue;
 
-			woken_for_play = false;
 			wake_cond.wait(lock);
 			break;
 
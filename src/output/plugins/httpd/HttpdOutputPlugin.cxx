@@ -31,13 +31,55 @@
 #include "util/Domain.hxx"
 #include "util/DeleteDisposer.hxx"
 #include "config/Net.hxx"
+#include "config/Parser.hxx"
+#include "util/IterableSplitString.hxx"
 
 #include <cassert>
+#include <stdexcept>
+#include <string>
 
 #include <string.h>
 
 const Domain httpd_output_domain("httpd_output");
 
+/**
+ * Add a listener for each port in the comma-separated "port"
+ * setting.  Listing several ports in one output allows serving the
+ * same stream on all of them while filtering and encoding it only
+ * once.  A local socket address ignores the port, therefore only one
+ * port is allowed in that case.
+ *
+ * Throws on error.
+ */
+static void
+AddPorts(ServerSocket &server_socket, const char *address, const char *ports)
+{
+	if (ports == nullptr) {
+		ServerSocketAddGeneric(server_socket, address, 8000U);
+		return;
+	}
+
+	const bool local = address != nullptr &&
+		(address[0] == '/' || address[0] == '~' || address[0] == '@');
+
+	unsigned n = 0;
+	for (auto i : IterableSplitString(ports, ',')) {
+		if (local && n > 0)
+			throw std::runtime_error("Multiple ports are not allowed with a local socket address");
+
+		i.Strip();
+		const unsigned port = ParseUnsigned(std::string(i.data, i.size).c_str());
+		if (port == 0 || port > 0xffff)
+			throw std::runtime_error("Invalid port number");
+
+		ServerSocketAddGeneric(server_socket, address, port);
+		++n;
+	}
+
+	if (n == 0)
+		throw std::runtime_error("at least one port expected");
+}
+
 inline
 HttpdOutput::HttpdOutput(EventLoop &_loop, const ConfigBlock &block)
 	:AudioOutput(FLAG_ENABLE_DISABLE|FLAG_PAUSE),
@@ -54,7 +96,8 @@ HttpdOutput::HttpdOutput(EventLoop &_loop, const ConfigBlock &block)
 
 	/* set up bind_to_address */
 
-	ServerSocketAddGeneric(*this, block.GetBlockValue("bind_to_address"), block.GetBlockValue("port", 8000U));
+	AddPorts(*this, block.GetBlockValue("bind_to_address"),
+		 block.GetBlockValue("port"));
 
 	/* determine content type */
 	content_type = prepared_encoder->GetMimeType();
@@ -200,6 +200,7 @@ PlayerControl::LockClearError() noexcept
 {
 	const std::lock_guard<Mutex> protect(mutex);
 	ClearError();
+	listener.OnPlayerStatusModified();
 }
 
 void
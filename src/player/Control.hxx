@@ -30,13 +30,13 @@
 #include "ReplayGainConfig.hxx"
 #include "ReplayGainMode.hxx"
 #include "MusicChunkPtr.hxx"
+#include "Listener.hxx"
 
 #include <cstdint>
 #include <exception>
 #include <memory>
 
 struct Tag;
-class PlayerListener;
 class PlayerOutputs;
 class InputCacheManager;
 class DetachedSong;
@@ -462,6 +462,9 @@ private:
 		command = cmd;
 		Signal();
 		WaitCommandLocked(lock);
+
+		if (cmd != PlayerCommand::REFRESH)
+			listener.OnPlayerStatusModified();
 	}
 
 	/**
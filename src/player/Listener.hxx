@@ -36,6 +36,14 @@ public:
 	 * Playback went into border pause.
 	 */
 	virtual void OnBorderPause() noexcept = 0;
+
+	/**
+	 * The main thread has modified the player status, possibly
+	 * without an idle event (e.g. "clearerror", or the player
+	 * thread not having started playback yet).  This is called
+	 * while the #PlayerControl is locked.
+	 */
+	virtual void OnPlayerStatusModified() noexcept = 0;
 };
 
 #endif
@@ -40,6 +40,9 @@ playlist_open_in_playlist_dir(const char *uri, Mutex &mutex)
 	if (path_fs.IsNull())
 		return nullptr;
 
+	/* make sure the file is up to date */
+	spl_flush(uri);
+
 	return playlist_open_path(path_fs, mutex);
 }
 
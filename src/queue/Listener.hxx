@@ -20,6 +20,8 @@
 #ifndef MPD_QUEUE_LISTENER_HXX
 #define MPD_QUEUE_LISTENER_HXX
 
+class DetachedSong;
+
 class QueueListener {
 public:
 	/**
@@ -38,6 +40,14 @@ public:
 	 * been notified by the player thread.
 	 */
 	virtual void OnQueueSongStarted() noexcept = 0;
+
+	/**
+	 * Look up a song which was restored without being resolved
+	 * (see Queue::Item::unresolved) and update it in place.
+	 *
+	 * @return false if the song was not found
+	 */
+	virtual bool OnQueueResolveSong(DetachedSong &song) noexcept = 0;
 };
 
 #endif
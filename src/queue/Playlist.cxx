@@ -61,12 +61,31 @@ playlist::TagModified(const char *uri, const Tag &tag) noexcept
 		OnModified();
 }
 
+void
+playlist::ResolveOrder(unsigned order) noexcept
+{
+	const unsigned position = queue.OrderToPosition(order);
+	if (!queue.IsUnresolvedAtPosition(position))
+		return;
+
+	/* if this fails, leave the song as it is; the player will
+	   fail to play it and skip it */
+	queue.SetUnresolvedAtPosition(position, false);
+
+	if (listener.OnQueueResolveSong(queue.Get(position))) {
+		queue.ModifyAtPosition(position);
+		OnModified();
+	}
+}
+
 inline void
 playlist::QueueSongOrder(PlayerControl &pc, unsigned order) noexcept
 
 {
 	assert(queue.IsValidOrder(order));
 
+	ResolveOrder(order);
+
 	queued = order;
 
 	const DetachedSong &song = queue.GetOrder(order);
@@ -176,6 +195,8 @@ playlist::PlayOrder(PlayerControl &pc, unsigned order)
 	playing = true;
 	queued = -1;
 
+	ResolveOrder(order);
+
 	const DetachedSong &song = queue.GetOrder(order);
 
 	FormatDebug(playlist_domain, "play %u:\"%s\"", order, song.GetURI());
@@ -137,6 +137,13 @@ struct playlist {
 	void BorderPause(PlayerControl &pc) noexcept;
 
 protected:
+	/**
+	 * Make sure the song at the given order has been resolved
+	 * (see Queue::Item::unresolved) before it is passed to the
+	 * player.
+	 */
+	void ResolveOrder(unsigned order) noexcept;
+
 	/**
 	 * Called by all editing methods after a modification.
 	 * Updates the queue version and invokes
@@ -250,6 +257,15 @@ public:
 	 */
 	void StaleSong(PlayerControl &pc, const char *uri) noexcept;
 
+	/**
+	 * Resolve up to the given number of songs which were restored
+	 * without looking them up (see Queue::Item::unresolved), and
+	 * remove the ones which cannot be found.
+	 *
+	 * @return true if there are more unresolved songs
+	 */
+	bool ResolveSongs(PlayerControl &pc, unsigned max) noexcept;
+
 	void Shuffle(PlayerControl &pc, unsigned start, unsigned end) noexcept;
 
 	void MoveRange(PlayerControl &pc, unsigned start,
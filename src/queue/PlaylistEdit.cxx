@@ -319,6 +319,43 @@ playlist::StaleSong(PlayerControl &pc, const char *uri) noexcept
 			DeletePosition(pc, i);
 }
 
+bool
+playlist::ResolveSongs(PlayerControl &pc, unsigned max) noexcept
+{
+	/* see StaleSong() */
+	const int current_position = playing
+		? GetCurrentPosition()
+		: -1;
+
+	bool modified = false;
+
+	for (unsigned i = 0; i < queue.GetLength() && max > 0;) {
+		if (!queue.IsUnresolvedAtPosition(i)) {
+			++i;
+			continue;
+		}
+
+		--max;
+
+		if (listener.OnQueueResolveSong(queue.Get(i))) {
+			queue.SetUnresolvedAtPosition(i, false);
+			queue.ModifyAtPosition(i);
+			modified = true;
+			++i;
+		} else if (int(i) == current_position) {
+			/* the player will skip it */
+			queue.SetUnresolvedAtPosition(i, false);
+			++i;
+		} else
+			DeletePosition(pc, i);
+	}
+
+	if (modified)
+		OnModified();
+
+	return queue.HasUnresolved();
+}
+
 void
 playlist::MoveRange(PlayerControl &pc,
 		    unsigned start, unsigned end, int to)
@@ -52,14 +52,19 @@
 #define PLAYLIST_STATE_FILE_MIXRAMPDELAY	"mixrampdelay: "
 #define PLAYLIST_STATE_FILE_PLAYLIST_BEGIN	"playlist_begin"
 #define PLAYLIST_STATE_FILE_PLAYLIST_END	"playlist_end"
+#define PLAYLIST_STATE_FILE_PLAYLIST_CHANGES	"playlist_changes: "
 
 #define PLAYLIST_STATE_FILE_STATE_PLAY		"play"
 #define PLAYLIST_STATE_FILE_STATE_PAUSE		"pause"
 #define PLAYLIST_STATE_FILE_STATE_STOP		"stop"
 
-void
-playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
-		    PlayerControl &pc)
+/**
+ * Save everything except for the queue.
+ */
+static void
+playlist_state_save_settings(BufferedOutputStream &os,
+			     const struct playlist &playlist,
+			     PlayerControl &pc)
 {
 	const auto player_status = pc.LockGetStatus();
 
@@ -96,14 +101,41 @@ playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
 		  (double)pc.GetMixRampDb());
 	os.Format(PLAYLIST_STATE_FILE_MIXRAMPDELAY "%f\n",
 		  pc.GetMixRampDelay().count());
+}
+
+void
+playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
+		    PlayerControl &pc)
+{
+	playlist_state_save_settings(os, playlist, pc);
+
 	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_BEGIN "\n");
 	queue_save(os, playlist.queue);
 	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_END "\n");
 }
 
+void
+playlist_state_save_changes(BufferedOutputStream &os,
+			    const struct playlist &playlist,
+			    PlayerControl &pc,
+			    uint32_t queue_version)
+{
+	playlist_state_save_settings(os, playlist, pc);
+
+	os.Format(PLAYLIST_STATE_FILE_PLAYLIST_CHANGES "%u\n",
+		  playlist.queue.GetLength());
+	queue_save_changes(os, playlist.queue, queue_version);
+	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_END "\n");
+}
+
+/**
+ * Load songs until #PLAYLIST_STATE_FILE_PLAYLIST_END.
+ *
+ * @param changes true if the songs were written by
+ * queue_save_changes()
+ */
 static void
-playlist_state_load(TextFile &file, const SongLoader &song_loader,
-		    struct playlist &playlist)
+playlist_state_load(TextFile &file, SavedQueue &queue, bool changes)
 {
 	const char *line = file.ReadLine();
 	if (line == nullptr) {
@@ -112,7 +144,10 @@ playlist_state_load(TextFile &file, const SongLoader &song_loader,
 	}
 
 	while (!StringStartsWith(line, PLAYLIST_STATE_FILE_PLAYLIST_END)) {
-		queue_load_song(file, song_loader, line, playlist.queue);
+		if (changes)
+			queue.LoadChangedSong(file, line);
+		else
+			queue.LoadSong(file, line);
 
 		line = file.ReadLine();
 		if (line == nullptr) {
@@ -122,60 +157,79 @@ playlist_state_load(TextFile &file, const SongLoader &song_loader,
 			break;
 		}
 	}
+}
 
-	playlist.queue.IncrementVersion();
+static PlayerState
+ParsePlayerState(const char *s) noexcept
+{
+	if (strcmp(s, PLAYLIST_STATE_FILE_STATE_PLAY) == 0)
+		return PlayerState::PLAY;
+	else if (strcmp(s, PLAYLIST_STATE_FILE_STATE_PAUSE) == 0)
+		return PlayerState::PAUSE;
+	else
+		return PlayerState::STOP;
 }
 
 bool
-playlist_state_restore(const StateFileConfig &config,
-		       const char *line, TextFile &file,
-		       const SongLoader &song_loader,
-		       struct playlist &playlist, PlayerControl &pc)
+PlaylistStateLoader::ReadLine(const char *line, TextFile &file,
+			      struct playlist &playlist, PlayerControl &pc)
 {
-	int current = -1;
-	SongTime seek_time = SongTime::zero();
-	bool random_mode = false;
+	const char *p;
+	if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_STATE))) {
+		found = true;
+		state = ParsePlayerState(p);
 
-	line = StringAfterPrefix(line, PLAYLIST_STATE_FILE_STATE);
-	if (line == nullptr)
+		/* these are omitted if they are unset; reset them
+		   to override previous records */
+		current = -1;
+		seek_time = SongTime::zero();
+	} else if (!found) {
+		/* the playlist state always begins with "state:" */
+		return false;
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_TIME))) {
+		seek_time = SongTime::FromS(ParseDouble(p));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_REPEAT))) {
+		playlist.SetRepeat(pc, StringIsEqual(p, "1"));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_SINGLE))) {
+		playlist.SetSingle(pc, SingleFromString(p));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_CONSUME))) {
+		playlist.SetConsume(StringIsEqual(p, "1"));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_CROSSFADE))) {
+		pc.SetCrossFade(FloatDuration(atoi(p)));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_MIXRAMPDB))) {
+		pc.SetMixRampDb(ParseFloat(p));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_MIXRAMPDELAY))) {
+		/* this check discards "nan" which was used
+		   prior to MPD 0.18 */
+		if (IsDigitASCII(*p))
+			pc.SetMixRampDelay(FloatDuration(ParseFloat(p)));
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_RANDOM))) {
+		random_mode = StringIsEqual(p, "1");
+	} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_CURRENT))) {
+		current = atoi(p);
+	} else if (StringStartsWith(line,
+				    PLAYLIST_STATE_FILE_PLAYLIST_BEGIN)) {
+		queue.clear();
+		playlist_state_load(file, queue, false);
+	} else if ((p = StringAfterPrefix(line,
+					  PLAYLIST_STATE_FILE_PLAYLIST_CHANGES))) {
+		queue.Resize(ParseUnsigned(p));
+		playlist_state_load(file, queue, true);
+	} else
 		return false;
 
-	PlayerState state;
-	if (strcmp(line, PLAYLIST_STATE_FILE_STATE_PLAY) == 0)
-		state = PlayerState::PLAY;
-	else if (strcmp(line, PLAYLIST_STATE_FILE_STATE_PAUSE) == 0)
-		state = PlayerState::PAUSE;
-	else
-		state = PlayerState::STOP;
-
-	while ((line = file.ReadLine()) != nullptr) {
-		const char *p;
-		if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_TIME))) {
-			seek_time = SongTime::FromS(ParseDouble(p));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_REPEAT))) {
-			playlist.SetRepeat(pc, StringIsEqual(p, "1"));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_SINGLE))) {
-			playlist.SetSingle(pc, SingleFromString(p));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_CONSUME))) {
-			playlist.SetConsume(StringIsEqual(p, "1"));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_CROSSFADE))) {
-			pc.SetCrossFade(FloatDuration(atoi(p)));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_MIXRAMPDB))) {
-			pc.SetMixRampDb(ParseFloat(p));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_MIXRAMPDELAY))) {
-			/* this check discards "nan" which was used
-			   prior to MPD 0.18 */
-			if (IsDigitASCII(*p))
-				pc.SetMixRampDelay(FloatDuration(ParseFloat(p)));
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_RANDOM))) {
-			random_mode = StringIsEqual(p, "1");
-		} else if ((p = StringAfterPrefix(line, PLAYLIST_STATE_FILE_CURRENT))) {
-			current = atoi(p);
-		} else if (StringStartsWith(line,
-					    PLAYLIST_STATE_FILE_PLAYLIST_BEGIN)) {
-			playlist_state_load(file, song_loader, playlist);
-		}
-	}
+	return true;
+}
+
+void
+PlaylistStateLoader::Finish(const StateFileConfig &config,
+			    struct playlist &playlist, PlayerControl &pc)
+{
+	if (!found)
+		return;
+
+	current = queue.Apply(playlist.queue, current);
+	playlist.queue.IncrementVersion();
 
 	playlist.SetRandom(pc, random_mode);
 
@@ -215,8 +269,6 @@ playlist_state_restore(const StateFileConfig &config,
 		if (state == PlayerState::PAUSE)
 			pc.LockPause();
 	}
-
-	return true;
 }
 
 unsigned
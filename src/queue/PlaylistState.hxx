@@ -25,22 +25,74 @@
 #ifndef MPD_PLAYLIST_STATE_HXX
 #define MPD_PLAYLIST_STATE_HXX
 
+#include "QueueSave.hxx"
+#include "Chrono.hxx"
+
+#include <cstdint>
+
+enum class PlayerState : uint8_t;
 struct StateFileConfig;
 struct playlist;
 class PlayerControl;
 class TextFile;
 class BufferedOutputStream;
-class SongLoader;
 
 void
 playlist_state_save(BufferedOutputStream &os, const playlist &playlist,
 		    PlayerControl &pc);
 
-bool
-playlist_state_restore(const StateFileConfig &config,
-		       const char *line, TextFile &file,
-		       const SongLoader &song_loader,
-		       playlist &playlist, PlayerControl &pc);
+/**
+ * Like playlist_state_save(), but write only the queue changes since
+ * the given queue version.  The result is meant to be appended to a
+ * state file which already contains the older state.
+ */
+void
+playlist_state_save_changes(BufferedOutputStream &os,
+			    const playlist &playlist, PlayerControl &pc,
+			    uint32_t queue_version);
+
+/**
+ * Restores the playlist state from the state file.  The state file
+ * may contain more than one record (see
+ * playlist_state_save_changes()), and later values override earlier
+ * ones; therefore nothing which depends on the queue is applied
+ * before Finish() is called at the end of the file.
+ */
+class PlaylistStateLoader {
+	SavedQueue queue;
+
+	PlayerState state;
+
+	int current = -1;
+
+	SongTime seek_time = SongTime::zero();
+
+	bool random_mode = false;
+
+	/**
+	 * Was a playlist state found in the state file?
+	 */
+	bool found = false;
+
+public:
+	/**
+	 * Parse one line of the state file (and possibly subsequent
+	 * lines belonging to it).
+	 *
+	 * Throws on error.
+	 *
+	 * @return false if the line was not recognized
+	 */
+	bool ReadLine(const char *line, TextFile &file,
+		      playlist &playlist, PlayerControl &pc);
+
+	/**
+	 * Fill the queue and restore the player state.  The songs are
+	 * not resolved yet; see SavedQueue::Apply().
+	 */
+	void Finish(const StateFileConfig &config,
+		    playlist &playlist, PlayerControl &pc);
+};
 
 /**
  * Generates a hash number for the current state of the playlist and
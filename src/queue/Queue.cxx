@@ -90,6 +90,7 @@ Queue::Append(DetachedSong &&song, uint8_t priority) noexcept
 	item.id = id;
 	item.version = version;
 	item.priority = priority;
+	item.unresolved = false;
 
 	order[position] = position;
 
@@ -235,6 +236,9 @@ Queue::DeletePosition(unsigned position) noexcept
 
 	delete items[position].song;
 
+	if (items[position].unresolved)
+		--n_unresolved;
+
 	const unsigned id = PositionToId(position);
 	const unsigned _order = PositionToOrder(position);
 
@@ -273,6 +277,7 @@ Queue::Clear() noexcept
 	}
 
 	length = 0;
+	n_unresolved = 0;
 }
 
 static void
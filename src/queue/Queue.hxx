@@ -67,6 +67,15 @@ struct Queue {
 		 * "random" mode.
 		 */
 		uint8_t priority;
+
+		/**
+		 * Was this song restored (e.g. from the state file)
+		 * without looking it up in the database?  Its tags
+		 * may be missing, and it must be resolved with
+		 * playlist_check_translate_song() before it can be
+		 * played.
+		 */
+		bool unresolved;
 	};
 
 	/** configured maximum length of the queue */
@@ -78,6 +87,9 @@ struct Queue {
 	/** the current version number */
 	uint32_t version = 1;
 
+	/** number of songs with Item::unresolved */
+	unsigned n_unresolved = 0;
+
 	/** all songs in "position" order */
 	Item *const items;
 
@@ -220,6 +232,31 @@ struct Queue {
 			items[position].version == 0;
 	}
 
+	bool HasUnresolved() const noexcept {
+		return n_unresolved > 0;
+	}
+
+	bool IsUnresolvedAtPosition(unsigned position) const noexcept {
+		assert(position < length);
+
+		return items[position].unresolved;
+	}
+
+	void SetUnresolvedAtPosition(unsigned position,
+				     bool unresolved) noexcept {
+		assert(position < length);
+
+		auto &item = items[position];
+		if (item.unresolved == unresolved)
+			return;
+
+		item.unresolved = unresolved;
+		if (unresolved)
+			++n_unresolved;
+		else
+			--n_unresolved;
+	}
+
 	/**
 	 * Returns the order number following the specified one.  This takes
 	 * end of queue and "repeat" mode into account.
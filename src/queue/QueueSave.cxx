@@ -22,17 +22,17 @@
 #include "PlaylistError.hxx"
 #include "song/DetachedSong.hxx"
 #include "SongSave.hxx"
-#include "playlist/PlaylistSong.hxx"
 #include "fs/io/TextFile.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
 #include "util/StringCompare.hxx"
 #include "Log.hxx"
 
-#include <exception>
+#include <stdexcept>
 
 #include <stdlib.h>
 
 #define PRIO_LABEL "Prio: "
+#define POSITION_LABEL "Pos: "
 
 static void
 queue_save_database_song(BufferedOutputStream &os,
@@ -47,11 +47,20 @@ queue_save_full_song(BufferedOutputStream &os, const DetachedSong &song)
 	song_save(os, song);
 }
 
+/**
+ * Can this song be saved in the brief format (just the URI)?
+ */
+static bool
+IsBriefSong(const DetachedSong &song) noexcept
+{
+	return song.IsInDatabase() &&
+		song.GetStartTime().IsZero() && song.GetEndTime().IsZero();
+}
+
 static void
 queue_save_song(BufferedOutputStream &os, int idx, const DetachedSong &song)
 {
-	if (song.IsInDatabase() &&
-	    song.GetStartTime().IsZero() && song.GetEndTime().IsZero())
+	if (IsBriefSong(song))
 		/* use the brief format (just the URI) for "full"
 		   database songs */
 		queue_save_database_song(os, idx, song);
@@ -73,47 +82,157 @@ queue_save(BufferedOutputStream &os, const Queue &queue)
 	}
 }
 
-static DetachedSong
-LoadQueueSong(TextFile &file, const char *line)
+unsigned
+queue_count_changes(const Queue &queue, uint32_t version) noexcept
+{
+	unsigned n = 0;
+	for (unsigned i = 0; i < queue.GetLength(); i++)
+		if (queue.IsNewerAtPosition(i, version))
+			++n;
+
+	return n;
+}
+
+void
+queue_save_changes(BufferedOutputStream &os, const Queue &queue,
+		   uint32_t version)
+{
+	for (unsigned i = 0; i < queue.GetLength(); i++) {
+		if (!queue.IsNewerAtPosition(i, version))
+			continue;
+
+		uint8_t prio = queue.GetPriorityAtPosition(i);
+		if (prio != 0)
+			os.Format(PRIO_LABEL "%u\n", prio);
+
+		const auto &song = queue.Get(i);
+		if (!IsBriefSong(song))
+			/* the long format doesn't contain the
+			   position */
+			os.Format(POSITION_LABEL "%u\n", i);
+
+		queue_save_song(os, i, song);
+	}
+}
+
+static unsigned
+ParseQueuePosition(const char *s, char **endptr_r)
 {
-	std::unique_ptr<DetachedSong> song;
+	long ret = strtol(s, endptr_r, 10);
+	if (ret < 0 || *endptr_r == s)
+		throw std::runtime_error("Malformed playlist line in state file");
+
+	return ret;
+}
 
+static DetachedSong
+LoadQueueSong(TextFile &file, const char *line, unsigned *position_r)
+{
 	if (const char *p = StringAfterPrefix(line, SONG_BEGIN)) {
 		const char *uri = p;
 		return song_load(file, uri);
 	} else {
 		char *endptr;
-		long ret = strtol(line, &endptr, 10);
-		if (ret < 0 || *endptr != ':' || endptr[1] == 0)
+		unsigned position = ParseQueuePosition(line, &endptr);
+		if (*endptr != ':' || endptr[1] == 0)
 			throw std::runtime_error("Malformed playlist line in state file");
 
+		if (position_r != nullptr)
+			*position_r = position;
+
 		const char *uri = endptr + 1;
 
 		return DetachedSong(uri);
 	}
 }
 
+/**
+ * Parse the optional priority line preceding a song.
+ *
+ * @return the line after the priority or nullptr on end of file
+ */
+static const char *
+LoadQueuePriority(TextFile &file, const char *line, uint8_t &priority)
+{
+	const char *p;
+	if ((p = StringAfterPrefix(line, PRIO_LABEL))) {
+		priority = strtoul(p, nullptr, 10);
+		line = file.ReadLine();
+	}
+
+	return line;
+}
+
+void
+SavedQueue::Resize(unsigned length)
+{
+	items.resize(length);
+}
+
 void
-queue_load_song(TextFile &file, const SongLoader &loader,
-		const char *line, Queue &queue)
+SavedQueue::LoadSong(TextFile &file, const char *line)
 {
-	if (queue.IsFull())
+	uint8_t priority = 0;
+	line = LoadQueuePriority(file, line, priority);
+	if (line == nullptr)
 		return;
 
+	auto song = LoadQueueSong(file, line, nullptr);
+
+	auto &item = items.emplace_back();
+	item.song.emplace(std::move(song));
+	item.priority = priority;
+}
+
+void
+SavedQueue::LoadChangedSong(TextFile &file, const char *line)
+{
 	uint8_t priority = 0;
-	const char *p;
-	if ((p = StringAfterPrefix(line, PRIO_LABEL))) {
-		priority = strtoul(p, nullptr, 10);
+	line = LoadQueuePriority(file, line, priority);
+	if (line == nullptr)
+		return;
+
+	/* a long-format song without position is appended */
+	unsigned position = items.size();
+	if (const char *p = StringAfterPrefix(line, POSITION_LABEL)) {
+		char *endptr;
+		position = ParseQueuePosition(p, &endptr);
 
 		line = file.ReadLine();
-		if (line == nullptr)
-			return;
+		if (line == nullptr || !StringStartsWith(line, SONG_BEGIN))
+			throw std::runtime_error("Malformed playlist line in state file");
 	}
 
-	auto song = LoadQueueSong(file, line);
+	auto song = LoadQueueSong(file, line, &position);
 
-	if (!playlist_check_translate_song(song, {}, loader))
-		return;
+	/* the queue length was written before the changes, but be
+	   tolerant with broken files */
+	if (position >= items.size())
+		items.resize(position + 1);
+
+	auto &item = items[position];
+	item.song.emplace(std::move(song));
+	item.priority = priority;
+}
+
+int
+SavedQueue::Apply(Queue &queue, int current) noexcept
+{
+	int result = -1;
+
+	for (unsigned i = 0; i < items.size() && !queue.IsFull(); ++i) {
+		auto &item = items[i];
+		if (!item.song)
+			continue;
+
+		queue.Append(std::move(*item.song), item.priority);
+
+		const unsigned position = queue.GetLength() - 1;
+		queue.SetUnresolvedAtPosition(position, true);
+		if (int(i) == current)
+			result = position;
+	}
 
-	queue.Append(std::move(song), priority);
+	items.clear();
+	return result;
 }
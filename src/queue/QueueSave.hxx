@@ -25,21 +25,94 @@
 #ifndef MPD_QUEUE_SAVE_HXX
 #define MPD_QUEUE_SAVE_HXX
 
+#include "song/DetachedSong.hxx"
+#include "util/Compiler.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 struct Queue;
 class BufferedOutputStream;
 class TextFile;
-class SongLoader;
 
 void
 queue_save(BufferedOutputStream &os, const Queue &queue);
 
 /**
- * Loads one song from the state file and appends it to the queue.
- *
- * Throws on error.
+ * Count the songs which were added or modified since the given queue
+ * version, i.e. the ones queue_save_changes() would write.
+ */
+gcc_pure
+unsigned
+queue_count_changes(const Queue &queue, uint32_t version) noexcept;
+
+/**
+ * Save only the songs which were added or modified since the given
+ * queue version, each with its position.  Together with the new queue
+ * length, this is enough to reconstruct the queue from a previous
+ * queue_save() (just like the "plchanges" command).
  */
 void
-queue_load_song(TextFile &file, const SongLoader &loader,
-		const char *line, Queue &queue);
+queue_save_changes(BufferedOutputStream &os, const Queue &queue,
+		   uint32_t version);
+
+/**
+ * A queue being loaded from the state file.  The songs are indexed
+ * by their position in the saved queue, because records written by
+ * queue_save_changes() refer to those positions.  Nothing is added
+ * to the #Queue before Apply() is called.
+ */
+class SavedQueue {
+	struct Item {
+		std::optional<DetachedSong> song;
+		uint8_t priority = 0;
+	};
+
+	std::vector<Item> items;
+
+public:
+	bool empty() const noexcept {
+		return items.empty();
+	}
+
+	void clear() noexcept {
+		items.clear();
+	}
+
+	/**
+	 * Truncate or extend the saved queue.  New positions are
+	 * empty until a song is loaded into them.
+	 */
+	void Resize(unsigned length);
+
+	/**
+	 * Loads one song written by queue_save() and appends it.
+	 *
+	 * Throws on error.
+	 */
+	void LoadSong(TextFile &file, const char *line);
+
+	/**
+	 * Loads one song written by queue_save_changes() and stores
+	 * it at its position.
+	 *
+	 * Throws on error.
+	 */
+	void LoadChangedSong(TextFile &file, const char *line);
+
+	/**
+	 * Append all songs to the #Queue.  They are not looked up
+	 * (which may be expensive with a large queue and a remote
+	 * database); instead, they are marked "unresolved", and the
+	 * caller is responsible for resolving them later, see
+	 * playlist::ResolveSongs().
+	 *
+	 * @param current a position in the saved queue
+	 * @return the new position of the song at #current or -1 if
+	 * there is none
+	 */
+	int Apply(Queue &queue, int current) noexcept;
+};
 
 #endif
@@ -25,6 +25,7 @@
 #include "TagSongFilter.hxx"
 #include "ModifiedSinceSongFilter.hxx"
 #include "AudioFormatSongFilter.hxx"
+#include "StickerSongFilter.hxx"
 #include "pcm/AudioParser.hxx"
 #include "tag/ParseName.hxx"
 #include "time/ISO8601.hxx"
@@ -194,6 +195,29 @@ ExpectQuoted(const char *&s)
 	return {buffer, length};
 }
 
+static constexpr bool
+IsStickerNameChar(char ch) noexcept
+{
+	return !IsWhitespaceOrNull(ch) && !IsQuote(ch) &&
+		ch != '(' && ch != ')' &&
+		ch != '=' && ch != '!' && ch != '<' && ch != '>';
+}
+
+static std::string
+ExpectStickerName(const char *&s)
+{
+	const char *begin = s;
+	while (IsStickerNameChar(*s))
+		++s;
+
+	if (s == begin)
+		throw std::runtime_error("Sticker name expected");
+
+	std::string name(begin, s);
+	s = StripLeft(s);
+	return name;
+}
+
 /**
  * Parse a string operator and its second operand and convert it to a
  * #StringFilter.
@@ -291,6 +315,20 @@ SongFilter::ParseExpression(const char *&s, bool fold_case)
 		return std::make_unique<NotSongFilter>(std::move(inner));
 	}
 
+	if (const char *after_sticker = StringAfterPrefix(s, "sticker:")) {
+		s = after_sticker;
+		auto name = ExpectStickerName(s);
+		const auto op = ParseStickerSongFilterOperator(s);
+		auto value = ExpectQuoted(s);
+		if (*s != ')')
+			throw std::runtime_error("')' expected");
+		s = StripLeft(s + 1);
+
+		return std::make_unique<StickerSongFilter>(std::move(name),
+							   op,
+							   std::move(value));
+	}
+
 	auto type = ExpectFilterType(s);
 
 	if (type == LOCATE_TAG_MODIFIED_SINCE) {
@@ -464,6 +502,28 @@ SongFilter::GetBase() const noexcept
 	return nullptr;
 }
 
+static void
+CollectStickerFilters(std::forward_list<StickerSongFilter *> &dest,
+		      ISongFilter &f)
+{
+	if (auto *sf = dynamic_cast<StickerSongFilter *>(&f))
+		dest.push_front(sf);
+	else if (auto *af = dynamic_cast<AndSongFilter *>(&f)) {
+		for (const auto &i : af->GetItems())
+			CollectStickerFilters(dest, *i);
+	} else if (auto *nf = dynamic_cast<NotSongFilter *>(&f))
+		CollectStickerFilters(dest, *nf->GetChild());
+}
+
+std::forward_list<StickerSongFilter *>
+SongFilter::GetStickerFilters() const
+{
+	std::forward_list<StickerSongFilter *> result;
+	for (const auto &i : and_filter.GetItems())
+		CollectStickerFilters(result, *i);
+	return result;
+}
+
 SongFilter
 SongFilter::WithoutBasePrefix(const std::string_view prefix) const noexcept
 {
@@ -491,5 +551,10 @@ SongFilter::WithoutBasePrefix(const std::string_view prefix) const noexcept
 		result.and_filter.AddItem(i->Clone());
 	}
 
+	/* the sticker values are indexed by the URI within MPD's
+	   VFS */
+	for (auto *i : result.GetStickerFilters())
+		i->AddUriPrefix(prefix);
+
 	return result;
 }
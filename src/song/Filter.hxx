@@ -24,6 +24,7 @@
 #include "util/Compiler.h"
 
 #include <cstdint>
+#include <forward_list>
 #include <string>
 #include <string_view>
 
@@ -35,6 +36,7 @@
 template<typename T> struct ConstBuffer;
 enum TagType : uint8_t;
 struct LightSong;
+class StickerSongFilter;
 
 class SongFilter {
 	AndSongFilter and_filter;
@@ -103,10 +105,18 @@ public:
 
 	/**
 	 * Create a copy of the filter with the given prefix stripped
-	 * from all #LOCATE_TAG_BASE_TYPE items.  This is used to
-	 * filter songs in mounted databases.
+	 * from all #LOCATE_TAG_BASE_TYPE items (and added to the
+	 * URIs looked up by #StickerSongFilter items).  This is used
+	 * to filter songs in mounted databases.
 	 */
 	SongFilter WithoutBasePrefix(std::string_view prefix) const noexcept;
+
+	/**
+	 * Collect all #StickerSongFilter items, including nested
+	 * ones.  The caller must load their values before calling
+	 * Match().
+	 */
+	std::forward_list<StickerSongFilter *> GetStickerFilters() const;
 };
 
 #endif
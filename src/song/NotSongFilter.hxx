@@ -35,6 +35,10 @@ public:
 	explicit NotSongFilter(C &&_child) noexcept
 		:child(std::forward<C>(_child)) {}
 
+	const ISongFilterPtr &GetChild() const noexcept {
+		return child;
+	}
+
 	/* virtual methods from ISongFilter */
 	ISongFilterPtr Clone() const noexcept override {
 		return std::make_unique<NotSongFilter>(child->Clone());
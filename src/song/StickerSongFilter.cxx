@@ -0,0 +1,178 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "StickerSongFilter.hxx"
+#include "Escape.hxx"
+#include "LightSong.hxx"
+#include "util/Compiler.h"
+#include "util/StringStrip.hxx"
+
+#include <cassert>
+#include <stdexcept>
+
+#include <string.h>
+
+static constexpr struct {
+	const char *symbol;
+	StickerSongFilter::Operator op;
+} sticker_operators[] = {
+	/* two-character operators first, because they share a
+	   prefix with the single-character ones */
+	{ "==", StickerSongFilter::Operator::EQUALS },
+	{ "!=", StickerSongFilter::Operator::NOT_EQUALS },
+	{ "<=", StickerSongFilter::Operator::LESS_EQUALS },
+	{ ">=", StickerSongFilter::Operator::GREATER_EQUALS },
+	{ "<", StickerSongFilter::Operator::LESS_THAN },
+	{ ">", StickerSongFilter::Operator::GREATER_THAN },
+};
+
+static const char *
+ToString(StickerSongFilter::Operator op) noexcept
+{
+	for (const auto &i : sticker_operators)
+		if (i.op == op)
+			return i.symbol;
+
+	assert(false);
+	gcc_unreachable();
+}
+
+StickerSongFilter::Operator
+ParseStickerSongFilterOperator(const char *&s)
+{
+	for (const auto &i : sticker_operators) {
+		const std::size_t length = strlen(i.symbol);
+		if (strncmp(s, i.symbol, length) == 0) {
+			s = StripLeft(s + length);
+			return i.op;
+		}
+	}
+
+	throw std::runtime_error("Sticker comparison operator expected");
+}
+
+std::string
+StickerSongFilter::ToExpression() const noexcept
+{
+	return "(sticker:" + name + " " + ToString(op) + " \""
+		+ EscapeFilterString(value) + "\")";
+}
+
+void
+StickerSongFilter::AddUriPrefix(std::string_view prefix) noexcept
+{
+	if (prefix.empty())
+		return;
+
+	if (!uri_prefix.empty())
+		uri_prefix.push_back('/');
+	uri_prefix.append(prefix);
+}
+
+/**
+ * Join the URI prefix (if not empty), the directory (if not nullptr)
+ * and the song URI with slashes into the given buffer, like
+ * LightSong::GetURI() does.
+ *
+ * @return the URI or a null std::string_view if the buffer is too
+ * small
+ */
+static std::string_view
+JoinUri(char *buffer, std::size_t size, std::string_view prefix,
+	const char *directory, const char *uri) noexcept
+{
+	std::size_t length = 0;
+	bool first = true;
+	const auto append = [&](std::string_view segment){
+		if (!first) {
+			if (length >= size)
+				return false;
+			buffer[length++] = '/';
+		}
+
+		first = false;
+
+		if (segment.size() > size - length)
+			return false;
+
+		memcpy(buffer + length, segment.data(), segment.size());
+		length += segment.size();
+		return true;
+	};
+
+	if ((!prefix.empty() && !append(prefix)) ||
+	    (directory != nullptr && !append(directory)) ||
+	    !append(uri))
+		return {};
+
+	return {buffer, length};
+}
+
+bool
+StickerSongFilter::Match(const LightSong &song) const noexcept
+{
+	if (values == nullptr)
+		return false;
+
+	/* build the key in a stack buffer; this is called for each
+	   song in the database, and a heap allocation for each of
+	   them would be expensive */
+	char buffer[4096];
+	std::string_view key = JoinUri(buffer, sizeof(buffer), uri_prefix,
+				       song.directory, song.uri);
+
+	std::string fallback;
+	if (key.data() == nullptr) {
+		/* too long for the buffer */
+		fallback = song.GetURI();
+		if (!uri_prefix.empty())
+			fallback = uri_prefix + "/" + fallback;
+		key = fallback;
+	}
+
+	const auto i = values->find(key);
+	if (i == values->end())
+		/* songs without this sticker never match */
+		return false;
+
+	const int cmp = i->second.compare(value);
+
+	switch (op) {
+	case Operator::EQUALS:
+		return cmp == 0;
+
+	case Operator::NOT_EQUALS:
+		return cmp != 0;
+
+	case Operator::LESS_THAN:
+		return cmp < 0;
+
+	case Operator::LESS_EQUALS:
+		return cmp <= 0;
+
+	case Operator::GREATER_THAN:
+		return cmp > 0;
+
+	case Operator::GREATER_EQUALS:
+		return cmp >= 0;
+	}
+
+	assert(false);
+	gcc_unreachable();
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_STICKER_SONG_FILTER_HXX
+#define MPD_STICKER_SONG_FILTER_HXX
+
+#include "ISongFilter.hxx"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * Matches songs by the value of a song sticker, e.g. "(sticker:rating
+ * >= "4")".  Values are compared as strings, just like "sticker
+ * find" does.
+ *
+ * This library does not access the sticker database.  Before Match()
+ * is called, the caller must load all values of this sticker name
+ * with SetValues(); this makes a search a single pass over the song
+ * database instead of one sticker lookup per song.
+ */
+class StickerSongFilter final : public ISongFilter {
+public:
+	enum class Operator {
+		EQUALS,
+		NOT_EQUALS,
+		LESS_THAN,
+		LESS_EQUALS,
+		GREATER_THAN,
+		GREATER_EQUALS,
+	};
+
+	/**
+	 * Sticker values indexed by song URI.
+	 */
+	using Values = std::map<std::string, std::string, std::less<>>;
+
+private:
+	std::string name;
+
+	Operator op;
+
+	std::string value;
+
+	/**
+	 * Shared between clones.  nullptr if SetValues() has not
+	 * been called; nothing matches then.
+	 */
+	std::shared_ptr<const Values> values;
+
+	/**
+	 * The location of the (mounted) database whose songs are
+	 * matched; it is prepended to their URIs before looking them
+	 * up in #values.  Empty for the root database.
+	 */
+	std::string uri_prefix;
+
+public:
+	template<typename N, typename V>
+	StickerSongFilter(N &&_name, Operator _op, V &&_value) noexcept
+		:name(std::forward<N>(_name)), op(_op),
+		 value(std::forward<V>(_value)) {}
+
+	const std::string &GetName() const noexcept {
+		return name;
+	}
+
+	void SetValues(std::shared_ptr<const Values> _values) noexcept {
+		values = std::move(_values);
+	}
+
+	/**
+	 * Match songs of a database mounted at the given location
+	 * (relative to the current #uri_prefix).
+	 */
+	void AddUriPrefix(std::string_view prefix) noexcept;
+
+	/* virtual methods from ISongFilter */
+	ISongFilterPtr Clone() const noexcept override {
+		return std::make_unique<StickerSongFilter>(*this);
+	}
+
+	std::string ToExpression() const noexcept override;
+	bool Match(const LightSong &song) const noexcept override;
+};
+
+/**
+ * Parse the operator of a #StickerSongFilter expression and advance
+ * the pointer.
+ *
+ * Throws on error.
+ */
+StickerSongFilter::Operator
+ParseStickerSongFilterOperator(const char *&s);
+
+#endif
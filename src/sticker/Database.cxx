@@ -22,17 +22,27 @@
 #include "lib/sqlite/Util.hxx"
 #include "fs/Path.hxx"
 #include "Idle.hxx"
+#include "util/Domain.hxx"
 #include "util/StringCompare.hxx"
 #include "util/ScopeExit.hxx"
+#include "Log.hxx"
 
 #include <cassert>
 #include <iterator>
 
 using namespace Sqlite;
 
+static constexpr Domain sticker_domain("sticker");
+
+/**
+ * The maximum time between a write and its commit.
+ */
+static constexpr Event::Duration COMMIT_DELAY = std::chrono::seconds(1);
+
 enum sticker_sql {
 	STICKER_SQL_GET,
 	STICKER_SQL_LIST,
+	STICKER_SQL_LIST_NAME,
 	STICKER_SQL_UPDATE,
 	STICKER_SQL_INSERT,
 	STICKER_SQL_DELETE,
@@ -49,6 +59,8 @@ static const char *const sticker_sql[] = {
 	"SELECT value FROM sticker WHERE type=? AND uri=? AND name=?",
 	//[STICKER_SQL_LIST] =
 	"SELECT name,value FROM sticker WHERE type=? AND uri=?",
+	//[STICKER_SQL_LIST_NAME] =
+	"SELECT uri,value FROM sticker WHERE type=? AND name=?",
 	//[STICKER_SQL_UPDATE] =
 	"UPDATE sticker SET value=? WHERE type=? AND uri=? AND name=?",
 	//[STICKER_SQL_INSERT] =
@@ -58,16 +70,16 @@ static const char *const sticker_sql[] = {
 	//[STICKER_SQL_DELETE_VALUE] =
 	"DELETE FROM sticker WHERE type=? AND uri=? AND name=?",
 	//[STICKER_SQL_FIND] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=?",
 
 	//[STICKER_SQL_FIND_VALUE] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=? AND value=?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=? AND value=?",
 
 	//[STICKER_SQL_FIND_LT] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=? AND value<?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=? AND value<?",
 
 	//[STICKER_SQL_FIND_GT] =
-	"SELECT uri,value FROM sticker WHERE type=? AND uri LIKE (? || '%') AND name=? AND value>?",
+	"SELECT uri,value FROM sticker WHERE type=? AND uri>=? AND uri<? AND name=? AND value>?",
 };
 
 static const char sticker_sql_create[] =
@@ -79,10 +91,13 @@ static const char sticker_sql_create[] =
 	");"
 	"CREATE UNIQUE INDEX IF NOT EXISTS"
 	" sticker_value ON sticker(type, uri, name);"
+	"CREATE INDEX IF NOT EXISTS"
+	" sticker_name ON sticker(type, name);"
 	"";
 
-StickerDatabase::StickerDatabase(Path path)
-	:db(path.c_str())
+StickerDatabase::StickerDatabase(EventLoop &event_loop, Path path)
+	:db(path.c_str()),
+	 commit_timer(event_loop, BIND_THIS_METHOD(OnCommitTimer))
 {
 	assert(!path.IsNull());
 
@@ -109,6 +124,12 @@ StickerDatabase::~StickerDatabase() noexcept
 {
 	assert(db != nullptr);
 
+	try {
+		Commit();
+	} catch (...) {
+		LogError(std::current_exception());
+	}
+
 	for (unsigned i = 0; i < std::size(stmt); ++i) {
 		assert(stmt[i] != nullptr);
 
@@ -116,6 +137,109 @@ StickerDatabase::~StickerDatabase() noexcept
 	}
 }
 
+void
+StickerDatabase::Commit()
+{
+	commit_timer.Cancel();
+
+	if (!in_transaction)
+		return;
+
+	int ret = sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+	if (ret != SQLITE_OK) {
+		/* if SQLite has rolled back the transaction, there
+		   is nothing left to commit */
+		in_transaction = sqlite3_get_autocommit(db) == 0;
+		throw SqliteError(db, ret, "Failed to commit sticker changes");
+	}
+
+	in_transaction = false;
+}
+
+void
+StickerDatabase::BeginWrite()
+{
+	if (in_transaction)
+		return;
+
+	int ret = sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+	if (ret != SQLITE_OK)
+		throw SqliteError(db, ret, "Failed to begin transaction");
+
+	in_transaction = true;
+	commit_timer.Schedule(COMMIT_DELAY);
+}
+
+void
+StickerDatabase::OnCommitTimer() noexcept
+{
+	try {
+		Commit();
+	} catch (...) {
+		LogError(std::current_exception());
+
+		if (in_transaction)
+			/* try again later */
+			commit_timer.Schedule(COMMIT_DELAY);
+	}
+}
+
+static std::string
+MakeCacheKey(const char *type, const char *name) noexcept
+{
+	std::string key(type);
+	key.push_back('\n');
+	key.append(name);
+	return key;
+}
+
+StickerDatabase::CachedName *
+StickerDatabase::LookupCachedName(const char *type, const char *name) noexcept
+try {
+	return name_cache.Lookup(MakeCacheKey(type, name));
+} catch (...) {
+	/* out of memory - ignore, this is just a cache */
+	return nullptr;
+}
+
+const StickerDatabase::CachedName *
+StickerDatabase::LoadCachedName(const char *type, const char *name)
+{
+	auto key = MakeCacheKey(type, name);
+	const auto *cached = name_cache.Lookup(key);
+	if (cached != nullptr)
+		return cached->complete ? cached : nullptr;
+
+	sqlite3_stmt *const s = stmt[STICKER_SQL_LIST_NAME];
+
+	BindAll(s, type, name);
+
+	AtScopeExit(s) {
+		sqlite3_reset(s);
+		sqlite3_clear_bindings(s);
+	};
+
+	CachedName item{{}, true};
+	while (ExecuteRow(s)) {
+		if (item.values.size() >= MAX_CACHED_VALUES) {
+			/* too large; remember that, so we don't
+			   try again */
+			item.values.clear();
+			item.complete = false;
+			break;
+		}
+
+		item.values.emplace((const char *)sqlite3_column_text(s, 0),
+				    (const char *)sqlite3_column_text(s, 1));
+	}
+
+	name_cache.Store(std::move(key), std::move(item));
+
+	cached = name_cache.Lookup(MakeCacheKey(type, name));
+	assert(cached != nullptr);
+	return cached->complete ? cached : nullptr;
+}
+
 std::string
 StickerDatabase::LoadValue(const char *type, const char *uri, const char *name)
 {
@@ -128,6 +252,14 @@ StickerDatabase::LoadValue(const char *type, const char *uri, const char *name)
 	if (StringIsEmpty(name))
 		return std::string();
 
+	if (const auto *cached = LookupCachedName(type, name);
+	    cached != nullptr && cached->complete) {
+		auto i = cached->values.find(std::string_view(uri));
+		return i != cached->values.end()
+			? i->second
+			: std::string();
+	}
+
 	BindAll(s, type, uri, name);
 
 	AtScopeExit(s) {
@@ -177,6 +309,8 @@ StickerDatabase::UpdateValue(const char *type, const char *uri,
 	assert(*name != 0);
 	assert(value != nullptr);
 
+	BeginWrite();
+
 	BindAll(s, value, type, uri, name);
 
 	AtScopeExit(s) {
@@ -203,6 +337,8 @@ StickerDatabase::InsertValue(const char *type, const char *uri,
 	assert(*name != 0);
 	assert(value != nullptr);
 
+	BeginWrite();
+
 	BindAll(s, type, uri, name, value);
 
 	AtScopeExit(s) {
@@ -228,6 +364,22 @@ StickerDatabase::StoreValue(const char *type, const char *uri,
 
 	if (!UpdateValue(type, uri, name, value))
 		InsertValue(type, uri, name, value);
+
+	if (auto *cached = LookupCachedName(type, name);
+	    cached != nullptr && cached->complete) {
+		try {
+			cached->values.insert_or_assign(uri, value);
+			if (cached->values.size() > MAX_CACHED_VALUES) {
+				cached->values.clear();
+				cached->complete = false;
+			}
+		} catch (...) {
+			/* out of memory - the cached name is now
+			   inconsistent, drop its values */
+			cached->values.clear();
+			cached->complete = false;
+		}
+	}
 }
 
 bool
@@ -238,6 +390,22 @@ StickerDatabase::Delete(const char *type, const char *uri)
 	assert(type != nullptr);
 	assert(uri != nullptr);
 
+	BeginWrite();
+
+	/* we don't know which names this object has; remove it from
+	   all cached names of this type */
+	const std::string_view type_prefix(type);
+	name_cache.ForEach([type_prefix, uri](const std::string &key,
+					      CachedName &cached){
+		if (key.size() > type_prefix.size() &&
+		    key[type_prefix.size()] == '\n' &&
+		    StringStartsWith(key.c_str(), type_prefix)) {
+			auto i = cached.values.find(std::string_view(uri));
+			if (i != cached.values.end())
+				cached.values.erase(i);
+		}
+	});
+
 	BindAll(s, type, uri);
 
 	AtScopeExit(s) {
@@ -260,6 +428,14 @@ StickerDatabase::DeleteValue(const char *type, const char *uri,
 	assert(type != nullptr);
 	assert(uri != nullptr);
 
+	BeginWrite();
+
+	if (auto *cached = LookupCachedName(type, name)) {
+		auto i = cached->values.find(std::string_view(uri));
+		if (i != cached->values.end())
+			cached->values.erase(i);
+	}
+
 	BindAll(s, type, uri, name);
 
 	AtScopeExit(s) {
@@ -285,33 +461,33 @@ StickerDatabase::Load(const char *type, const char *uri)
 
 sqlite3_stmt *
 StickerDatabase::BindFind(const char *type, const char *base_uri,
-			  const char *name,
+			  const char *base_uri_end, const char *name,
 			  StickerOperator op, const char *value)
 {
 	assert(type != nullptr);
+	assert(base_uri != nullptr);
+	assert(base_uri_end != nullptr);
 	assert(name != nullptr);
 
-	if (base_uri == nullptr)
-		base_uri = "";
-
 	switch (op) {
 	case StickerOperator::EXISTS:
-		BindAll(stmt[STICKER_SQL_FIND], type, base_uri, name);
+		BindAll(stmt[STICKER_SQL_FIND], type, base_uri, base_uri_end,
+			name);
 		return stmt[STICKER_SQL_FIND];
 
 	case StickerOperator::EQUALS:
 		BindAll(stmt[STICKER_SQL_FIND_VALUE],
-			type, base_uri, name, value);
+			type, base_uri, base_uri_end, name, value);
 		return stmt[STICKER_SQL_FIND_VALUE];
 
 	case StickerOperator::LESS_THAN:
 		BindAll(stmt[STICKER_SQL_FIND_LT],
-			type, base_uri, name, value);
+			type, base_uri, base_uri_end, name, value);
 		return stmt[STICKER_SQL_FIND_LT];
 
 	case StickerOperator::GREATER_THAN:
 		BindAll(stmt[STICKER_SQL_FIND_GT],
-			type, base_uri, name, value);
+			type, base_uri, base_uri_end, name, value);
 		return stmt[STICKER_SQL_FIND_GT];
 	}
 
@@ -319,6 +495,28 @@ StickerDatabase::BindFind(const char *type, const char *base_uri,
 	gcc_unreachable();
 }
 
+gcc_pure
+static bool
+Match(const std::string &a, StickerOperator op, const char *b) noexcept
+{
+	switch (op) {
+	case StickerOperator::EXISTS:
+		return true;
+
+	case StickerOperator::EQUALS:
+		return a == b;
+
+	case StickerOperator::LESS_THAN:
+		return a < b;
+
+	case StickerOperator::GREATER_THAN:
+		return a > b;
+	}
+
+	assert(false);
+	gcc_unreachable();
+}
+
 void
 StickerDatabase::Find(const char *type, const char *base_uri, const char *name,
 		      StickerOperator op, const char *value,
@@ -328,7 +526,29 @@ StickerDatabase::Find(const char *type, const char *base_uri, const char *name,
 {
 	assert(func != nullptr);
 
-	sqlite3_stmt *const s = BindFind(type, base_uri, name, op, value);
+	if (base_uri == nullptr)
+		base_uri = "";
+
+	if (const auto *cached = LoadCachedName(type, name)) {
+		const std::string_view base(base_uri);
+		for (auto i = cached->values.lower_bound(base);
+		     i != cached->values.end() &&
+			     StringStartsWith(i->first.c_str(), base);
+		     ++i)
+			if (Match(i->second, op, value))
+				func(i->first.c_str(), i->second.c_str(),
+				     user_data);
+		return;
+	}
+
+	/* a range query instead of "LIKE" allows SQLite to use the
+	   index; no valid UTF-8 string contains the byte 0xff, so
+	   this upper bound is larger than all URIs with this
+	   prefix */
+	const std::string base_uri_end = std::string(base_uri) + "\xff";
+
+	sqlite3_stmt *const s = BindFind(type, base_uri, base_uri_end.c_str(),
+					 name, op, value);
 	assert(s != nullptr);
 
 	AtScopeExit(s) {
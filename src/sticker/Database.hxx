@@ -44,6 +44,8 @@
 
 #include "Match.hxx"
 #include "lib/sqlite/Database.hxx"
+#include "event/CoarseTimerEvent.hxx"
+#include "util/LruCache.hxx"
 
 #include <sqlite3.h>
 
@@ -57,6 +59,7 @@ class StickerDatabase {
 	enum SQL {
 		  SQL_GET,
 		  SQL_LIST,
+		  SQL_LIST_NAME,
 		  SQL_UPDATE,
 		  SQL_INSERT,
 		  SQL_DELETE,
@@ -69,16 +72,48 @@ class StickerDatabase {
 		  SQL_COUNT
 	};
 
+	/**
+	 * All values of one sticker name, indexed by URI.  This
+	 * answers "get" and "find" for frequently used names (e.g. a
+	 * rating) without querying SQLite.
+	 */
+	struct CachedName {
+		std::map<std::string, std::string, std::less<>> values;
+
+		/**
+		 * False if the name has too many values to be
+		 * cached; #values is empty then.
+		 */
+		bool complete;
+	};
+
+	static constexpr std::size_t MAX_CACHED_NAMES = 8;
+	static constexpr std::size_t MAX_CACHED_VALUES = 16384;
+
 	Sqlite::Database db;
 	sqlite3_stmt *stmt[SQL_COUNT];
 
+	/**
+	 * Commits the current transaction.  Writes are collected in a
+	 * transaction which is committed after a short delay, to
+	 * avoid one fsync() per write.
+	 */
+	CoarseTimerEvent commit_timer;
+
+	/**
+	 * Indexed by type and name, see MakeCacheKey().
+	 */
+	LruCache<CachedName, MAX_CACHED_NAMES> name_cache;
+
+	bool in_transaction = false;
+
 public:
 	/**
 	 * Opens the sticker database.
 	 *
 	 * Throws on error.
 	 */
-	StickerDatabase(Path path);
+	StickerDatabase(EventLoop &event_loop, Path path);
 	~StickerDatabase() noexcept;
 
 	/**
@@ -128,6 +163,7 @@ public:
 
 	/**
 	 * Finds stickers with the specified name below the specified URI.
+	 * The callback must not access the sticker database.
 	 *
 	 * @param type the resource type, e.g. "song"
 	 * @param base_uri the URI prefix of the resources, or nullptr if all
@@ -142,7 +178,38 @@ public:
 			       void *user_data),
 		  void *user_data);
 
+	/**
+	 * Commit pending writes now.
+	 *
+	 * Throws #SqliteError on error.
+	 */
+	void Commit();
+
 private:
+	/**
+	 * Start a transaction (unless one is already running) and
+	 * schedule its commit.
+	 */
+	void BeginWrite();
+
+	void OnCommitTimer() noexcept;
+
+	/**
+	 * Look up the cached values of the given name; load them if
+	 * they are not cached yet.
+	 *
+	 * @return the cache item or nullptr if the name has too many
+	 * values to be cached
+	 */
+	const CachedName *LoadCachedName(const char *type, const char *name);
+
+	/**
+	 * Look up the cached values of the given name without loading
+	 * them.
+	 */
+	CachedName *LookupCachedName(const char *type,
+				     const char *name) noexcept;
+
 	void ListValues(std::map<std::string, std::string> &table,
 			const char *type, const char *uri);
 
@@ -153,7 +220,7 @@ private:
 			 const char *name, const char *value);
 
 	sqlite3_stmt *BindFind(const char *type, const char *base_uri,
-			       const char *name,
+			       const char *base_uri_end, const char *name,
 			       StickerOperator op, const char *value);
 };
 
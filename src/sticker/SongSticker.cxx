@@ -133,3 +133,21 @@ sticker_song_find(StickerDatabase &sticker_database, const Database &db,
 	sticker_database.Find("song", data.base_uri, name, op, value,
 			      sticker_song_find_cb, &data);
 }
+
+static void
+sticker_song_load_all_cb(const char *uri, const char *value,
+			 void *user_data)
+{
+	auto &values =
+		*(std::map<std::string, std::string, std::less<>> *)user_data;
+	values.emplace(uri, value);
+}
+
+std::map<std::string, std::string, std::less<>>
+sticker_song_load_all(StickerDatabase &db, const char *name)
+{
+	std::map<std::string, std::string, std::less<>> values;
+	db.Find("song", nullptr, name, StickerOperator::EXISTS, nullptr,
+		sticker_song_load_all_cb, &values);
+	return values;
+}
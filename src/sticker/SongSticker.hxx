@@ -22,6 +22,7 @@
 
 #include "Match.hxx"
 
+#include <map>
 #include <string>
 
 struct LightSong;
@@ -100,4 +101,13 @@ sticker_song_find(StickerDatabase &sticker_database, const Database &db,
 			       void *user_data),
 		  void *user_data);
 
+/**
+ * Load all values of the given song sticker name, indexed by song
+ * URI.
+ *
+ * Throws #SqliteError on error.
+ */
+std::map<std::string, std::string, std::less<>>
+sticker_song_load_all(StickerDatabase &db, const char *name);
+
 #endif
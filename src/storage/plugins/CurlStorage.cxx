@@ -41,21 +41,83 @@
 #include "util/StringFormat.hxx"
 #include "util/UriExtract.hxx"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <deque>
+#include <list>
 #include <memory>
 #include <string>
 #include <utility>
 
+class HttpListDirectoryOperation;
+
 class CurlStorage final : public Storage {
+	/**
+	 * The maximum number of directory listings which are
+	 * requested in advance at the same time.
+	 */
+	static constexpr std::size_t MAX_PREFETCH = 8;
+
+	/**
+	 * The maximum number of entries in #prefetching (running and
+	 * finished).  If this is exceeded, the oldest finished
+	 * listings are discarded.
+	 */
+	static constexpr std::size_t MAX_PREFETCHED = 64;
+
+	/**
+	 * The maximum number of directories remembered in
+	 * #prefetch_queue.
+	 */
+	static constexpr std::size_t MAX_PREFETCH_QUEUE = 4096;
+
+	/**
+	 * Prefetched listings older than this are discarded.
+	 */
+	static constexpr std::chrono::steady_clock::duration PREFETCH_TTL =
+		std::chrono::seconds(60);
+
 	const std::string base;
 
 	CurlInit curl;
 
+	struct Prefetch {
+		std::string uri_utf8;
+
+		std::chrono::steady_clock::time_point time;
+
+		std::unique_ptr<HttpListDirectoryOperation> operation;
+	};
+
+	/**
+	 * Protects #prefetch_queue and #prefetching.
+	 */
+	Mutex prefetch_mutex;
+
+	/**
+	 * Subdirectories (relative URIs) of recently listed
+	 * directories which will probably be listed soon.  The
+	 * database update visits them depth-first, therefore new
+	 * ones are inserted at the front.  They are removed by
+	 * CancelPrefetch() when the #StorageDirectoryReader of their
+	 * parent is destroyed.
+	 */
+	std::deque<std::string> prefetch_queue;
+
+	/**
+	 * Listings which have been requested in advance (running or
+	 * finished), oldest first.
+	 */
+	std::list<Prefetch> prefetching;
+
 public:
 	CurlStorage(EventLoop &_loop, const char *_base)
 		:base(_base),
 		 curl(_loop) {}
 
+	~CurlStorage() noexcept override;
+
 	/* virtual methods from class Storage */
 	StorageFileInfo GetInfo(std::string_view uri_utf8, bool follow) override;
 
@@ -64,6 +126,66 @@ public:
 	[[nodiscard]] std::string MapUTF8(std::string_view uri_utf8) const noexcept override;
 
 	[[nodiscard]] std::string_view MapToRelativeUTF8(std::string_view uri_utf8) const noexcept override;
+
+	/**
+	 * Remove the subdirectories of the given directory from
+	 * #prefetch_queue.  This is called when the caller is done
+	 * with the directory, e.g. when the database update has
+	 * visited it; after that, a listing of these subdirectories
+	 * is not likely to be needed soon.
+	 */
+	void CancelPrefetch(std::string_view uri_utf8) noexcept;
+
+private:
+	std::unique_ptr<HttpListDirectoryOperation> StartListDirectory(std::string_view uri_utf8);
+
+	/**
+	 * Remove the given directory from the prefetch list.
+	 *
+	 * @return the operation which was started by
+	 * StartPrefetch() or nullptr if there is none
+	 */
+	std::unique_ptr<HttpListDirectoryOperation> TakePrefetched(std::string_view uri_utf8) noexcept;
+
+	/**
+	 * Schedule listing the subdirectories of the given directory
+	 * in advance, and start new requests if there are free
+	 * slots.
+	 */
+	void StartPrefetch(std::string_view uri_utf8,
+			   const MemoryStorageDirectoryReader::List &entries) noexcept;
+};
+
+/**
+ * A #MemoryStorageDirectoryReader which cancels prefetching the
+ * subdirectories when it is destroyed.
+ */
+class CurlStorageDirectoryReader final : public StorageDirectoryReader {
+	CurlStorage &storage;
+
+	const std::string uri_utf8;
+
+	MemoryStorageDirectoryReader reader;
+
+public:
+	CurlStorageDirectoryReader(CurlStorage &_storage,
+				   std::string_view _uri_utf8,
+				   MemoryStorageDirectoryReader::List &&entries)
+		:storage(_storage), uri_utf8(_uri_utf8),
+		 reader(std::move(entries)) {}
+
+	~CurlStorageDirectoryReader() noexcept override {
+		storage.CancelPrefetch(uri_utf8);
+	}
+
+	/* virtual methods from class StorageDirectoryReader */
+	const char *Read() noexcept override {
+		return reader.Read();
+	}
+
+	StorageFileInfo GetInfo(bool follow) override {
+		return reader.GetInfo(follow);
+	}
 };
 
 std::string
@@ -117,6 +239,14 @@ public:
 			std::rethrow_exception(postponed_error);
 	}
 
+	/**
+	 * Has the request finished (successfully or not)?
+	 */
+	bool IsDone() noexcept {
+		const std::lock_guard<Mutex> lock(mutex);
+		return done;
+	}
+
 	CURL *GetEasy() noexcept {
 		return request.Get();
 	}
@@ -274,6 +404,7 @@ public:
 				  "<a:resourcetype/>"
 				  "<a:getcontenttype/>"
 				  "<a:getcontentlength/>"
+				  "<a:getlastmodified/>"
 				  "</a:prop>"
 				  "</a:propfind>");
 	}
@@ -281,6 +412,7 @@ public:
 	using BlockingHttpRequest::GetEasy;
 	using BlockingHttpRequest::DeferStart;
 	using BlockingHttpRequest::Wait;
+	using BlockingHttpRequest::IsDone;
 
 protected:
 	virtual void OnDavResponse(DavResponse &&r) = 0;
@@ -489,16 +621,17 @@ public:
 		:PropfindOperation(curl, uri, 1),
 		 base_path(CurlUnescape(GetEasy(), UriPathOrSlash(uri))) {}
 
-	std::unique_ptr<StorageDirectoryReader> Perform() {
-		DeferStart();
+	/**
+	 * Wait for the response and return the directory entries.
+	 *
+	 * Throws on error.
+	 */
+	MemoryStorageDirectoryReader::List WaitEntries() {
 		Wait();
-		return ToReader();
+		return std::move(entries);
 	}
 
 private:
-	std::unique_ptr<StorageDirectoryReader> ToReader() {
-		return std::make_unique<MemoryStorageDirectoryReader>(std::move(entries));
-	}
 
 	/**
 	 * Convert a "href" attribute (which may be an absolute URI)
@@ -551,8 +684,20 @@ protected:
 	}
 };
 
-std::unique_ptr<StorageDirectoryReader>
-CurlStorage::OpenDirectory(std::string_view uri_utf8)
+CurlStorage::~CurlStorage() noexcept
+{
+	/* the requests must be finished before they can be
+	   destructed */
+	for (auto &i : prefetching) {
+		try {
+			i.operation->Wait();
+		} catch (...) {
+		}
+	}
+}
+
+std::unique_ptr<HttpListDirectoryOperation>
+CurlStorage::StartListDirectory(std::string_view uri_utf8)
 {
 	std::string uri = MapUTF8(uri_utf8);
 
@@ -560,7 +705,160 @@ CurlStorage::OpenDirectory(std::string_view uri_utf8)
 	if (uri.back() != '/')
 		uri.push_back('/');
 
-	return HttpListDirectoryOperation(*curl, uri.c_str()).Perform();
+	auto operation =
+		std::make_unique<HttpListDirectoryOperation>(*curl,
+							     uri.c_str());
+	operation->DeferStart();
+	return operation;
+}
+
+std::unique_ptr<HttpListDirectoryOperation>
+CurlStorage::TakePrefetched(std::string_view uri_utf8) noexcept
+{
+	std::unique_ptr<HttpListDirectoryOperation> result;
+	std::list<Prefetch> expired;
+
+	{
+		const std::lock_guard<Mutex> protect(prefetch_mutex);
+
+		auto q = std::find(prefetch_queue.begin(),
+				   prefetch_queue.end(), uri_utf8);
+		if (q != prefetch_queue.end())
+			prefetch_queue.erase(q);
+
+		const auto now = std::chrono::steady_clock::now();
+
+		for (auto i = prefetching.begin(); i != prefetching.end();) {
+			auto next = std::next(i);
+
+			if (now - i->time >= PREFETCH_TTL)
+				/* too old, the directory may have
+				   been modified since */
+				expired.splice(expired.end(), prefetching, i);
+			else if (result == nullptr && i->uri_utf8 == uri_utf8) {
+				result = std::move(i->operation);
+				prefetching.erase(i);
+			}
+
+			i = next;
+		}
+	}
+
+	for (auto &i : expired) {
+		try {
+			i.operation->Wait();
+		} catch (...) {
+		}
+	}
+
+	return result;
+}
+
+void
+CurlStorage::StartPrefetch(std::string_view uri_utf8,
+			   const MemoryStorageDirectoryReader::List &entries) noexcept
+try {
+	const std::lock_guard<Mutex> protect(prefetch_mutex);
+
+	/* insert the subdirectories at the front, preserving their
+	   order */
+	auto position = prefetch_queue.begin();
+	for (const auto &i : entries) {
+		if (!i.info.IsDirectory())
+			continue;
+
+		auto child = uri_utf8.empty()
+			? i.name
+			: PathTraitsUTF8::Build(uri_utf8, i.name);
+		position = std::next(prefetch_queue.insert(position,
+							   std::move(child)));
+	}
+
+	if (prefetch_queue.size() > MAX_PREFETCH_QUEUE)
+		prefetch_queue.resize(MAX_PREFETCH_QUEUE);
+
+	/* finished listings which have not been claimed yet don't
+	   occupy a slot */
+	std::size_t running = std::count_if(prefetching.begin(),
+					    prefetching.end(),
+					    [](const Prefetch &i){
+						    return !i.operation->IsDone();
+					    });
+
+	while (running < MAX_PREFETCH && !prefetch_queue.empty()) {
+		if (prefetching.size() >= MAX_PREFETCHED) {
+			/* discard the oldest finished listing; it is
+			   the least likely one to be needed */
+			auto i = std::find_if(prefetching.begin(),
+					      prefetching.end(),
+					      [](const Prefetch &p){
+						      return p.operation->IsDone();
+					      });
+			if (i == prefetching.end())
+				break;
+
+			prefetching.erase(i);
+		}
+
+		auto child = std::move(prefetch_queue.front());
+		prefetch_queue.pop_front();
+		++running;
+
+		auto operation = StartListDirectory(child);
+		prefetching.push_back({std::move(child),
+				       std::chrono::steady_clock::now(),
+				       std::move(operation)});
+	}
+} catch (...) {
+	/* prefetching is optional; ignore errors */
+}
+
+/**
+ * Is the given relative URI a direct child of the given directory?
+ */
+gcc_pure
+static bool
+IsDirectChild(std::string_view parent, std::string_view child) noexcept
+{
+	if (!parent.empty()) {
+		if (child.size() <= parent.size() ||
+		    child.compare(0, parent.size(), parent) != 0 ||
+		    child[parent.size()] != '/')
+			return false;
+
+		child.remove_prefix(parent.size() + 1);
+	}
+
+	return child.find('/') == child.npos;
+}
+
+void
+CurlStorage::CancelPrefetch(std::string_view uri_utf8) noexcept
+{
+	const std::lock_guard<Mutex> protect(prefetch_mutex);
+
+	prefetch_queue.erase(std::remove_if(prefetch_queue.begin(),
+					    prefetch_queue.end(),
+					    [uri_utf8](const std::string &i){
+						    return IsDirectChild(uri_utf8,
+									 i);
+					    }),
+			     prefetch_queue.end());
+}
+
+std::unique_ptr<StorageDirectoryReader>
+CurlStorage::OpenDirectory(std::string_view uri_utf8)
+{
+	auto operation = TakePrefetched(uri_utf8);
+	if (operation == nullptr)
+		operation = StartListDirectory(uri_utf8);
+
+	auto entries = operation->WaitEntries();
+
+	StartPrefetch(uri_utf8, entries);
+
+	return std::make_unique<CurlStorageDirectoryReader>(*this, uri_utf8,
+							    std::move(entries));
 }
 
 static std::unique_ptr<Storage>
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MountInfo.hxx"
+#include "Error.hxx"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Decode the octal escapes which the kernel uses for space, tab,
+ * newline and backslash.
+ */
+static std::string
+UnescapeMountInfo(std::string_view s) noexcept
+{
+	std::string result;
+	result.reserve(s.size());
+
+	for (std::size_t i = 0; i < s.size(); ++i) {
+		if (s[i] == '\\' && i + 3 < s.size() &&
+		    s[i + 1] >= '0' && s[i + 1] <= '3' &&
+		    s[i + 2] >= '0' && s[i + 2] <= '7' &&
+		    s[i + 3] >= '0' && s[i + 3] <= '7') {
+			result.push_back(char(((s[i + 1] - '0') << 6) |
+					      ((s[i + 2] - '0') << 3) |
+					      (s[i + 3] - '0')));
+			i += 3;
+		} else
+			result.push_back(s[i]);
+	}
+
+	return result;
+}
+
+std::string
+ParseMountInfoMountPoint(std::string_view line) noexcept
+{
+	/* the mount point is the fifth field: "ID PARENT_ID
+	   MAJOR:MINOR ROOT MOUNT_POINT ..." */
+	for (unsigned i = 0; i < 4; ++i) {
+		const auto space = line.find(' ');
+		if (space == line.npos)
+			return {};
+
+		line = line.substr(space + 1);
+	}
+
+	const auto space = line.find(' ');
+	if (space != line.npos)
+		line = line.substr(0, space);
+
+	while (!line.empty() && line.back() == '\n')
+		line.remove_suffix(1);
+
+	return UnescapeMountInfo(line);
+}
+
+bool
+HasMountBelow(std::string_view directory)
+{
+	if (directory == "/")
+		directory = {};
+
+	FILE *file = fopen("/proc/self/mountinfo", "re");
+	if (file == nullptr)
+		throw MakeErrno("Failed to open /proc/self/mountinfo");
+
+	char *line = nullptr;
+	size_t line_size = 0;
+	bool found = false;
+
+	while (!found && getline(&line, &line_size, file) > 0) {
+		const auto mount_point = ParseMountInfoMountPoint(line);
+		found = mount_point.size() > directory.size() + 1 &&
+			mount_point.compare(0, directory.size(),
+					    directory) == 0 &&
+			mount_point[directory.size()] == '/';
+	}
+
+	free(line);
+	fclose(file);
+	return found;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_SYSTEM_MOUNT_INFO_HXX
+#define MPD_SYSTEM_MOUNT_INFO_HXX
+
+#include "util/Compiler.h"
+
+#include <string>
+#include <string_view>
+
+/**
+ * Extract the mount point from a line of /proc/self/mountinfo (see
+ * proc(5)), with octal escapes (e.g. "\040") decoded.
+ *
+ * @return the mount point or an empty string if the line is
+ * malformed
+ */
+gcc_pure
+std::string
+ParseMountInfoMountPoint(std::string_view line) noexcept;
+
+/**
+ * Is a filesystem mounted below (not at) the given directory?  This
+ * reads /proc/self/mountinfo.
+ *
+ * Throws on error.
+ *
+ * @param directory an absolute canonical path without a trailing
+ * slash (except for the root directory)
+ */
+bool
+HasMountBelow(std::string_view directory);
+
+#endif
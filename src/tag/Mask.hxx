@@ -45,6 +45,14 @@ public:
 		return ~None();
 	}
 
+	constexpr bool operator==(TagMask other) const noexcept {
+		return value == other.value;
+	}
+
+	constexpr bool operator!=(TagMask other) const noexcept {
+		return value != other.value;
+	}
+
 	constexpr TagMask operator~() const noexcept {
 		return TagMask(~value);
 	}
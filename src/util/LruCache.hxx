@@ -0,0 +1,126 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef LRU_CACHE_HXX
+#define LRU_CACHE_HXX
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * A bounded cache with string keys.  If it is full, the least
+ * recently used item is evicted.
+ */
+template<typename T, std::size_t max_items>
+class LruCache {
+	struct Item {
+		std::string key;
+		T value;
+	};
+
+	/**
+	 * The most recently used item comes first.
+	 */
+	std::list<Item> items;
+
+	std::map<std::string, typename std::list<Item>::iterator,
+		 std::less<>> map;
+
+public:
+	bool empty() const noexcept {
+		return items.empty();
+	}
+
+	std::size_t size() const noexcept {
+		return items.size();
+	}
+
+	void clear() noexcept {
+		map.clear();
+		items.clear();
+	}
+
+	/**
+	 * Look up an item and mark it as "most recently used".
+	 *
+	 * @return a pointer to the value or nullptr if there is no
+	 * such item; it is invalidated by the next Store() call
+	 */
+	T *Lookup(std::string_view key) noexcept {
+		auto i = map.find(key);
+		if (i == map.end())
+			return nullptr;
+
+		items.splice(items.begin(), items, i->second);
+		return &i->second->value;
+	}
+
+	/**
+	 * Insert a new item or replace an existing one.
+	 */
+	template<typename V>
+	void Store(std::string key, V &&value) {
+		auto i = map.find(key);
+		if (i != map.end()) {
+			items.erase(i->second);
+			map.erase(i);
+		} else if (items.size() >= max_items) {
+			map.erase(items.back().key);
+			items.pop_back();
+		}
+
+		items.push_front({std::move(key), std::forward<V>(value)});
+		map.emplace(items.front().key, items.begin());
+	}
+
+	/**
+	 * Invoke a function for each item (with the key and the
+	 * value), the least recently used one first, so storing them
+	 * in this order restores the order.
+	 */
+	template<typename F>
+	void ForEach(F &&f) const {
+		for (auto i = items.rbegin(); i != items.rend(); ++i)
+			f(i->key, i->value);
+	}
+
+	template<typename F>
+	void ForEach(F &&f) {
+		for (auto i = items.rbegin(); i != items.rend(); ++i)
+			f(std::as_const(i->key), i->value);
+	}
+
+	/**
+	 * Remove an item (if it exists).
+	 */
+	void Remove(std::string_view key) noexcept {
+		auto i = map.find(key);
+		if (i != map.end()) {
+			items.erase(i->second);
+			map.erase(i);
+		}
+	}
+};
+
+#endif
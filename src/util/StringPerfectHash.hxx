@@ -0,0 +1,149 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef STRING_PERFECT_HASH_HXX
+#define STRING_PERFECT_HASH_HXX
+
+#include "Compiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * A perfect hash function for a fixed set of strings, which is
+ * determined at runtime by trying seeds until there are no
+ * collisions.  It maps each key to its index in the caller's array;
+ * a lookup is one hash calculation and one table access.  Since
+ * unknown strings may map to any index, the caller must compare the
+ * key at the returned index.
+ *
+ * @param TABLE_SIZE the number of slots; must be a power of two and
+ * should be much larger than the number of keys (about 16 times),
+ * or else it may take many attempts to find a seed
+ */
+template<std::size_t TABLE_SIZE>
+class StringPerfectHash {
+	static_assert(TABLE_SIZE > 0 && (TABLE_SIZE & (TABLE_SIZE - 1)) == 0,
+		      "TABLE_SIZE must be a power of two");
+
+	static constexpr uint32_t MAX_SEED = 1 << 16;
+
+	/**
+	 * The seed which was found by Build(), 0 if there is none.
+	 */
+	uint32_t seed = 0;
+
+	/**
+	 * Each slot contains the key index plus one; 0 means the slot
+	 * is empty.
+	 */
+	uint8_t table[TABLE_SIZE]{};
+
+public:
+	/**
+	 * The maximum number of keys.
+	 */
+	static constexpr std::size_t MAX_KEYS = 254;
+
+	/**
+	 * Has Build() succeeded?
+	 */
+	constexpr bool IsDefined() const noexcept {
+		return seed != 0;
+	}
+
+	/**
+	 * Find a seed for the given keys.  The keys must be unique.
+	 *
+	 * @param get_key a function which returns the key with the
+	 * given index (as std::string_view)
+	 * @return false if no seed was found (the object is then
+	 * undefined)
+	 */
+	template<typename F>
+	bool Build(std::size_t n, F &&get_key) noexcept {
+		if (n > MAX_KEYS)
+			return false;
+
+		for (seed = 1; seed < MAX_SEED; ++seed)
+			if (TryBuild(n, get_key))
+				return true;
+
+		seed = 0;
+		return false;
+	}
+
+	/**
+	 * Look up a key.
+	 *
+	 * @return the index of the key which is the only possible
+	 * match, or -1 if there is definitely no match
+	 */
+	gcc_pure
+	int Find(std::string_view key) const noexcept {
+		const unsigned slot = table[Slot(key, seed)];
+		return int(slot) - 1;
+	}
+
+private:
+	/**
+	 * FNV-1a with the seed folded into the offset basis, followed
+	 * by the MurmurHash3 finalizer to spread the few bits of short
+	 * keys over the whole word.
+	 */
+	gcc_pure
+	static uint32_t Hash(std::string_view key, uint32_t seed) noexcept {
+		uint32_t h = 2166136261U ^ (seed * 0x9e3779b9U);
+		for (char ch : key) {
+			h ^= uint8_t(ch);
+			h *= 16777619U;
+		}
+
+		h ^= h >> 16;
+		h *= 0x85ebca6bU;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35U;
+		h ^= h >> 16;
+		return h;
+	}
+
+	gcc_pure
+	static std::size_t Slot(std::string_view key, uint32_t seed) noexcept {
+		return Hash(key, seed) & (TABLE_SIZE - 1);
+	}
+
+	template<typename F>
+	bool TryBuild(std::size_t n, F &get_key) noexcept {
+		std::fill_n(table, TABLE_SIZE, 0);
+
+		for (std::size_t i = 0; i < n; ++i) {
+			auto &slot = table[Slot(get_key(i), seed)];
+			if (slot != 0)
+				return false;
+
+			slot = uint8_t(i + 1);
+		}
+
+		return true;
+	}
+};
+
+#endif
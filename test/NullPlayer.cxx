@@ -17,19 +17,20 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-#include "Client.hxx"
-#include "Log.hxx"
+/*
+ * Stubs for tests which link ../src/player/Control.cxx without the
+ * rest of MPD; see NullPlayer.hxx.
+ */
+
+#include "player/Control.hxx"
+#include "Idle.hxx"
 
 void
-Client::OnSocketError(std::exception_ptr ep) noexcept
+idle_add(unsigned)
 {
-	FormatError(ep, "error on client %d", num);
-
-	SetExpired();
 }
 
 void
-Client::OnSocketClosed() noexcept
+PlayerControl::RunThread() noexcept
 {
-	SetExpired();
 }
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef NULL_PLAYER_HXX
+#define NULL_PLAYER_HXX
+
+#include "player/Listener.hxx"
+#include "player/Outputs.hxx"
+#include "pcm/AudioFormat.hxx"
+
+/*
+ * Helpers for tests which construct a #PlayerControl without a
+ * player thread.  Link NullPlayer.cxx and ../src/player/Control.cxx.
+ */
+
+class NullPlayerListener : public PlayerListener {
+public:
+	void OnPlayerSync() noexcept override {}
+	void OnPlayerTagModified() noexcept override {}
+	void OnBorderPause() noexcept override {}
+	void OnPlayerStatusModified() noexcept override {}
+};
+
+class NullPlayerOutputs final : public PlayerOutputs {
+public:
+	void EnableDisable() override {}
+	void Open(const AudioFormat) override {}
+	void Close() noexcept override {}
+	void Release() noexcept override {}
+	void Play(MusicChunkPtr) override {}
+	unsigned CheckPipe() noexcept override { return 0; }
+	void Pause() noexcept override {}
+	void Drain() noexcept override {}
+	void Cancel() noexcept override {}
+	void SongBorder() noexcept override {}
+
+	SignedSongTime GetElapsedTime() const noexcept override {
+		return SignedSongTime::Negative();
+	}
+};
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Unit tests for class HierarchicalTimerWheel.
+ */
+
+#include "event/HierarchicalTimerWheel.hxx"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+
+struct TestTimer final : AutoUnlinkIntrusiveListHook {
+	Event::TimePoint due;
+
+	/**
+	 * The time of the Run() call which has invoked this timer.
+	 */
+	Event::TimePoint fired{};
+
+	unsigned n_fired = 0;
+
+	/**
+	 * The current time passed to Run(), for checking when timers
+	 * are invoked.
+	 */
+	const Event::TimePoint *now = nullptr;
+
+	auto GetDue() const noexcept {
+		return due;
+	}
+
+	bool IsPending() const noexcept {
+		return is_linked();
+	}
+
+	void Cancel() noexcept {
+		if (IsPending())
+			unlink();
+	}
+
+	void Run() noexcept {
+		++n_fired;
+		if (now != nullptr)
+			fired = *now;
+	}
+};
+
+using Wheel = HierarchicalTimerWheel<TestTimer, 1>;
+
+/* some arbitrary start time which is not aligned to any slot */
+static constexpr Event::TimePoint start{seconds(123456) + milliseconds(789)};
+
+}
+
+TEST(HierarchicalTimerWheel, Empty)
+{
+	Wheel wheel;
+	EXPECT_LT(wheel.Run(start).count(), 0);
+}
+
+TEST(HierarchicalTimerWheel, Basic)
+{
+	Wheel wheel;
+	wheel.Run(start);
+
+	TestTimer t;
+	t.due = start + milliseconds(10);
+	wheel.Insert(t);
+	EXPECT_TRUE(t.IsPending());
+
+	const auto timeout = wheel.Run(start + milliseconds(5));
+	EXPECT_GE(timeout, milliseconds(5));
+	EXPECT_LE(timeout, milliseconds(6));
+	EXPECT_EQ(t.n_fired, 0u);
+
+	wheel.Run(start + milliseconds(9));
+	EXPECT_EQ(t.n_fired, 0u);
+
+	EXPECT_LT(wheel.Run(start + milliseconds(10)).count(), 0);
+	EXPECT_EQ(t.n_fired, 1u);
+	EXPECT_FALSE(t.IsPending());
+}
+
+TEST(HierarchicalTimerWheel, AlreadyDue)
+{
+	Wheel wheel;
+	wheel.Run(start);
+
+	TestTimer t;
+	t.due = start;
+	wheel.Insert(t);
+	EXPECT_LT(wheel.Run(start).count(), 0);
+	EXPECT_EQ(t.n_fired, 1u);
+}
+
+TEST(HierarchicalTimerWheel, Cancel)
+{
+	Wheel wheel;
+	wheel.Run(start);
+
+	TestTimer a, b;
+	a.due = start + milliseconds(3);
+	b.due = start + seconds(100);
+	wheel.Insert(a);
+	wheel.Insert(b);
+
+	a.Cancel();
+	b.Cancel();
+
+	EXPECT_LT(wheel.Run(start + seconds(200)).count(), 0);
+	EXPECT_EQ(a.n_fired, 0u);
+	EXPECT_EQ(b.n_fired, 0u);
+}
+
+/**
+ * Timers in the higher levels must be cascaded and must fire at the
+ * right time, even if Run() is called rarely.
+ */
+TEST(HierarchicalTimerWheel, Far)
+{
+	static constexpr Event::Duration delays[] = {
+		milliseconds(63),
+		milliseconds(64),
+		milliseconds(4095),
+		milliseconds(4096),
+		seconds(60),
+		std::chrono::hours(1),
+		std::chrono::hours(24 * 30),
+		/* beyond the span of the wheel */
+		std::chrono::hours(24 * 365 * 3),
+	};
+
+	for (const auto delay : delays) {
+		Wheel wheel;
+		wheel.Run(start);
+
+		TestTimer t;
+		t.due = start + delay;
+		wheel.Insert(t);
+
+		/* follow the requested timeouts; the wheel may wake
+		   up early, but never late */
+		auto now = start;
+		t.now = &now;
+		while (t.n_fired == 0) {
+			const auto timeout = wheel.Run(now);
+			if (t.n_fired > 0)
+				break;
+
+			ASSERT_GT(timeout.count(), 0);
+			ASSERT_LE(now + timeout, t.due + milliseconds(1));
+			now += timeout;
+		}
+
+		EXPECT_GE(t.fired, t.due);
+		EXPECT_LT(t.fired, t.due + milliseconds(1));
+	}
+}
+
+TEST(HierarchicalTimerWheel, Random)
+{
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<unsigned> delay_ms(0, 300000);
+
+	Wheel wheel;
+	wheel.Run(start);
+
+	std::vector<TestTimer> timers(2000);
+	auto now = start;
+
+	for (auto &t : timers) {
+		t.due = start + milliseconds(delay_ms(rng));
+		t.now = &now;
+		wheel.Insert(t);
+	}
+
+	/* reschedule some of them */
+	for (unsigned i = 0; i < timers.size(); i += 3) {
+		auto &t = timers[i];
+		t.Cancel();
+		t.due = start + milliseconds(delay_ms(rng));
+		wheel.Insert(t);
+	}
+
+	/* advance time in irregular steps */
+	std::uniform_int_distribution<unsigned> step_ms(1, 5000);
+	while (now < start + seconds(310)) {
+		now += milliseconds(step_ms(rng));
+		wheel.Run(now);
+	}
+
+	for (const auto &t : timers) {
+		EXPECT_EQ(t.n_fired, 1u);
+		EXPECT_GE(t.fired, t.due);
+	}
+}
+
+TEST(HierarchicalTimerWheel, Coarse)
+{
+	HierarchicalTimerWheel<TestTimer, 1000> wheel;
+	wheel.Run(start);
+
+	TestTimer t;
+	t.due = start + milliseconds(1500);
+	wheel.Insert(t);
+
+	/* coarse timers fire at the end of their slot */
+	const auto timeout = wheel.Run(start);
+	EXPECT_GE(start + timeout, t.due);
+	EXPECT_LT(start + timeout, t.due + seconds(1));
+
+	wheel.Run(start + timeout);
+	EXPECT_EQ(t.n_fired, 1u);
+}
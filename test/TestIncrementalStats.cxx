@@ -0,0 +1,161 @@
+/*
+ * Unit tests for class IncrementalStats.
+ */
+
+#include "db/plugins/simple/IncrementalStats.hxx"
+#include "tag/Builder.hxx"
+#include "tag/Tag.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/RecursiveMap.hxx"
+
+#include <gtest/gtest.h>
+
+static Tag
+MakeTag(const char *artist, const char *album, const char *album_artist,
+	unsigned duration_s)
+{
+	TagBuilder builder;
+	builder.SetDuration(SignedSongTime::FromS(duration_s));
+	if (artist != nullptr)
+		builder.AddItem(TAG_ARTIST, artist);
+	if (album != nullptr)
+		builder.AddItem(TAG_ALBUM, album);
+	if (album_artist != nullptr)
+		builder.AddItem(TAG_ALBUM_ARTIST, album_artist);
+	return builder.Commit();
+}
+
+TEST(IncrementalStats, Empty)
+{
+	const IncrementalStats stats;
+	const auto s = stats.Get();
+	EXPECT_EQ(s.song_count, 0u);
+	EXPECT_EQ(s.total_duration.count(), 0u);
+	EXPECT_EQ(s.artist_count, 0u);
+	EXPECT_EQ(s.album_count, 0u);
+	EXPECT_EQ(s.albumartist_count, 0u);
+}
+
+TEST(IncrementalStats, AddRemove)
+{
+	const auto a = MakeTag("A", "X", "V", 10);
+	const auto b = MakeTag("A", "Y", nullptr, 20);
+	const auto c = MakeTag("B", "Y", "V", 30);
+
+	IncrementalStats stats;
+	stats.Add(a);
+	stats.Add(b);
+	stats.Add(c);
+
+	auto s = stats.Get();
+	EXPECT_EQ(s.song_count, 3u);
+	EXPECT_EQ(std::chrono::duration_cast<std::chrono::seconds>(s.total_duration).count(), 60);
+	EXPECT_EQ(s.artist_count, 2u);
+	EXPECT_EQ(s.album_count, 2u);
+	EXPECT_EQ(s.albumartist_count, 1u);
+
+	/* "A" is still referenced by song "b" */
+	stats.Remove(a);
+	s = stats.Get();
+	EXPECT_EQ(s.song_count, 2u);
+	EXPECT_EQ(std::chrono::duration_cast<std::chrono::seconds>(s.total_duration).count(), 50);
+	EXPECT_EQ(s.artist_count, 2u);
+	EXPECT_EQ(s.album_count, 1u);
+	EXPECT_EQ(s.albumartist_count, 1u);
+
+	stats.Remove(b);
+	s = stats.Get();
+	EXPECT_EQ(s.artist_count, 1u);
+	EXPECT_EQ(s.album_count, 1u);
+
+	stats.Remove(c);
+	s = stats.Get();
+	EXPECT_EQ(s.song_count, 0u);
+	EXPECT_EQ(s.total_duration.count(), 0u);
+	EXPECT_EQ(s.artist_count, 0u);
+	EXPECT_EQ(s.album_count, 0u);
+	EXPECT_EQ(s.albumartist_count, 0u);
+}
+
+TEST(IncrementalStats, Duplicate)
+{
+	/* the same value twice in one song is counted once */
+	TagBuilder builder;
+	builder.AddItem(TAG_ARTIST, "A");
+	builder.AddItem(TAG_ARTIST, "A");
+	builder.AddItem(TAG_ARTIST, "B");
+	const auto tag = builder.Commit();
+
+	IncrementalStats stats;
+	stats.Add(tag);
+	stats.Add(tag);
+	EXPECT_EQ(stats.Get().artist_count, 2u);
+
+	stats.Remove(tag);
+	EXPECT_EQ(stats.Get().artist_count, 2u);
+
+	stats.Remove(tag);
+	EXPECT_EQ(stats.Get().artist_count, 0u);
+
+	stats.Add(tag);
+	stats.Clear();
+	EXPECT_EQ(stats.Get().song_count, 0u);
+	EXPECT_EQ(stats.Get().artist_count, 0u);
+}
+
+TEST(IncrementalStats, Aggregate)
+{
+	const auto a = MakeTag("A", "X", "V", 10);
+	const auto b = MakeTag("A", "Y", nullptr, 20);
+	const auto c = MakeTag("B", "Y", "V", 30);
+
+	IncrementalStats stats;
+	stats.Add(a);
+
+	static constexpr TagType album_by_albumartist[] = {
+		TAG_ALBUM_ARTIST, TAG_ALBUM,
+	};
+	static constexpr TagType artist = TAG_ARTIST;
+
+	/* the caller fills a new aggregate with the existing songs */
+	stats.MakeAggregate(album_by_albumartist).Add(a);
+	stats.MakeAggregate({&artist, 1}).Add(a);
+
+	stats.Add(b);
+	stats.Add(c);
+
+	const auto *aggregate = stats.FindAggregate(album_by_albumartist);
+	ASSERT_NE(aggregate, nullptr);
+
+	/* "b" has no album artist and falls back to "A" */
+	auto map = aggregate->ToRecursiveMap();
+	ASSERT_EQ(map.size(), 2u);
+	EXPECT_EQ(map["A"].size(), 1u);
+	EXPECT_EQ(map["A"].count("Y"), 1u);
+	EXPECT_EQ(map["V"].size(), 2u);
+
+	aggregate = stats.FindAggregate({&artist, 1});
+	ASSERT_NE(aggregate, nullptr);
+
+	auto counts = aggregate->ToCountMap();
+	ASSERT_EQ(counts.size(), 2u);
+	EXPECT_EQ(counts["A"].n_songs, 2u);
+	EXPECT_EQ(std::chrono::duration_cast<std::chrono::seconds>(counts["A"].total_duration).count(), 30);
+	EXPECT_EQ(counts["B"].n_songs, 1u);
+
+	stats.Remove(a);
+	stats.Remove(c);
+
+	counts = aggregate->ToCountMap();
+	ASSERT_EQ(counts.size(), 1u);
+	EXPECT_EQ(counts["A"].n_songs, 1u);
+	EXPECT_EQ(std::chrono::duration_cast<std::chrono::seconds>(counts["A"].total_duration).count(), 20);
+
+	map = stats.FindAggregate(album_by_albumartist)->ToRecursiveMap();
+	ASSERT_EQ(map.size(), 1u);
+	EXPECT_EQ(map["A"].size(), 1u);
+	EXPECT_EQ(map["A"].count("Y"), 1u);
+
+	static constexpr TagType genre = TAG_GENRE;
+	EXPECT_EQ(stats.FindAggregate({&genre, 1}), nullptr);
+}
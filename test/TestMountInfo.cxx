@@ -0,0 +1,46 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "system/MountInfo.hxx"
+
+#include <gtest/gtest.h>
+
+TEST(MountInfo, Parse)
+{
+	EXPECT_EQ(ParseMountInfoMountPoint("36 35 98:0 /mnt1 /mnt2 rw,noatime master:1 - ext3 /dev/root rw,errors=continue\n"),
+		  "/mnt2");
+	EXPECT_EQ(ParseMountInfoMountPoint("22 1 8:1 / / rw - ext4 /dev/sda1 rw"),
+		  "/");
+
+	/* octal escapes */
+	EXPECT_EQ(ParseMountInfoMountPoint("40 22 8:2 / /music/My\\040Songs rw - ext4 /dev/sda2 rw"),
+		  "/music/My Songs");
+	EXPECT_EQ(ParseMountInfoMountPoint("40 22 8:2 / /a\\134b rw - ext4 /dev/sda2 rw"),
+		  "/a\\b");
+
+	/* malformed */
+	EXPECT_EQ(ParseMountInfoMountPoint(""), "");
+	EXPECT_EQ(ParseMountInfoMountPoint("40 22 8:2 /"), "");
+}
+
+TEST(MountInfo, HasMountBelow)
+{
+	/* /proc itself is a mount point */
+	EXPECT_TRUE(HasMountBelow("/"));
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "NullPlayer.hxx"
+#include "queue/Playlist.hxx"
+#include "queue/Listener.hxx"
+#include "player/Control.hxx"
+#include "song/DetachedSong.hxx"
+#include "ReplayGainConfig.hxx"
+#include "SongLoader.hxx"
+#include "PlaylistError.hxx"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <string.h>
+
+DetachedSong
+SongLoader::LoadSong(const char *uri_utf8) const
+{
+	return DetachedSong(uri_utf8);
+}
+
+namespace {
+
+/**
+ * Resolves all songs except those whose URI starts with "missing/".
+ */
+class TestQueueListener final : public QueueListener {
+public:
+	unsigned modified = 0, resolved = 0;
+
+	void OnQueueModified() noexcept override {
+		++modified;
+	}
+
+	void OnQueueOptionsChanged() noexcept override {}
+	void OnQueueSongStarted() noexcept override {}
+
+	bool OnQueueResolveSong(DetachedSong &song) noexcept override {
+		if (strncmp(song.GetURI(), "missing/", 8) == 0)
+			return false;
+
+		++resolved;
+		return true;
+	}
+};
+
+struct TestPlaylist {
+	NullPlayerListener player_listener;
+	NullPlayerOutputs outputs;
+	const ReplayGainConfig replay_gain_config{};
+	PlayerControl pc{player_listener, outputs, nullptr, 64,
+			 AudioFormat::Undefined(), replay_gain_config};
+
+	TestQueueListener listener;
+	playlist pl;
+
+	explicit TestPlaylist(unsigned max_length) noexcept
+		:pl(max_length, listener) {}
+};
+
+/**
+ * Append the songs "<first>.ogg" to "<first+n-1>.ogg" one by one with
+ * playlist::AppendSong() until it fails.
+ */
+static PlaylistResult
+AppendSongs(TestPlaylist &t, unsigned first, unsigned n)
+{
+	try {
+		for (unsigned i = first; i < first + n; ++i)
+			t.pl.AppendSong(t.pc,
+					DetachedSong(std::to_string(i) + ".ogg"));
+		return PlaylistResult::SUCCESS;
+	} catch (const PlaylistError &e) {
+		return e.GetCode();
+	}
+}
+
+} // anonymous namespace
+
+TEST(Playlist, ResolveSongs)
+{
+	TestPlaylist t(16);
+	auto &queue = t.pl.queue;
+
+	queue.Append(DetachedSong("a.ogg"), 0);
+	queue.Append(DetachedSong("missing/b.ogg"), 0);
+	queue.Append(DetachedSong("c.ogg"), 0);
+	queue.Append(DetachedSong("d.ogg"), 0);
+
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		queue.SetUnresolvedAtPosition(i, true);
+
+	EXPECT_TRUE(queue.HasUnresolved());
+
+	/* the first batch resolves "a.ogg" and removes the missing
+	   song */
+	EXPECT_TRUE(t.pl.ResolveSongs(t.pc, 2));
+	EXPECT_EQ(t.listener.resolved, 1u);
+	EXPECT_EQ(queue.GetLength(), 3u);
+	EXPECT_STREQ(queue.Get(1).GetURI(), "c.ogg");
+	EXPECT_TRUE(queue.IsUnresolvedAtPosition(1));
+
+	const unsigned modified = t.listener.modified;
+	EXPECT_FALSE(t.pl.ResolveSongs(t.pc, 16));
+	EXPECT_EQ(t.listener.resolved, 3u);
+	EXPECT_EQ(queue.GetLength(), 3u);
+	EXPECT_FALSE(queue.HasUnresolved());
+	EXPECT_GT(t.listener.modified, modified);
+
+	/* nothing left to do */
+	EXPECT_FALSE(t.pl.ResolveSongs(t.pc, 16));
+	EXPECT_EQ(t.listener.resolved, 3u);
+}
+
+TEST(Playlist, AppendSong)
+{
+	TestPlaylist t(4);
+	auto &queue = t.pl.queue;
+
+	EXPECT_EQ(AppendSongs(t, 0, 3), PlaylistResult::SUCCESS);
+	EXPECT_EQ(queue.GetLength(), 3u);
+	EXPECT_EQ(t.listener.modified, 3u);
+
+	/* the song which fits is appended, the next one is rejected */
+	EXPECT_EQ(AppendSongs(t, 3, 3), PlaylistResult::TOO_LARGE);
+	EXPECT_EQ(queue.GetLength(), 4u);
+	EXPECT_STREQ(queue.Get(3).GetURI(), "3.ogg");
+	EXPECT_EQ(t.listener.modified, 4u);
+
+	/* the queue is full */
+	EXPECT_EQ(AppendSongs(t, 6, 1), PlaylistResult::TOO_LARGE);
+	EXPECT_EQ(queue.GetLength(), 4u);
+	EXPECT_EQ(t.listener.modified, 4u);
+
+	for (unsigned i = 0; i < queue.GetLength(); ++i) {
+		EXPECT_EQ(queue.Get(i).GetURI(), std::to_string(i) + ".ogg");
+		EXPECT_EQ(queue.OrderToPosition(i), i);
+	}
+}
+
+TEST(Playlist, AppendSongRandom)
+{
+	TestPlaylist t(256);
+	auto &queue = t.pl.queue;
+	queue.random = true;
+
+	const unsigned id = t.pl.AppendSong(t.pc, DetachedSong("first.ogg"));
+	EXPECT_EQ(id, queue.PositionToId(0));
+
+	EXPECT_EQ(AppendSongs(t, 0, 200), PlaylistResult::SUCCESS);
+	EXPECT_EQ(queue.GetLength(), 201u);
+
+	/* the positions are in the order of the songs, but the new
+	   songs have been shuffled into the order */
+	EXPECT_STREQ(queue.Get(0).GetURI(), "first.ogg");
+	for (unsigned i = 0; i < 200; ++i)
+		EXPECT_EQ(queue.Get(i + 1).GetURI(), std::to_string(i) + ".ogg");
+
+	std::vector<unsigned> order;
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		order.push_back(queue.OrderToPosition(i));
+
+	EXPECT_FALSE(std::is_sorted(order.begin(), order.end()));
+
+	std::sort(order.begin(), order.end());
+	for (unsigned i = 0; i < order.size(); ++i)
+		EXPECT_EQ(order[i], i);
+}
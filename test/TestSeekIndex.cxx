@@ -0,0 +1,61 @@
+/*
+ * Unit tests for class SeekIndex.
+ */
+
+#include "decoder/SeekIndex.hxx"
+
+#include <gtest/gtest.h>
+
+TEST(SeekIndex, Empty)
+{
+	const SeekIndex index;
+	EXPECT_TRUE(index.empty());
+	EXPECT_EQ(index.FindBefore(0), nullptr);
+	EXPECT_EQ(index.FindAfter(0), nullptr);
+	EXPECT_FALSE(index.HasEndPosition());
+}
+
+TEST(SeekIndex, Find)
+{
+	SeekIndex index;
+	EXPECT_TRUE(index.Add(0, 100, 10));
+	EXPECT_TRUE(index.Add(10, 200, 10));
+	EXPECT_TRUE(index.Add(30, 400, 10));
+	EXPECT_EQ(index.size(), 3u);
+
+	EXPECT_EQ(index.FindBefore(0)->offset, 100u);
+	EXPECT_EQ(index.FindBefore(9)->offset, 100u);
+	EXPECT_EQ(index.FindBefore(10)->offset, 200u);
+	EXPECT_EQ(index.FindBefore(29)->offset, 200u);
+	EXPECT_EQ(index.FindBefore(1000)->offset, 400u);
+
+	EXPECT_EQ(index.FindAfter(0)->offset, 200u);
+	EXPECT_EQ(index.FindAfter(10)->offset, 400u);
+	EXPECT_EQ(index.FindAfter(30), nullptr);
+}
+
+TEST(SeekIndex, MinDistance)
+{
+	SeekIndex index;
+	EXPECT_TRUE(index.Add(100, 1000, 10));
+	EXPECT_FALSE(index.Add(100, 1000, 10));
+	EXPECT_FALSE(index.Add(95, 950, 10));
+	EXPECT_FALSE(index.Add(105, 1050, 10));
+	EXPECT_TRUE(index.Add(110, 1100, 10));
+
+	/* fill a hole */
+	EXPECT_TRUE(index.Add(50, 500, 10));
+	EXPECT_EQ(index.size(), 3u);
+	EXPECT_EQ(index.FindBefore(60)->position, 50u);
+}
+
+TEST(SeekIndex, Contradiction)
+{
+	SeekIndex index;
+	EXPECT_TRUE(index.Add(100, 1000, 0));
+
+	/* offset must grow with the position */
+	EXPECT_FALSE(index.Add(200, 900, 0));
+	EXPECT_FALSE(index.Add(50, 1100, 0));
+	EXPECT_EQ(index.size(), 1u);
+}
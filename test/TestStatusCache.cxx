@@ -0,0 +1,138 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "NullPlayer.hxx"
+#include "StatusCache.hxx"
+#include "player/Control.hxx"
+#include "ReplayGainConfig.hxx"
+#include "Idle.hxx"
+
+#include <gtest/gtest.h>
+
+using std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * Invalidates the #StatusCache like #Partition does.
+ */
+class CachePlayerListener final : public NullPlayerListener {
+	StatusCache &cache;
+
+public:
+	explicit CachePlayerListener(StatusCache &_cache) noexcept
+		:cache(_cache) {}
+
+	void OnPlayerStatusModified() noexcept override {
+		cache.Invalidate();
+	}
+};
+
+std::shared_ptr<const StatusCache::Status>
+MakeStatus(const StatusCache &cache, PlayerState state,
+	   steady_clock::time_point now) noexcept
+{
+	auto status = std::make_shared<StatusCache::Status>();
+	status->version = cache.shared->GetVersion();
+	status->state = state;
+	status->time = now;
+	status->elapsed_time = SongTime::FromS(10u);
+	status->total_time = SignedSongTime::FromS(60u);
+	status->head = "state: play\n";
+	status->tail = "bitrate: 320\n";
+	return status;
+}
+
+} // anonymous namespace
+
+TEST(StatusCache, Invalidate)
+{
+	const std::atomic_uint instance_version{0};
+	StatusCache cache(instance_version);
+	const auto now = steady_clock::now();
+
+	EXPECT_EQ(cache.shared->GetStatus(now), nullptr);
+
+	cache.shared->SetStatus(MakeStatus(cache, PlayerState::PLAY, now));
+	EXPECT_NE(cache.shared->GetStatus(now), nullptr);
+
+	/* unrelated events don't invalidate */
+	cache.OnIdle(IDLE_DATABASE|IDLE_STORED_PLAYLIST);
+	EXPECT_NE(cache.shared->GetStatus(now), nullptr);
+
+	/* the cache expires */
+	EXPECT_EQ(cache.shared->GetStatus(now + StatusCache::MAX_AGE), nullptr);
+
+	cache.OnIdle(IDLE_PLAYER);
+	EXPECT_EQ(cache.shared->GetStatus(now), nullptr);
+}
+
+TEST(StatusCache, ClearError)
+{
+	const std::atomic_uint instance_version{0};
+	StatusCache cache(instance_version);
+	const auto now = steady_clock::now();
+
+	CachePlayerListener listener(cache);
+	NullPlayerOutputs outputs;
+	const ReplayGainConfig replay_gain_config{};
+	PlayerControl pc(listener, outputs, nullptr, 64,
+			 AudioFormat::Undefined(), replay_gain_config);
+
+	cache.shared->SetStatus(MakeStatus(cache, PlayerState::PLAY, now));
+	ASSERT_NE(cache.shared->GetStatus(now), nullptr);
+
+	/* "clearerror" does not emit an idle event, but the next
+	   "status" must not show the old error */
+	pc.LockClearError();
+	EXPECT_EQ(cache.shared->GetStatus(now), nullptr);
+}
+
+TEST(StatusCache, AppendTo)
+{
+	const std::atomic_uint instance_version{0};
+	StatusCache cache(instance_version);
+	const auto now = steady_clock::now();
+
+	std::string result;
+	MakeStatus(cache, PlayerState::PLAY, now)
+		->AppendTo(result, now + std::chrono::seconds(2));
+	EXPECT_EQ(result, "state: play\n"
+		  "time: 12:60\n"
+		  "elapsed: 12.000\n"
+		  "bitrate: 320\n");
+
+	/* the elapsed time does not advance while paused */
+	result.clear();
+	MakeStatus(cache, PlayerState::PAUSE, now)
+		->AppendTo(result, now + std::chrono::seconds(2));
+	EXPECT_EQ(result, "state: play\n"
+		  "time: 10:60\n"
+		  "elapsed: 10.000\n"
+		  "bitrate: 320\n");
+
+	/* ... and never exceeds the total time */
+	result.clear();
+	MakeStatus(cache, PlayerState::PLAY, now)
+		->AppendTo(result, now + std::chrono::minutes(2));
+	EXPECT_EQ(result, "state: play\n"
+		  "time: 60:60\n"
+		  "elapsed: 60.000\n"
+		  "bitrate: 320\n");
+}
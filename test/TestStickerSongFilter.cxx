@@ -0,0 +1,148 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MakeTag.hxx"
+#include "song/Filter.hxx"
+#include "song/StickerSongFilter.hxx"
+#include "song/LightSong.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+static bool
+InvokeFilter(const SongFilter &f, const char *uri) noexcept
+{
+	const Tag tag = MakeTag(TAG_TITLE, "foo");
+	return f.Match(LightSong(uri, tag));
+}
+
+static bool
+InvokeFilter(const SongFilter &f, const char *directory,
+	     const char *uri) noexcept
+{
+	const Tag tag = MakeTag(TAG_TITLE, "foo");
+	LightSong song(uri, tag);
+	song.directory = directory;
+	return f.Match(song);
+}
+
+static SongFilter
+ParseStickerFilter(const char *expression)
+{
+	SongFilter filter;
+	filter.Parse(ConstBuffer<const char *>(&expression, 1));
+
+	auto values = std::make_shared<StickerSongFilter::Values>();
+	values->emplace("a.ogg", "3");
+	values->emplace("b.ogg", "4");
+	values->emplace("c.ogg", "5");
+	values->emplace("mnt/sub/e.ogg", "5");
+	values->emplace(std::string(5000, 'x') + "/f.ogg", "4");
+
+	for (auto *f : filter.GetStickerFilters())
+		f->SetValues(values);
+
+	return filter;
+}
+
+TEST(StickerSongFilter, Compare)
+{
+	auto f = ParseStickerFilter("(sticker:rating >= \"4\")");
+	EXPECT_FALSE(InvokeFilter(f, "a.ogg"));
+	EXPECT_TRUE(InvokeFilter(f, "b.ogg"));
+	EXPECT_TRUE(InvokeFilter(f, "c.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "d.ogg"));
+
+	f = ParseStickerFilter("(sticker:rating < \"4\")");
+	EXPECT_TRUE(InvokeFilter(f, "a.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "b.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "d.ogg"));
+
+	f = ParseStickerFilter("(sticker:rating == \"5\")");
+	EXPECT_FALSE(InvokeFilter(f, "b.ogg"));
+	EXPECT_TRUE(InvokeFilter(f, "c.ogg"));
+
+	f = ParseStickerFilter("(sticker:rating != \"5\")");
+	EXPECT_TRUE(InvokeFilter(f, "b.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "c.ogg"));
+
+	/* songs without this sticker never match */
+	EXPECT_FALSE(InvokeFilter(f, "d.ogg"));
+}
+
+TEST(StickerSongFilter, Nested)
+{
+	auto f = ParseStickerFilter("((title == \"foo\") AND (!(sticker:rating > \"3\")))");
+	EXPECT_TRUE(InvokeFilter(f, "a.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "b.ogg"));
+	EXPECT_TRUE(InvokeFilter(f, "d.ogg"));
+}
+
+TEST(StickerSongFilter, Mount)
+{
+	const auto f = ParseStickerFilter("(sticker:rating >= \"4\")");
+
+	/* songs in a mounted database have URIs relative to the mount
+	   point */
+	const auto mnt = f.WithoutBasePrefix("mnt");
+	EXPECT_FALSE(InvokeFilter(mnt, "b.ogg"));
+	EXPECT_FALSE(InvokeFilter(mnt, "e.ogg"));
+	EXPECT_TRUE(InvokeFilter(mnt, "sub/e.ogg"));
+
+	const auto sub = mnt.WithoutBasePrefix("sub");
+	EXPECT_TRUE(InvokeFilter(sub, "e.ogg"));
+}
+
+TEST(StickerSongFilter, Directory)
+{
+	const auto f = ParseStickerFilter("(sticker:rating >= \"4\")");
+	EXPECT_TRUE(InvokeFilter(f, "mnt/sub", "e.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, "mnt", "e.ogg"));
+
+	const auto mnt = f.WithoutBasePrefix("mnt");
+	EXPECT_TRUE(InvokeFilter(mnt, "sub", "e.ogg"));
+
+	/* longer than the stack buffer in StickerSongFilter::Match() */
+	const std::string long_directory(5000, 'x');
+	EXPECT_TRUE(InvokeFilter(f, long_directory.c_str(), "f.ogg"));
+	EXPECT_FALSE(InvokeFilter(f, long_directory.c_str(), "g.ogg"));
+}
+
+TEST(StickerSongFilter, ToExpression)
+{
+	const auto f = ParseStickerFilter("(sticker:rating >= \"4\")");
+	EXPECT_EQ(f.ToExpression(), "(sticker:rating >= \"4\")");
+}
+
+TEST(StickerSongFilter, NotLoaded)
+{
+	SongFilter f;
+	const char *expression = "(sticker:rating >= \"4\")";
+	f.Parse(ConstBuffer<const char *>(&expression, 1));
+	EXPECT_FALSE(InvokeFilter(f, "b.ogg"));
+}
+
+TEST(StickerSongFilter, ParseError)
+{
+	SongFilter f;
+	const char *expression = "(sticker:rating ~ \"4\")";
+	EXPECT_ANY_THROW(f.Parse(ConstBuffer<const char *>(&expression, 1)));
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "filter/plugins/ThreadedFilterPlugin.hxx"
+#include "filter/Filter.hxx"
+#include "filter/Prepared.hxx"
+#include "pcm/Buffer.hxx"
+#include "util/ConstBuffer.hxx"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+/**
+ * A filter which adds 1 to every byte, and which throws when it sees
+ * the byte 0xff.
+ */
+class IncrementFilter final : public Filter {
+	PcmBuffer buffer;
+
+public:
+	explicit IncrementFilter(AudioFormat af) noexcept:Filter(af) {}
+
+	ConstBuffer<void> FilterPCM(ConstBuffer<void> _src) override {
+		auto src = ConstBuffer<uint8_t>::FromVoid(_src);
+		auto *dest = buffer.GetT<uint8_t>(src.size);
+		for (size_t i = 0; i < src.size; ++i) {
+			if (src[i] == 0xff)
+				throw std::runtime_error("Overflow");
+			dest[i] = src[i] + 1;
+		}
+
+		return {dest, src.size};
+	}
+};
+
+class PreparedIncrementFilter final : public PreparedFilter {
+public:
+	std::unique_ptr<Filter> Open(AudioFormat &af) override {
+		return std::make_unique<IncrementFilter>(af);
+	}
+};
+
+static std::unique_ptr<Filter>
+OpenThreaded()
+{
+	AudioFormat af(44100, SampleFormat::S8, 1);
+	return threaded_filter_new(std::make_unique<PreparedIncrementFilter>())
+		->Open(af);
+}
+
+static std::vector<uint8_t>
+ToVector(ConstBuffer<void> b)
+{
+	auto u = ConstBuffer<uint8_t>::FromVoid(b);
+	return {u.begin(), u.end()};
+}
+
+TEST(ThreadedFilter, Pipeline)
+{
+	auto filter = OpenThreaded();
+
+	const uint8_t a[] = {1, 2, 3}, b[] = {10, 20};
+
+	/* the first call returns nothing, each following call returns
+	   the result of the previous one */
+	EXPECT_TRUE(filter->FilterPCM({a, sizeof(a)}).empty());
+	EXPECT_EQ(ToVector(filter->FilterPCM({b, sizeof(b)})),
+		  (std::vector<uint8_t>{2, 3, 4}));
+
+	/* Flush() returns the last block */
+	EXPECT_EQ(ToVector(filter->Flush()),
+		  (std::vector<uint8_t>{11, 21}));
+	EXPECT_TRUE(filter->Flush().IsNull());
+}
+
+TEST(ThreadedFilter, Reset)
+{
+	auto filter = OpenThreaded();
+
+	const uint8_t a[] = {1, 2, 3};
+	filter->FilterPCM({a, sizeof(a)});
+	filter->Reset();
+	EXPECT_TRUE(filter->Flush().IsNull());
+}
+
+TEST(ThreadedFilter, Error)
+{
+	auto filter = OpenThreaded();
+
+	const uint8_t a[] = {0xff}, b[] = {1};
+	filter->FilterPCM({a, sizeof(a)});
+	EXPECT_THROW(filter->FilterPCM({b, sizeof(b)}), std::runtime_error);
+}
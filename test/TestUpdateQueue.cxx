@@ -0,0 +1,79 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "db/update/Queue.hxx"
+
+#include <gtest/gtest.h>
+
+/* UpdateQueue only compares these pointers, it never dereferences
+   them */
+static char db_buffer, storage_buffer;
+static auto &db = reinterpret_cast<SimpleDatabase &>(db_buffer);
+static auto &storage = reinterpret_cast<Storage &>(storage_buffer);
+
+TEST(UpdateQueue, Merge)
+{
+	UpdateQueue queue;
+
+	EXPECT_EQ(queue.Push(db, storage, "a/b", false, 1, true), 1u);
+	EXPECT_EQ(queue.Push(db, storage, "c", false, 2, true), 1u);
+
+	/* covered by "a/b" */
+	EXPECT_EQ(queue.Push(db, storage, "a/b/d", false, 3, true), 1u);
+
+	/* replaces "a/b" */
+	EXPECT_EQ(queue.Push(db, storage, "a", false, 4, true), 1u);
+
+	/* a different "discard" flag needs a new job */
+	EXPECT_EQ(queue.Push(db, storage, "e", true, 5, true), 5u);
+
+	auto item = queue.Pop();
+	EXPECT_EQ(item.id, 1u);
+	EXPECT_TRUE(item.Covers("a/x"));
+	EXPECT_TRUE(item.Covers("c"));
+	EXPECT_FALSE(item.Covers("e"));
+
+	item = queue.Pop();
+	EXPECT_EQ(item.id, 5u);
+	EXPECT_FALSE(queue.Pop().IsDefined());
+}
+
+TEST(UpdateQueue, NoMerge)
+{
+	UpdateQueue queue;
+
+	/* explicit requests are never merged, not even with
+	   mergeable ones */
+	EXPECT_EQ(queue.Push(db, storage, "a", false, 1), 1u);
+	EXPECT_EQ(queue.Push(db, storage, "b", false, 2), 2u);
+	EXPECT_EQ(queue.Push(db, storage, "c", false, 3, true), 3u);
+	EXPECT_EQ(queue.Push(db, storage, "d", false, 4), 4u);
+	EXPECT_EQ(queue.Push(db, storage, "e", false, 5, true), 3u);
+
+	EXPECT_EQ(queue.Pop().id, 1u);
+	EXPECT_EQ(queue.Pop().id, 2u);
+
+	const auto item = queue.Pop();
+	EXPECT_EQ(item.id, 3u);
+	EXPECT_TRUE(item.Covers("e"));
+	EXPECT_FALSE(item.Covers("d"));
+
+	EXPECT_EQ(queue.Pop().id, 4u);
+	EXPECT_FALSE(queue.Pop().IsDefined());
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Measure the round-trip throughput of an MPD server: open many
+ * connections at the same time and send the same command over each
+ * of them repeatedly.  This can be used to compare server settings
+ * such as "client_threads" and "client_io_uring".
+ */
+
+#include "net/Resolver.hxx"
+#include "net/AddressInfo.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "net/SocketError.hxx"
+#include "util/PrintException.hxx"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+class LineReader {
+	SocketDescriptor fd;
+	std::string buffer;
+
+public:
+	explicit LineReader(SocketDescriptor _fd) noexcept
+		:fd(_fd) {}
+
+	std::string ReadLine() {
+		while (true) {
+			auto newline = buffer.find('\n');
+			if (newline != buffer.npos) {
+				std::string line(buffer, 0, newline);
+				buffer.erase(0, newline + 1);
+				return line;
+			}
+
+			if (fd.WaitReadable(-1) < 0)
+				throw MakeSocketError("Failed to wait");
+
+			char tmp[16384];
+			auto nbytes = fd.Read(tmp, sizeof(tmp));
+			if (nbytes < 0)
+				throw MakeSocketError("Failed to receive");
+			if (nbytes == 0)
+				throw std::runtime_error("Connection closed");
+
+			buffer.append(tmp, nbytes);
+		}
+	}
+};
+
+static void
+SendAll(SocketDescriptor fd, const std::string &s)
+{
+	const char *p = s.data();
+	std::size_t length = s.size();
+
+	while (length > 0) {
+		auto nbytes = fd.Write(p, length);
+		if (nbytes < 0)
+			throw MakeSocketError("Failed to send");
+
+		p += nbytes;
+		length -= nbytes;
+	}
+}
+
+static void
+RunClient(const AddressInfo &address, const std::string &request,
+	  unsigned n_requests)
+{
+	UniqueSocketDescriptor fd;
+	if (!fd.Create(address.GetFamily(), address.GetType(),
+		       address.GetProtocol()))
+		throw MakeSocketError("Failed to create socket");
+
+	if (!fd.Connect(address))
+		throw MakeSocketError("Failed to connect");
+
+	LineReader reader(fd);
+	if (reader.ReadLine().compare(0, 7, "OK MPD ") != 0)
+		throw std::runtime_error("Malformed greeting");
+
+	for (unsigned i = 0; i < n_requests; ++i) {
+		SendAll(fd, request);
+
+		while (true) {
+			const auto line = reader.ReadLine();
+			if (line == "OK")
+				break;
+
+			if (line.compare(0, 4, "ACK ") == 0)
+				throw std::runtime_error(line);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 5) {
+		fprintf(stderr, "Usage: run_client_benchmark HOST[:PORT] [CLIENTS] [REQUESTS] [COMMAND]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned n_clients = argc > 2 ? strtoul(argv[2], nullptr, 10) : 50;
+	const unsigned n_requests = argc > 3 ? strtoul(argv[3], nullptr, 10) : 1000;
+	const std::string request = std::string(argc > 4 ? argv[4] : "ping") + "\n";
+
+	const auto addresses = Resolve(argv[1], 6600, 0, SOCK_STREAM);
+	const auto &address = addresses.front();
+
+	std::atomic_uint n_failed{0};
+	std::vector<std::thread> threads;
+	threads.reserve(n_clients);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < n_clients; ++i)
+		threads.emplace_back([&](){
+			try {
+				RunClient(address, request, n_requests);
+			} catch (...) {
+				PrintException(std::current_exception());
+				++n_failed;
+			}
+		});
+
+	for (auto &i : threads)
+		i.join();
+
+	const std::chrono::duration<double> duration =
+		std::chrono::steady_clock::now() - start;
+	const unsigned n_ok = n_clients - n_failed;
+
+	printf("%u clients, %u requests each: %.3f s, %.0f requests/s\n",
+	       n_ok, n_requests, duration.count(),
+	       n_ok * n_requests / duration.count());
+
+	return n_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
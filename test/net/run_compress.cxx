@@ -0,0 +1,277 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Measure the effect of the "compress" command: send one command
+ * (e.g. "listallinfo") over a plain and over a compressed
+ * connection, verify that both responses are identical and print
+ * the transfer sizes, the compression ratio and the time spent.
+ */
+
+#include "net/Resolver.hxx"
+#include "net/AddressInfo.hxx"
+#include "net/UniqueSocketDescriptor.hxx"
+#include "net/SocketError.hxx"
+#include "lib/zlib/Error.hxx"
+#include "util/PrintException.hxx"
+
+#include <zlib.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using std::string_view_literals::operator""sv;
+
+static double
+GetThreadCpuTime() noexcept
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Does the given text end with a complete "OK" or "ACK" line?
+ */
+static bool
+IsResponseComplete(std::string_view s) noexcept
+{
+	if (s.empty() || s.back() != '\n')
+		return false;
+
+	s.remove_suffix(1);
+	const auto newline = s.rfind('\n');
+	const auto last = newline == s.npos ? s : s.substr(newline + 1);
+	return last == "OK"sv || last.substr(0, 4) == "ACK "sv;
+}
+
+class Inflater {
+	z_stream z{};
+
+public:
+	Inflater() {
+		int result = inflateInit(&z);
+		if (result != Z_OK)
+			throw ZlibError(result);
+	}
+
+	~Inflater() noexcept {
+		inflateEnd(&z);
+	}
+
+	Inflater(const Inflater &) = delete;
+	Inflater &operator=(const Inflater &) = delete;
+
+	void Feed(std::string_view src, std::string &dest) {
+		z.next_in = (Bytef *)const_cast<char *>(src.data());
+		z.avail_in = src.size();
+
+		do {
+			Bytef buffer[65536];
+			z.next_out = buffer;
+			z.avail_out = sizeof(buffer);
+
+			int result = inflate(&z, Z_SYNC_FLUSH);
+			if (result != Z_OK && result != Z_BUF_ERROR)
+				throw ZlibError(result);
+
+			dest.append((const char *)buffer,
+				    z.next_out - buffer);
+		} while (z.avail_in > 0 || z.avail_out == 0);
+	}
+};
+
+class Connection {
+	UniqueSocketDescriptor fd;
+
+	/**
+	 * Received data which has not been consumed yet.
+	 */
+	std::string buffer;
+
+public:
+	explicit Connection(const AddressInfo &address) {
+		if (!fd.Create(address.GetFamily(), address.GetType(),
+			       address.GetProtocol()))
+			throw MakeSocketError("Failed to create socket");
+
+		if (!fd.Connect(address))
+			throw MakeSocketError("Failed to connect");
+
+		if (ReadLine().compare(0, 7, "OK MPD ") != 0)
+			throw std::runtime_error("Malformed greeting");
+	}
+
+	void Send(std::string_view s) {
+		while (!s.empty()) {
+			auto nbytes = fd.Write(s.data(), s.size());
+			if (nbytes < 0)
+				throw MakeSocketError("Failed to send");
+
+			s.remove_prefix(nbytes);
+		}
+	}
+
+	/**
+	 * Receive more data and append it to the given buffer.
+	 *
+	 * @return the number of bytes received
+	 */
+	std::size_t Receive(std::string &dest) {
+		if (fd.WaitReadable(-1) < 0)
+			throw MakeSocketError("Failed to wait");
+
+		char tmp[65536];
+		auto nbytes = fd.Read(tmp, sizeof(tmp));
+		if (nbytes < 0)
+			throw MakeSocketError("Failed to receive");
+		if (nbytes == 0)
+			throw std::runtime_error("Connection closed");
+
+		dest.append(tmp, nbytes);
+		return nbytes;
+	}
+
+	std::string ReadLine() {
+		while (true) {
+			auto newline = buffer.find('\n');
+			if (newline != buffer.npos) {
+				std::string line(buffer, 0, newline);
+				buffer.erase(0, newline + 1);
+				return line;
+			}
+
+			Receive(buffer);
+		}
+	}
+
+	/**
+	 * Receive a plain response.
+	 *
+	 * @return the number of bytes received
+	 */
+	std::size_t ReadResponse(std::string &dest) {
+		std::size_t n = buffer.size();
+		dest.swap(buffer);
+		buffer.clear();
+
+		while (!IsResponseComplete(dest))
+			n += Receive(dest);
+
+		return n;
+	}
+
+	/**
+	 * Receive a compressed response.
+	 *
+	 * @return the number of (compressed) bytes received
+	 */
+	std::size_t ReadCompressedResponse(Inflater &inflater,
+					   std::string &dest,
+					   double &cpu_time) {
+		std::size_t n = buffer.size();
+
+		while (true) {
+			if (!buffer.empty()) {
+				const double start = GetThreadCpuTime();
+				inflater.Feed(buffer, dest);
+				cpu_time += GetThreadCpuTime() - start;
+				buffer.clear();
+			}
+
+			if (IsResponseComplete(dest))
+				return n;
+
+			n += Receive(buffer);
+		}
+	}
+};
+
+static void
+Print(const char *name, std::size_t n_bytes,
+      std::chrono::duration<double> duration) noexcept
+{
+	printf("%-10s %10zu bytes %8.3f s\n",
+	       name, n_bytes, duration.count());
+}
+
+int main(int argc, char **argv)
+try {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: run_compress HOST[:PORT] COMMAND\n");
+		return EXIT_FAILURE;
+	}
+
+	const std::string request = std::string(argv[2]) + "\n";
+
+	const auto addresses = Resolve(argv[1], 6600, 0, SOCK_STREAM);
+	const auto &address = addresses.front();
+
+	std::string plain;
+	std::size_t plain_size;
+
+	{
+		Connection c(address);
+
+		const auto start = std::chrono::steady_clock::now();
+		c.Send(request);
+		plain_size = c.ReadResponse(plain);
+		Print("plain", plain_size,
+		      std::chrono::steady_clock::now() - start);
+	}
+
+	std::string inflated;
+	std::size_t compressed_size;
+	double cpu_time = 0;
+
+	{
+		Connection c(address);
+		c.Send("compress deflate\n");
+		const auto line = c.ReadLine();
+		if (line != "OK")
+			throw std::runtime_error(line);
+
+		Inflater inflater;
+
+		const auto start = std::chrono::steady_clock::now();
+		c.Send(request);
+		compressed_size = c.ReadCompressedResponse(inflater, inflated,
+							   cpu_time);
+		Print("deflate", compressed_size,
+		      std::chrono::steady_clock::now() - start);
+	}
+
+	if (inflated != plain)
+		throw std::runtime_error("Responses differ");
+
+	printf("ratio %.2f, inflate CPU time %.3f s\n",
+	       compressed_size > 0 ? double(plain_size) / compressed_size : 0.,
+	       cpu_time);
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
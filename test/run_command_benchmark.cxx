@@ -0,0 +1,250 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Replay a recorded protocol session through the command parser:
+ * command lists are collected, each command is tokenized and its
+ * name is looked up in MPD's command table with command_lookup().
+ * The commands are not executed.  The old command list
+ * implementation (one std::list node and std::string per command) is
+ * compared with the current one (CommandListBuilder).
+ *
+ * The session file contains the lines which a client has sent, for
+ * example:
+ *
+ *   command_list_begin
+ *   addid "foo/bar.flac"
+ *   command_list_end
+ */
+
+#include "command/AllCommands.hxx"
+#include "command/CommandListBuilder.hxx"
+#include "client/Config.hxx"
+#include "Main.hxx"
+#include "util/Tokenizer.hxx"
+#include "util/PrintException.hxx"
+
+#include <chrono>
+#include <fstream>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Instance *global_instance;
+
+static constexpr unsigned ARGV_MAX = 64;
+
+namespace {
+
+struct Stats {
+	unsigned long commands = 0, arguments = 0, found = 0, errors = 0;
+};
+
+/**
+ * The old command list implementation.
+ */
+class ListBuilder {
+	std::list<std::string> list;
+	bool active = false;
+
+public:
+	bool IsActive() const noexcept {
+		return active;
+	}
+
+	void Begin() noexcept {
+		active = true;
+	}
+
+	void Add(const char *cmd) {
+		list.emplace_back(cmd);
+	}
+
+	template<typename F>
+	void Commit(F &&f) {
+		auto l = std::move(list);
+		list.clear();
+		active = false;
+
+		for (auto &i : l)
+			f(&*i.begin());
+	}
+};
+
+/**
+ * The current command list implementation.
+ */
+class BufferBuilder {
+	CommandListBuilder builder;
+
+public:
+	bool IsActive() const noexcept {
+		return builder.IsActive();
+	}
+
+	void Begin() noexcept {
+		builder.Begin(false);
+	}
+
+	void Add(const char *cmd) {
+		if (!builder.Add(cmd))
+			throw std::runtime_error("Command list too large");
+	}
+
+	template<typename F>
+	void Commit(F &&f) {
+		auto l = builder.Commit();
+		builder.Reset();
+
+		CommandListBuilder::ForEachCommand(l, [&f](char *cmd){
+			f(cmd);
+			return true;
+		});
+	}
+};
+
+}
+
+static void
+ProcessCommand(char *line, Stats &stats) noexcept
+try {
+	Tokenizer tokenizer(line);
+
+	const char *name = tokenizer.NextWord();
+	if (name == nullptr) {
+		++stats.errors;
+		return;
+	}
+
+	unsigned argc = 0;
+	while (argc < ARGV_MAX && tokenizer.NextParam() != nullptr)
+		++argc;
+
+	++stats.commands;
+	stats.arguments += argc;
+	if (command_lookup(name) != nullptr)
+		++stats.found;
+} catch (...) {
+	++stats.errors;
+}
+
+template<typename B>
+static Stats
+Replay(const std::vector<std::string> &session, unsigned repeat)
+{
+	Stats stats;
+	B builder;
+
+	/* a single command is tokenized in the client's input
+	   buffer; this is its replacement */
+	std::string line;
+
+	for (unsigned r = 0; r < repeat; ++r) {
+		for (const auto &i : session) {
+			if (builder.IsActive()) {
+				if (i == "command_list_end")
+					builder.Commit([&](char *cmd){
+						ProcessCommand(cmd, stats);
+					});
+				else
+					builder.Add(i.c_str());
+			} else if (i == "command_list_begin" ||
+				   i == "command_list_ok_begin") {
+				builder.Begin();
+			} else {
+				line = i;
+				ProcessCommand(line.data(), stats);
+			}
+		}
+	}
+
+	return stats;
+}
+
+template<typename B>
+static void
+RunBenchmark(const char *label, const std::vector<std::string> &session,
+	     unsigned repeat)
+{
+	using Clock = std::chrono::steady_clock;
+	using Seconds = std::chrono::duration<double>;
+
+	const auto t0 = Clock::now();
+	const auto stats = Replay<B>(session, repeat);
+	const auto t1 = Clock::now();
+	const double duration = Seconds(t1 - t0).count();
+
+	printf("%-8s %lu commands, %lu arguments, %lu found, %lu errors: "
+	       "%8.3f ms (%.1f ns per command)\n",
+	       label, stats.commands, stats.arguments, stats.found,
+	       stats.errors, duration * 1000,
+	       stats.commands > 0 ? duration * 1e9 / stats.commands : 0.);
+}
+
+static std::vector<std::string>
+LoadSession(const char *path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error(std::string("Failed to open ") + path);
+
+	std::vector<std::string> session;
+	std::string line;
+	while (std::getline(file, line)) {
+		/* strip the CR of files recorded from a socket */
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		if (!line.empty())
+			session.emplace_back(std::move(line));
+	}
+
+	return session;
+}
+
+int
+main(int argc, char **argv)
+try {
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: run_command_benchmark SESSION [REPEAT]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned repeat = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100;
+
+	const auto session = LoadSession(argv[1]);
+
+	/* don't limit the size of recorded command lists */
+	client_max_command_list_size = 64 * 1024 * 1024;
+
+	command_init();
+
+	RunBenchmark<ListBuilder>("list", session, repeat);
+	RunBenchmark<BufferBuilder>("buffer", session, repeat);
+
+	return EXIT_SUCCESS;
+} catch (...) {
+	PrintException(std::current_exception());
+	return EXIT_FAILURE;
+}
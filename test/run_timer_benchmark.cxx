@@ -0,0 +1,223 @@
+/*
+ * Copyright 2003-2021 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Compare the HierarchicalTimerWheel with a sorted multiset, which
+ * is how EventLoop used to manage its FineTimerEvent instances.  The
+ * benchmark simulates many connections with timeouts which are
+ * rescheduled on every request and which rarely expire.
+ */
+
+#include "event/HierarchicalTimerWheel.hxx"
+
+#include <boost/intrusive/set.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using std::chrono::milliseconds;
+
+namespace {
+
+struct WheelTimer final : AutoUnlinkIntrusiveListHook {
+	Event::TimePoint due;
+	unsigned n_fired = 0;
+
+	auto GetDue() const noexcept {
+		return due;
+	}
+
+	void Cancel() noexcept {
+		if (is_linked())
+			unlink();
+	}
+
+	void Run() noexcept {
+		++n_fired;
+	}
+};
+
+class WheelAdapter {
+	HierarchicalTimerWheel<WheelTimer, 1> wheel;
+
+public:
+	using Timer = WheelTimer;
+
+	void Insert(Timer &t) noexcept {
+		wheel.Insert(t);
+	}
+
+	Event::Duration Run(Event::TimePoint now) noexcept {
+		return wheel.Run(now);
+	}
+};
+
+struct SetTimer final
+	: boost::intrusive::set_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>> {
+	Event::TimePoint due;
+	unsigned n_fired = 0;
+
+	void Cancel() noexcept {
+		unlink();
+	}
+};
+
+/**
+ * A copy of the old TimerList implementation.
+ */
+class SetAdapter {
+	struct Compare {
+		bool operator()(const SetTimer &a,
+				const SetTimer &b) const noexcept {
+			return a.due < b.due;
+		}
+	};
+
+	boost::intrusive::multiset<SetTimer,
+				   boost::intrusive::compare<Compare>,
+				   boost::intrusive::constant_time_size<false>> timers;
+
+public:
+	using Timer = SetTimer;
+
+	void Insert(Timer &t) noexcept {
+		timers.insert(t);
+	}
+
+	Event::Duration Run(Event::TimePoint now) noexcept {
+		while (true) {
+			auto i = timers.begin();
+			if (i == timers.end())
+				break;
+
+			auto &t = *i;
+			const auto timeout = t.due - now;
+			if (timeout > timeout.zero())
+				return timeout;
+
+			timers.erase(i);
+			++t.n_fired;
+		}
+
+		return Event::Duration(-1);
+	}
+};
+
+struct Result {
+	double insert, reschedule, run, cancel;
+};
+
+}
+
+template<typename A>
+static Result
+RunBenchmark(unsigned n_timers, unsigned n_reschedules) noexcept
+{
+	using Clock = std::chrono::steady_clock;
+	using Seconds = std::chrono::duration<double>;
+
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<unsigned> timeout_ms(1000, 60000);
+
+	A a;
+	std::vector<typename A::Timer> timers(n_timers);
+
+	Event::TimePoint now{std::chrono::hours(100)};
+	a.Run(now);
+
+	Result result;
+
+	auto t0 = Clock::now();
+	for (auto &t : timers) {
+		t.due = now + milliseconds(timeout_ms(rng));
+		a.Insert(t);
+	}
+	auto t1 = Clock::now();
+	result.insert = Seconds(t1 - t0).count();
+
+	/* each request on a connection reschedules its timeout;
+	   meanwhile, time advances */
+	std::uniform_int_distribution<unsigned> pick(0, n_timers - 1);
+	t0 = Clock::now();
+	for (unsigned i = 0; i < n_reschedules; ++i) {
+		if (i % 1000 == 0) {
+			now += milliseconds(1);
+			a.Run(now);
+		}
+
+		auto &t = timers[pick(rng)];
+		t.Cancel();
+		t.due = now + milliseconds(timeout_ms(rng));
+		a.Insert(t);
+	}
+	t1 = Clock::now();
+	result.reschedule = Seconds(t1 - t0).count();
+
+	/* let half of them expire, running the loop every
+	   millisecond */
+	t0 = Clock::now();
+	const auto end = now + milliseconds(30000);
+	while (now < end) {
+		now += milliseconds(1);
+		a.Run(now);
+	}
+	t1 = Clock::now();
+	result.run = Seconds(t1 - t0).count();
+
+	t0 = Clock::now();
+	for (auto &t : timers)
+		t.Cancel();
+	t1 = Clock::now();
+	result.cancel = Seconds(t1 - t0).count();
+
+	return result;
+}
+
+static void
+Print(const char *name, const Result &r) noexcept
+{
+	printf("%-10s insert %8.3f ms  reschedule %8.3f ms  run %8.3f ms  cancel %8.3f ms\n",
+	       name, r.insert * 1000, r.reschedule * 1000,
+	       r.run * 1000, r.cancel * 1000);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 3) {
+		fprintf(stderr, "Usage: run_timer_benchmark [TIMERS] [RESCHEDULES]\n");
+		return EXIT_FAILURE;
+	}
+
+	const unsigned n_timers = argc > 1 ? strtoul(argv[1], nullptr, 10) : 50000;
+	const unsigned n_reschedules = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000000;
+	if (n_timers == 0) {
+		fprintf(stderr, "No timers\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%u timers, %u reschedules\n", n_timers, n_reschedules);
+	Print("multiset", RunBenchmark<SetAdapter>(n_timers, n_reschedules));
+	Print("wheel", RunBenchmark<WheelAdapter>(n_timers, n_reschedules));
+	return EXIT_SUCCESS;
+}
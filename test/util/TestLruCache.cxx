@@ -0,0 +1,54 @@
+/*
+ * Unit tests for class LruCache.
+ */
+
+#include "util/LruCache.hxx"
+
+#include <gtest/gtest.h>
+
+TEST(LruCache, Basic)
+{
+	LruCache<int, 2> cache;
+	EXPECT_TRUE(cache.empty());
+	EXPECT_EQ(cache.Lookup("a"), nullptr);
+
+	cache.Store("a", 1);
+	cache.Store("b", 2);
+	EXPECT_FALSE(cache.empty());
+	ASSERT_NE(cache.Lookup("a"), nullptr);
+	EXPECT_EQ(*cache.Lookup("a"), 1);
+	ASSERT_NE(cache.Lookup("b"), nullptr);
+	EXPECT_EQ(*cache.Lookup("b"), 2);
+
+	/* replace an existing item */
+	cache.Store("a", 3);
+	ASSERT_NE(cache.Lookup("a"), nullptr);
+	EXPECT_EQ(*cache.Lookup("a"), 3);
+	ASSERT_NE(cache.Lookup("b"), nullptr);
+
+	cache.Remove("b");
+	EXPECT_EQ(cache.Lookup("b"), nullptr);
+	ASSERT_NE(cache.Lookup("a"), nullptr);
+
+	cache.clear();
+	EXPECT_TRUE(cache.empty());
+	EXPECT_EQ(cache.Lookup("a"), nullptr);
+}
+
+TEST(LruCache, Evict)
+{
+	LruCache<int, 2> cache;
+	cache.Store("a", 1);
+	cache.Store("b", 2);
+
+	/* "a" is now the most recently used item */
+	EXPECT_NE(cache.Lookup("a"), nullptr);
+
+	/* this evicts "b" */
+	cache.Store("c", 3);
+	EXPECT_EQ(cache.Lookup("b"), nullptr);
+	ASSERT_NE(cache.Lookup("a"), nullptr);
+	EXPECT_EQ(*cache.Lookup("a"), 1);
+	ASSERT_NE(cache.Lookup("c"), nullptr);
+	EXPECT_EQ(*cache.Lookup("c"), 3);
+}
@@ -0,0 +1,71 @@
+/*
+ * Unit tests for class StringPerfectHash.
+ */
+
+#include "util/StringPerfectHash.hxx"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+static int
+Lookup(const StringPerfectHash<1024> &hash,
+       const std::vector<std::string> &keys, const char *key) noexcept
+{
+	const int i = hash.Find(key);
+	if (i < 0 || keys[i] != key)
+		return -1;
+
+	return i;
+}
+
+TEST(StringPerfectHash, Basic)
+{
+	const std::vector<std::string> keys{
+		"add", "addid", "clear", "command_list_begin",
+		"command_list_end", "currentsong", "delete", "find",
+		"idle", "list", "noidle", "pause", "play", "playlistinfo",
+		"status", "stop",
+	};
+
+	StringPerfectHash<1024> hash;
+	EXPECT_FALSE(hash.IsDefined());
+
+	ASSERT_TRUE(hash.Build(keys.size(), [&keys](std::size_t i){
+		return std::string_view(keys[i]);
+	}));
+	EXPECT_TRUE(hash.IsDefined());
+
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		EXPECT_EQ(Lookup(hash, keys, keys[i].c_str()), int(i));
+
+	EXPECT_EQ(Lookup(hash, keys, ""), -1);
+	EXPECT_EQ(Lookup(hash, keys, "ad"), -1);
+	EXPECT_EQ(Lookup(hash, keys, "addidx"), -1);
+	EXPECT_EQ(Lookup(hash, keys, "Status"), -1);
+}
+
+TEST(StringPerfectHash, Many)
+{
+	std::vector<std::string> keys;
+	for (unsigned i = 0; i < 64; ++i)
+		keys.emplace_back("key" + std::to_string(i));
+
+	StringPerfectHash<1024> hash;
+	ASSERT_TRUE(hash.Build(keys.size(), [&keys](std::size_t i){
+		return std::string_view(keys[i]);
+	}));
+
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		EXPECT_EQ(hash.Find(keys[i]), int(i));
+}
+
+TEST(StringPerfectHash, TooMany)
+{
+	StringPerfectHash<1024> hash;
+	EXPECT_FALSE(hash.Build(hash.MAX_KEYS + 1, [](std::size_t){
+		return std::string_view("x");
+	}));
+	EXPECT_FALSE(hash.IsDefined());
+}